@@ -0,0 +1,178 @@
+/*
+ * cpufreq-task-time: print the CPU time of each process at each CPU speed
+ *
+ * Decodes <debugfs>/cpufreq/task_time, see section 4 of
+ * Documentation/cpu-freq/cpufreq-stats.txt. Needs
+ * CONFIG_CPU_FREQ_TASK_STATS.
+ *
+ * Compile by:
+ *
+ * gcc -o cpufreq-task-time cpufreq-task-time.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <getopt.h>
+
+#define TASK_TIME	"/sys/kernel/debug/cpufreq/task_time"
+#define TASK_TIME_MAGIC	0x43465454
+
+struct header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t nr_states;
+	uint32_t nr_records;
+	uint32_t reserved;
+};
+
+struct snapshot {
+	struct header *hdr;
+	uint32_t *freq;
+	char *records;
+	size_t record_size;
+};
+
+static const char *path = TASK_TIME;
+
+static void *read_file(void)
+{
+	size_t size = 0, alloc = 65536;
+	char *buf = malloc(alloc);
+	ssize_t n;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0 || !buf) {
+		perror(path);
+		exit(1);
+	}
+	while ((n = read(fd, buf + size, alloc - size)) > 0) {
+		size += n;
+		if (size == alloc) {
+			alloc *= 2;
+			buf = realloc(buf, alloc);
+			if (!buf) {
+				perror("realloc");
+				exit(1);
+			}
+		}
+	}
+	if (n < 0) {
+		perror(path);
+		exit(1);
+	}
+	close(fd);
+	return buf;
+}
+
+static void snapshot(struct snapshot *s)
+{
+	char *buf = read_file();
+
+	s->hdr = (struct header *)buf;
+	if (s->hdr->magic != TASK_TIME_MAGIC || s->hdr->version != 1) {
+		fprintf(stderr, "%s: unknown format\n", path);
+		exit(1);
+	}
+	s->freq = (uint32_t *)(s->hdr + 1);
+	s->records = (char *)(s->freq + s->hdr->nr_states);
+	s->record_size = 24 + s->hdr->nr_states * sizeof(uint64_t);
+}
+
+static char *record(struct snapshot *s, unsigned int i)
+{
+	return s->records + i * s->record_size;
+}
+
+static uint32_t tgid_of(char *rec)
+{
+	return *(uint32_t *)rec;
+}
+
+static uint64_t *times_of(char *rec)
+{
+	return (uint64_t *)(rec + 24);
+}
+
+static char *find(struct snapshot *s, uint32_t tgid)
+{
+	unsigned int i;
+
+	for (i = 0; i < s->hdr->nr_records; i++)
+		if (tgid_of(record(s, i)) == tgid)
+			return record(s, i);
+	return NULL;
+}
+
+static void print(struct snapshot *s, struct snapshot *base)
+{
+	unsigned int nr_states = s->hdr->nr_states;
+	unsigned int i, j;
+
+	printf("%5s %5s %-16s", "tgid", "uid", "comm");
+	for (j = 0; j < nr_states && s->freq[j]; j++)
+		printf(" %7ukHz", s->freq[j]);
+	printf("\n");
+
+	for (i = 0; i < s->hdr->nr_records; i++) {
+		char *rec = record(s, i), *old = NULL;
+		uint64_t *t = times_of(rec), sum = 0;
+
+		if (base)
+			old = find(base, tgid_of(rec));
+		for (j = 0; j < nr_states; j++)
+			sum += t[j] - (old ? times_of(old)[j] : 0);
+		if (base && !sum)
+			continue;
+
+		printf("%5u %5u %-16.16s", tgid_of(rec),
+		       *(uint32_t *)(rec + 4), rec + 8);
+		for (j = 0; j < nr_states && s->freq[j]; j++)
+			printf(" %10.3f", (t[j] - (old ? times_of(old)[j] : 0))
+			       / 1e9);
+		printf("\n");
+	}
+}
+
+static void usage(void)
+{
+	printf("Usage: cpufreq-task-time [-d interval] [-f file]\n\n"
+	       "Prints the CPU time in seconds of each process at each CPU\n"
+	       "speed, read from " TASK_TIME ".\n"
+	       "With -d, prints the time taken over interval seconds by the\n"
+	       "processes that ran.\n");
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	struct snapshot base, s;
+	int interval = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "d:f:")) != -1) {
+		switch (c) {
+		case 'd':
+			interval = atoi(optarg);
+			break;
+		case 'f':
+			path = optarg;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (interval < 0)
+		usage();
+
+	if (interval) {
+		snapshot(&base);
+		sleep(interval);
+	}
+	snapshot(&s);
+	print(&s, interval ? &base : NULL);
+	return 0;
+}
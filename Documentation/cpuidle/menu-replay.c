@@ -0,0 +1,287 @@
+/*
+ * menu-replay: replay an idle trace through the menu governor
+ *
+ * Runs a copy of the state selection of drivers/cpuidle/governors/menu.c
+ * over a list of idle periods and prints how often each state was
+ * entered and how often it was left before its target residency, the
+ * hits and misses of /sys/devices/system/cpu/cpuX/cpuidle/stateY. The
+ * states are those of arch/arm/mach-omap2/cpuidle34xx.c. See
+ * Documentation/cpuidle/governor.txt.
+ *
+ * The trace is read from a file or stdin, one idle period per line:
+ *
+ *	<expected_us> <idle_us> [<busy>]
+ *
+ * where expected_us is the time to the next timer event, idle_us the
+ * time the CPU actually stayed idle and busy is 1 when a device was
+ * still active. With -s a synthetic trace is generated instead.
+ *
+ * Compile by:
+ *
+ * gcc -o menu-replay menu-replay.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#define BREAK_FUZZ		4
+#define PRED_HISTORY_PCT	50
+
+#define BUCKETS		6
+#define RESOLUTION	1024
+#define DECAY		4
+#define MAX_INTERESTING	50000
+
+struct state {
+	const char *name;
+	unsigned int exit_latency;
+	unsigned int target_residency;
+	unsigned long long usage;
+	unsigned long long hits;
+	unsigned long long misses;
+	unsigned long long time;
+};
+
+/* valid OMAP3 states, exit latency is sleep + wakeup latency */
+static struct state states[] = {
+	{ "C1", 110 + 162, 5 },
+	{ "C2", 106 + 180, 309 },
+	{ "C5", 855 + 1146, 46057 },
+	{ "C7", 7505 + 15274, 484329 },
+};
+#define NR_STATES	(sizeof(states) / sizeof(states[0]))
+
+struct menu_device {
+	int last_state_idx;
+	unsigned int expected_us;
+	unsigned int predicted_us;
+	unsigned int current_predicted_us;
+	unsigned int last_measured_us;
+	unsigned int elapsed_us;
+	unsigned int corrected_us;
+	int bucket;
+	unsigned int correction_factor[BUCKETS];
+};
+
+static struct menu_device data;
+static int no_correction;
+static int latency_req = 2000000000;
+
+static int which_bucket(unsigned int duration)
+{
+	if (duration < 10)
+		return 0;
+	if (duration < 100)
+		return 1;
+	if (duration < 1000)
+		return 2;
+	if (duration < 10000)
+		return 3;
+	if (duration < 100000)
+		return 4;
+	return 5;
+}
+
+static int menu_select(unsigned int expected_us, int device_not_idle)
+{
+	unsigned int i;
+
+	data.expected_us = expected_us;
+	data.bucket = which_bucket(expected_us);
+	data.corrected_us = ((unsigned long long)expected_us *
+			     data.correction_factor[data.bucket] +
+			     RESOLUTION * DECAY / 2) / (RESOLUTION * DECAY);
+	if (no_correction)
+		data.corrected_us = expected_us;
+
+	if (latency_req == 0) {
+		data.last_state_idx = 0;
+		return 0;
+	}
+
+	data.predicted_us *= PRED_HISTORY_PCT;
+	data.predicted_us += (100 - PRED_HISTORY_PCT) *
+				data.current_predicted_us;
+	data.predicted_us /= 100;
+
+	for (i = 1; i < NR_STATES; i++) {
+		struct state *s = &states[i];
+
+		if (s->target_residency > data.expected_us)
+			break;
+		if (s->target_residency > data.corrected_us)
+			break;
+		if (device_not_idle &&
+		    s->target_residency > data.predicted_us)
+			break;
+		if (s->exit_latency > latency_req)
+			break;
+	}
+
+	data.last_state_idx = i - 1;
+	return i - 1;
+}
+
+static void menu_update(unsigned int measured_us)
+{
+	unsigned int new_factor = data.correction_factor[data.bucket];
+
+	new_factor -= new_factor / DECAY;
+
+	if (data.expected_us > 0 && measured_us < MAX_INTERESTING)
+		new_factor += RESOLUTION * measured_us / data.expected_us;
+	else
+		new_factor += RESOLUTION;
+
+	if (new_factor == 0)
+		new_factor = 1;
+
+	data.correction_factor[data.bucket] = new_factor;
+}
+
+static void menu_reflect(unsigned int last_idle_us)
+{
+	struct state *target = &states[data.last_state_idx];
+	unsigned int measured_us;
+
+	if (last_idle_us >= target->target_residency)
+		target->hits++;
+	else
+		target->misses++;
+
+	if (last_idle_us > target->exit_latency)
+		menu_update(last_idle_us - target->exit_latency);
+	else
+		menu_update(0);
+
+	if (data.elapsed_us <= data.elapsed_us + last_idle_us)
+		measured_us = data.elapsed_us + last_idle_us;
+	else
+		measured_us = -1;
+
+	data.current_predicted_us = measured_us > data.last_measured_us ?
+				    measured_us : data.last_measured_us;
+
+	if (last_idle_us + BREAK_FUZZ <
+	    data.expected_us - target->exit_latency) {
+		data.last_measured_us = measured_us;
+		data.elapsed_us = 0;
+	} else {
+		data.elapsed_us = measured_us;
+	}
+}
+
+static void replay(unsigned int expected_us, unsigned int idle_us, int busy)
+{
+	struct state *s;
+
+	if (idle_us > expected_us)
+		idle_us = expected_us;
+
+	s = &states[menu_select(expected_us, busy)];
+	s->usage++;
+	s->time += idle_us;
+	menu_reflect(idle_us);
+}
+
+static void usage(void)
+{
+	printf("Usage: menu-replay [-n] [-l latency_us] [trace]\n"
+	       "       menu-replay [-n] [-l latency_us] -s periods "
+	       "[-p period_us]\n"
+	       "                   [-i irq_pct] [-r seed]\n\n"
+	       "Replays the idle periods of trace, or of stdin, through the\n"
+	       "menu governor and prints the usage, hits and misses of each\n"
+	       "OMAP3 state. With -s, generates periods idle periods of a\n"
+	       "timer every period_us (7812) of which irq_pct (30) percent\n"
+	       "are cut short at random by an interrupt. -n disables the\n"
+	       "correction factors, -l sets the pm_qos CPU_DMA_LATENCY.\n");
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int period_us = 7812, irq_pct = 30, seed = 1;
+	unsigned long long total = 0, misses = 0;
+	long periods = 0;
+	unsigned int i;
+	int c;
+
+	while ((c = getopt(argc, argv, "nl:s:p:i:r:")) != -1) {
+		switch (c) {
+		case 'n':
+			no_correction = 1;
+			break;
+		case 'l':
+			latency_req = atoi(optarg);
+			break;
+		case 's':
+			periods = atol(optarg);
+			break;
+		case 'p':
+			period_us = atoi(optarg);
+			break;
+		case 'i':
+			irq_pct = atoi(optarg);
+			break;
+		case 'r':
+			seed = atoi(optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (latency_req < 0 || periods < 0 || !period_us || irq_pct > 100)
+		usage();
+
+	for (i = 0; i < BUCKETS; i++)
+		data.correction_factor[i] = RESOLUTION * DECAY;
+
+	if (periods) {
+		srand(seed);
+		while (periods--) {
+			unsigned int idle_us = period_us;
+
+			if (rand() % 100 < irq_pct)
+				idle_us = rand() % period_us;
+			replay(period_us, idle_us, 0);
+		}
+	} else {
+		unsigned int expected_us, idle_us;
+		int busy;
+		char line[128];
+		FILE *f = stdin;
+
+		if (optind < argc) {
+			f = fopen(argv[optind], "r");
+			if (!f) {
+				perror(argv[optind]);
+				return 1;
+			}
+		}
+		while (fgets(line, sizeof(line), f)) {
+			busy = 0;
+			if (sscanf(line, "%u %u %d", &expected_us, &idle_us,
+				   &busy) < 2)
+				continue;
+			replay(expected_us, idle_us, busy);
+		}
+	}
+
+	printf("%-5s %8s %9s %10s %10s %10s %12s\n", "state", "latency",
+	       "residency", "usage", "hits", "misses", "time");
+	for (i = 0; i < NR_STATES; i++) {
+		struct state *s = &states[i];
+
+		printf("%-5s %8u %9u %10llu %10llu %10llu %12llu\n", s->name,
+		       s->exit_latency, s->target_residency, s->usage,
+		       s->hits, s->misses, s->time);
+		total += s->usage;
+		misses += s->misses;
+	}
+	if (total)
+		printf("\n%llu of %llu idle periods (%.1f%%) missed\n", misses,
+		       total, 100.0 * misses / total);
+	return 0;
+}
@@ -0,0 +1,191 @@
+/*
+ * latency-bench: wakeup latency of a periodic task against CPU hogs
+ *
+ * A task sleeps until absolute deadlines every interval and measures how
+ * late it runs, like cyclictest, while CPU-bound children share its CPU.
+ * The latency-nice values of both are set through /proc, see section 5 of
+ * Documentation/scheduler/sched-design-CFS.txt.
+ *
+ * Compile by:
+ *
+ * gcc -o latency-bench latency-bench.c -lrt
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sched.h>
+#include <time.h>
+#include <getopt.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+static int nr_hogs = 4;
+static int interval_us = 1000;
+static int loops = 2000;
+static int cpu = 0;
+static int hog_latency_nice;
+
+static int set_latency_nice(pid_t pid, int latency_nice)
+{
+	char path[64];
+	FILE *f;
+
+	snprintf(path, sizeof(path), "/proc/%d/latency_nice", pid);
+	f = fopen(path, "w");
+	if (!f)
+		return -1;
+	fprintf(f, "%d\n", latency_nice);
+	return fclose(f);
+}
+
+static void pin(void)
+{
+	cpu_set_t set;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set)) {
+		perror("sched_setaffinity");
+		exit(1);
+	}
+}
+
+static pid_t start_hog(void)
+{
+	pid_t pid = fork();
+
+	if (pid < 0) {
+		perror("fork");
+		exit(1);
+	}
+	if (!pid) {
+		volatile unsigned long n = 0;
+
+		if (hog_latency_nice && set_latency_nice(getpid(),
+							 hog_latency_nice))
+			perror("latency_nice");
+		for (;;)
+			n++;
+	}
+	return pid;
+}
+
+static int cmp_long(const void *a, const void *b)
+{
+	long x = *(const long *)a, y = *(const long *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static long ts_diff_us(struct timespec *a, struct timespec *b)
+{
+	return (a->tv_sec - b->tv_sec) * 1000000L +
+		(a->tv_nsec - b->tv_nsec) / 1000;
+}
+
+static void run(int latency_nice)
+{
+	struct timespec next, now;
+	long *lat, sum = 0;
+	int i;
+
+	if (set_latency_nice(getpid(), latency_nice)) {
+		perror("latency_nice");
+		exit(1);
+	}
+	lat = malloc(loops * sizeof(*lat));
+	if (!lat) {
+		perror("malloc");
+		exit(1);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	for (i = 0; i < loops; i++) {
+		next.tv_nsec += interval_us * 1000L;
+		while (next.tv_nsec >= 1000000000L) {
+			next.tv_nsec -= 1000000000L;
+			next.tv_sec++;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		lat[i] = ts_diff_us(&now, &next);
+		sum += lat[i];
+	}
+
+	qsort(lat, loops, sizeof(*lat), cmp_long);
+	printf("%12d %10ld %10ld %10ld %10ld %10ld\n", latency_nice, lat[0],
+	       sum / loops, lat[loops / 2], lat[loops * 99 / 100],
+	       lat[loops - 1]);
+	free(lat);
+}
+
+static void usage(void)
+{
+	printf("Usage: latency-bench [-n hogs] [-i interval_us] [-l loops] "
+	       "[-c cpu]\n"
+	       "                     [-b hog_latency_nice] [latency_nice...]\n\n"
+	       "Pins itself and hogs CPU-bound children to cpu, then wakes up\n"
+	       "loops times every interval_us and prints how late it ran, in\n"
+	       "uS, once for each latency_nice value given (0 and -20 by\n"
+	       "default; negative values need CAP_SYS_NICE).\n");
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	static int default_values[] = { 0, -20 };
+	pid_t *hogs;
+	int c, i;
+
+	while ((c = getopt(argc, argv, "n:i:l:c:b:")) != -1) {
+		switch (c) {
+		case 'n':
+			nr_hogs = atoi(optarg);
+			break;
+		case 'i':
+			interval_us = atoi(optarg);
+			break;
+		case 'l':
+			loops = atoi(optarg);
+			break;
+		case 'c':
+			cpu = atoi(optarg);
+			break;
+		case 'b':
+			hog_latency_nice = atoi(optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (nr_hogs < 0 || interval_us < 1 || loops < 1)
+		usage();
+
+	pin();
+	hogs = calloc(nr_hogs, sizeof(*hogs));
+	if (nr_hogs && !hogs) {
+		perror("calloc");
+		return 1;
+	}
+	for (i = 0; i < nr_hogs; i++)
+		hogs[i] = start_hog();
+
+	printf("%12s %10s %10s %10s %10s %10s\n", "latency_nice", "min",
+	       "avg", "median", "p99", "max");
+	if (optind < argc) {
+		for (i = optind; i < argc; i++)
+			run(atoi(argv[i]));
+	} else {
+		for (i = 0; i < 2; i++)
+			run(default_values[i]);
+	}
+
+	for (i = 0; i < nr_hogs; i++) {
+		kill(hogs[i], SIGKILL);
+		waitpid(hogs[i], NULL, 0);
+	}
+	return 0;
+}
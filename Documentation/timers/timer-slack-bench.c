@@ -0,0 +1,194 @@
+/*
+ * timer-slack-bench: count timer wakeups of periodic tasks with and
+ * without timer slack
+ *
+ * Starts tasks that each sleep for the same interval from a random
+ * phase, as uncoordinated background tasks do, and counts the timer
+ * interrupts taken while they run: once with the default slack and once
+ * with the slack set through PR_SET_TIMERSLACK_PID. See
+ * Documentation/timers/timer-slack.txt.
+ *
+ * Compile by:
+ *
+ * gcc -o timer-slack-bench timer-slack-bench.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <poll.h>
+#include <getopt.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include <sys/epoll.h>
+
+#ifndef PR_SET_TIMERSLACK_PID
+#define PR_SET_TIMERSLACK_PID	31
+#endif
+
+static int nr_tasks = 8;
+static int interval_ms = 100;
+static int seconds = 10;
+static unsigned long slack_ns = 40000000;
+static const char *mode = "nanosleep";
+static const char *irq_name = "timer";
+
+/* Sum of the counts of the interrupts whose name contains irq_name */
+static unsigned long long timer_irqs(void)
+{
+	unsigned long long sum = 0;
+	char line[1024];
+	FILE *f;
+
+	f = fopen("/proc/interrupts", "r");
+	if (!f) {
+		perror("/proc/interrupts");
+		exit(1);
+	}
+	while (fgets(line, sizeof(line), f)) {
+		char *p = strchr(line, ':');
+
+		if (!p || !strstr(p, irq_name))
+			continue;
+		for (p++;;) {
+			char *end;
+			unsigned long long n = strtoull(p, &end, 10);
+
+			if (end == p)
+				break;
+			sum += n;
+			p = end;
+		}
+	}
+	fclose(f);
+	return sum;
+}
+
+static void task(void)
+{
+	struct timespec ts;
+	int epfd = -1;
+
+	if (!strcmp(mode, "epoll")) {
+		epfd = epoll_create(1);
+		if (epfd < 0) {
+			perror("epoll_create");
+			exit(1);
+		}
+	}
+
+	/* start at a random phase of the interval */
+	srand(getpid());
+	usleep(rand() % (interval_ms * 1000));
+
+	for (;;) {
+		if (!strcmp(mode, "poll")) {
+			poll(NULL, 0, interval_ms);
+		} else if (epfd >= 0) {
+			struct epoll_event ev;
+
+			epoll_wait(epfd, &ev, 1, interval_ms);
+		} else {
+			ts.tv_sec = interval_ms / 1000;
+			ts.tv_nsec = (interval_ms % 1000) * 1000000L;
+			nanosleep(&ts, NULL);
+		}
+	}
+}
+
+static void run(unsigned long slack)
+{
+	unsigned long long before, after;
+	pid_t *pids;
+	int i;
+
+	pids = calloc(nr_tasks, sizeof(*pids));
+	if (!pids) {
+		perror("calloc");
+		exit(1);
+	}
+	for (i = 0; i < nr_tasks; i++) {
+		pids[i] = fork();
+		if (pids[i] < 0) {
+			perror("fork");
+			exit(1);
+		}
+		if (!pids[i])
+			task();
+		if (prctl(PR_SET_TIMERSLACK_PID, slack, pids[i], 0, 0)) {
+			perror("PR_SET_TIMERSLACK_PID");
+			exit(1);
+		}
+	}
+
+	/* let the tasks reach their first sleep */
+	sleep(1);
+	before = timer_irqs();
+	sleep(seconds);
+	after = timer_irqs();
+
+	for (i = 0; i < nr_tasks; i++) {
+		kill(pids[i], SIGKILL);
+		waitpid(pids[i], NULL, 0);
+	}
+	free(pids);
+
+	printf("%12lu %12llu %12.1f\n", slack, after - before,
+	       (double)(after - before) / seconds);
+}
+
+static void usage(void)
+{
+	printf("Usage: timer-slack-bench [-n tasks] [-i interval_ms] "
+	       "[-t seconds]\n"
+	       "                         [-s slack_ns] "
+	       "[-m nanosleep|poll|epoll] [-p irq]\n\n"
+	       "Runs tasks sleeping interval_ms in a loop for seconds, once\n"
+	       "with the default timer slack and once with slack_ns (40ms),\n"
+	       "and prints the interrupts counted in /proc/interrupts under\n"
+	       "a name containing irq (\"timer\"). epoll sleeps on the timer\n"
+	       "wheel, nanosleep and poll on hrtimers.\n");
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	int c;
+
+	while ((c = getopt(argc, argv, "n:i:t:s:m:p:")) != -1) {
+		switch (c) {
+		case 'n':
+			nr_tasks = atoi(optarg);
+			break;
+		case 'i':
+			interval_ms = atoi(optarg);
+			break;
+		case 't':
+			seconds = atoi(optarg);
+			break;
+		case 's':
+			slack_ns = strtoul(optarg, NULL, 0);
+			break;
+		case 'm':
+			mode = optarg;
+			break;
+		case 'p':
+			irq_name = optarg;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (nr_tasks < 1 || interval_ms < 1 || seconds < 1 ||
+	    (strcmp(mode, "nanosleep") && strcmp(mode, "poll") &&
+	     strcmp(mode, "epoll")))
+		usage();
+
+	printf("%12s %12s %12s\n", "slack_ns", "wakeups", "wakeups/s");
+	run(0);
+	run(slack_ns);
+	return 0;
+}
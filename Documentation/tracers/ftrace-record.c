@@ -0,0 +1,238 @@
+/*
+ * ftrace-record: record the ftrace ring buffers in binary with splice
+ *
+ * Moves the pages of tracing/per_cpu/cpuN/trace_pipe_raw into one file
+ * per CPU with splice(2), without copying or formatting the events, and
+ * decodes such a file again. Recording stops once tracing is disabled
+ * and the buffers are drained. See the trace_pipe_raw section of
+ * Documentation/ftrace.txt.
+ *
+ * Compile by:
+ *
+ * gcc -o ftrace-record ftrace-record.c
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <getopt.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#define SPLICE_PAGES	16
+
+/* layout of the pages, see kernel/trace/ring_buffer.c */
+struct page_header {
+	unsigned long long	time_stamp;
+	long			commit;
+	unsigned char		data[];
+};
+
+struct event {
+	unsigned int		type:2, len:3, time_delta:27;
+	unsigned int		array[];
+};
+
+enum {
+	TYPE_PADDING,
+	TYPE_TIME_EXTEND,
+	TYPE_TIME_STAMP,
+	TYPE_DATA,
+};
+
+#define TS_SHIFT	27
+
+/* start of the entries of kernel/trace/trace.h */
+struct trace_entry {
+	unsigned char		type;
+	unsigned char		cpu;
+	unsigned char		flags;
+	unsigned char		preempt_count;
+	int			pid;
+};
+
+static const char *tracing_dir = "/debug/tracing";
+static const char *prefix = "trace.cpu";
+
+static void record_cpu(int cpu)
+{
+	char path[256];
+	int in, out, p[2];
+	long pagesize = sysconf(_SC_PAGESIZE);
+	ssize_t n;
+
+	snprintf(path, sizeof(path), "%s/per_cpu/cpu%d/trace_pipe_raw",
+		 tracing_dir, cpu);
+	in = open(path, O_RDONLY);
+	if (in < 0) {
+		perror(path);
+		exit(1);
+	}
+
+	snprintf(path, sizeof(path), "%s%d", prefix, cpu);
+	out = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (out < 0) {
+		perror(path);
+		exit(1);
+	}
+
+	if (pipe(p)) {
+		perror("pipe");
+		exit(1);
+	}
+
+	for (;;) {
+		/* the pipe is empty, so all the pages taken fit into it */
+		n = splice(in, NULL, p[1], NULL, SPLICE_PAGES * pagesize,
+			   SPLICE_F_MOVE);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("splice from trace_pipe_raw");
+			exit(1);
+		}
+		if (!n)
+			break;
+
+		while (n > 0) {
+			ssize_t r = splice(p[0], NULL, out, NULL, n,
+					   SPLICE_F_MOVE);
+
+			if (r <= 0) {
+				perror("splice to file");
+				exit(1);
+			}
+			n -= r;
+		}
+	}
+	exit(0);
+}
+
+static int record(void)
+{
+	int cpu, cpus = sysconf(_SC_NPROCESSORS_CONF);
+	int status, ret = 0;
+
+	for (cpu = 0; cpu < cpus; cpu++) {
+		pid_t pid = fork();
+
+		if (pid < 0) {
+			perror("fork");
+			return 1;
+		}
+		if (!pid)
+			record_cpu(cpu);
+	}
+
+	while (wait(&status) > 0)
+		if (!WIFEXITED(status) || WEXITSTATUS(status))
+			ret = 1;
+	return ret;
+}
+
+static int decode(const char *file)
+{
+	long pagesize = sysconf(_SC_PAGESIZE);
+	unsigned long long ts, pages = 0, events = 0;
+	struct page_header *page;
+	int fd;
+
+	fd = open(file, O_RDONLY);
+	if (fd < 0) {
+		perror(file);
+		return 1;
+	}
+	page = malloc(pagesize);
+	if (!page) {
+		perror("malloc");
+		return 1;
+	}
+
+	while (read(fd, page, pagesize) == pagesize) {
+		long pos = 0;
+
+		pages++;
+		ts = page->time_stamp;
+		while (pos < page->commit) {
+			struct event *e = (void *)(page->data + pos);
+			struct trace_entry *t;
+			unsigned int len;
+
+			switch (e->type) {
+			case TYPE_TIME_EXTEND:
+				ts += ((unsigned long long)e->array[0]
+				       << TS_SHIFT) + e->time_delta;
+				pos += 8;
+				continue;
+			case TYPE_TIME_STAMP:
+				pos += 16;
+				continue;
+			case TYPE_DATA:
+				break;
+			default:
+				fprintf(stderr, "%s: bad event in page %llu\n",
+					file, pages);
+				return 1;
+			}
+
+			ts += e->time_delta;
+			if (e->len) {
+				len = e->len << 2;
+				t = (void *)e->array;
+			} else {
+				len = e->array[0];
+				t = (void *)&e->array[1];
+			}
+			printf("%llu.%06llu type %3u pid %6d\n",
+			       ts / 1000000000ULL, ts % 1000000000ULL / 1000,
+			       t->type, t->pid);
+			pos += len + sizeof(*e);
+			events++;
+		}
+	}
+	fprintf(stderr, "%llu events in %llu pages\n", events, pages);
+	close(fd);
+	return 0;
+}
+
+static void usage(void)
+{
+	printf("Usage: ftrace-record [-t tracing_dir] [-o prefix]\n"
+	       "       ftrace-record -r file\n\n"
+	       "Records the buffer of each CPU N into prefixN (trace.cpuN)\n"
+	       "until tracing is disabled, reading tracing_dir\n"
+	       "(/debug/tracing). -r prints the time stamp, entry type and\n"
+	       "pid of each event of a recorded file.\n");
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	const char *file = NULL;
+	int c;
+
+	while ((c = getopt(argc, argv, "t:o:r:")) != -1) {
+		switch (c) {
+		case 't':
+			tracing_dir = optarg;
+			break;
+		case 'o':
+			prefix = optarg;
+			break;
+		case 'r':
+			file = optarg;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (optind < argc)
+		usage();
+
+	if (file)
+		return decode(file);
+	return record();
+}
@@ -0,0 +1,181 @@
+/*
+ * mem_notify-test: generate memory pressure and record /dev/mem_notify
+ * notifications and their latency
+ *
+ * See Documentation/vm/mem_notify.txt. Needs CONFIG_MEM_NOTIFY.
+ *
+ * Compile by:
+ *
+ * gcc -o mem_notify-test mem_notify-test.c -lrt
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <getopt.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define DEVICE		"/dev/mem_notify"
+#define NR_LEVELS	4
+
+static const char *levels[NR_LEVELS] = { "none", "low", "medium", "critical" };
+
+static int step_mb = 1;
+static int interval_ms = 10;
+static int max_mb = 0;
+static int seconds = 30;
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long mem_free_kb(void)
+{
+	FILE *f = fopen("/proc/meminfo", "r");
+	char line[128];
+	long kb = -1;
+
+	if (!f)
+		return -1;
+	while (fgets(line, sizeof(line), f))
+		if (sscanf(line, "MemFree: %ld kB", &kb) == 1)
+			break;
+	fclose(f);
+	return kb;
+}
+
+/* Allocates and dirties @step_mb every @interval_ms, counting in @allocated */
+static void hog(volatile int *allocated)
+{
+	while (!max_mb || *allocated < max_mb) {
+		char *p = malloc(step_mb << 20);
+
+		if (!p)
+			break;
+		memset(p, 0x5a, step_mb << 20);
+		*allocated += step_mb;
+		usleep(interval_ms * 1000);
+	}
+	pause();
+	exit(0);
+}
+
+static void usage(void)
+{
+	printf("Usage: mem_notify-test [-s step_mb] [-i interval_ms] "
+	       "[-m max_mb] [-t seconds]\n\n"
+	       "Forks a child which allocates and dirties step_mb of memory\n"
+	       "every interval_ms (up to max_mb, 0 meaning until it fails),\n"
+	       "and prints every notification from " DEVICE " with the time\n"
+	       "it took to arrive, for the given number of seconds.\n");
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	int count[NR_LEVELS] = { 0 };
+	double max_lat[NR_LEVELS] = { 0 }, sum_lat[NR_LEVELS] = { 0 };
+	volatile int *allocated;
+	struct pollfd pfd;
+	double start;
+	pid_t pid;
+	int c, i;
+
+	while ((c = getopt(argc, argv, "s:i:m:t:")) != -1) {
+		switch (c) {
+		case 's':
+			step_mb = atoi(optarg);
+			break;
+		case 'i':
+			interval_ms = atoi(optarg);
+			break;
+		case 'm':
+			max_mb = atoi(optarg);
+			break;
+		case 't':
+			seconds = atoi(optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (step_mb < 1 || interval_ms < 0 || seconds < 1)
+		usage();
+
+	pfd.fd = open(DEVICE, O_RDONLY);
+	if (pfd.fd < 0) {
+		perror(DEVICE);
+		return 1;
+	}
+	pfd.events = POLLIN;
+
+	allocated = mmap(NULL, sizeof(int), PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (allocated == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		return 1;
+	}
+	if (pid == 0)
+		hog(allocated);
+
+	start = now();
+	printf("%9s %-8s %12s %10s %12s\n", "time_s", "level", "latency_us",
+	       "alloc_mb", "free_kb");
+	while (now() - start < seconds) {
+		char line[64], name[16];
+		unsigned long sec, nsec;
+		double lat;
+
+		if (poll(&pfd, 1, 100) <= 0)
+			continue;
+		if (read(pfd.fd, line, sizeof(line) - 1) <= 0)
+			break;
+		lat = now();
+		if (sscanf(line, "%15s %lu.%lu", name, &sec, &nsec) != 3)
+			continue;
+		lat -= sec + nsec / 1e9;
+
+		for (i = 0; i < NR_LEVELS; i++)
+			if (!strcmp(name, levels[i]))
+				break;
+		if (i == NR_LEVELS)
+			continue;
+		count[i] += 1;
+		sum_lat[i] += lat;
+		if (lat > max_lat[i])
+			max_lat[i] = lat;
+
+		printf("%9.3f %-8s %12.0f %10d %12ld\n", now() - start, name,
+		       lat * 1e6, *allocated, mem_free_kb());
+		fflush(stdout);
+
+		if (waitpid(pid, NULL, WNOHANG) == pid)
+			break;
+	}
+	kill(pid, SIGKILL);
+	waitpid(pid, NULL, 0);
+
+	printf("\n%-8s %6s %14s %14s\n", "level", "count", "avg_latency_us",
+	       "max_latency_us");
+	for (i = 0; i < NR_LEVELS; i++)
+		printf("%-8s %6d %14.0f %14.0f\n", levels[i], count[i],
+		       count[i] ? sum_lat[i] / count[i] * 1e6 : 0,
+		       max_lat[i] * 1e6);
+	return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * pagecache-pin: pin files or file ranges into the page cache
+ *
+ * See Documentation/vm/pagecache-pin.txt. Needs CONFIG_PAGECACHE_PIN.
+ *
+ * Compile by:
+ *
+ * gcc -o pagecache-pin pagecache-pin.c
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#define PINS_FILE	"/proc/pagecache_pins"
+
+#ifndef POSIX_FADV_PIN
+#define POSIX_FADV_PIN		9
+#define POSIX_FADV_UNPIN	10
+#endif
+
+static void usage(void)
+{
+	printf("Usage: pagecache-pin pin|unpin <file>[:offset:len]...\n"
+	       "       pagecache-pin list|clear\n\n"
+	       "pin and unpin take whole files, or ranges given in bytes.\n"
+	       "list shows the pinned ranges, clear unpins all of them.\n");
+	exit(1);
+}
+
+/* Pins or unpins "file" or "file:offset:len" */
+static int do_file(char *arg, int advice)
+{
+	long long offset = 0, len = 0;
+	char *colon = strchr(arg, ':');
+	int fd, err;
+
+	if (colon) {
+		*colon = '\0';
+		if (sscanf(colon + 1, "%lli:%lli", &offset, &len) != 2) {
+			fprintf(stderr, "%s: bad range\n", arg);
+			return 1;
+		}
+	}
+
+	fd = open(arg, O_RDONLY);
+	if (fd < 0) {
+		perror(arg);
+		return 1;
+	}
+	err = posix_fadvise(fd, offset, len, advice);
+	close(fd);
+	if (err) {
+		fprintf(stderr, "%s: %s\n", arg, strerror(err));
+		return 1;
+	}
+	return 0;
+}
+
+static int list(void)
+{
+	FILE *f = fopen(PINS_FILE, "r");
+	char line[256];
+
+	if (!f) {
+		perror(PINS_FILE);
+		return 1;
+	}
+	while (fgets(line, sizeof(line), f))
+		fputs(line, stdout);
+	fclose(f);
+	return 0;
+}
+
+static int clear(void)
+{
+	int fd = open(PINS_FILE, O_WRONLY);
+
+	if (fd < 0 || write(fd, "clear\n", 6) != 6) {
+		perror(PINS_FILE);
+		return 1;
+	}
+	close(fd);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int i, advice, ret = 0;
+
+	if (argc < 2)
+		usage();
+
+	if (!strcmp(argv[1], "list"))
+		return list();
+	if (!strcmp(argv[1], "clear"))
+		return clear();
+	if (!strcmp(argv[1], "pin"))
+		advice = POSIX_FADV_PIN;
+	else if (!strcmp(argv[1], "unpin"))
+		advice = POSIX_FADV_UNPIN;
+	else
+		usage();
+	if (argc < 3)
+		usage();
+
+	for (i = 2; i < argc; i++)
+		ret |= do_file(argv[i], advice);
+	return ret;
+}
@@ -0,0 +1,195 @@
+/*
+ * prezero-bench: measure anonymous page fault latency with and without the
+ * pool of pre-zeroed pages
+ *
+ * See Documentation/vm/prezero.txt. Needs CONFIG_PREZERO_PAGES.
+ *
+ * Compile by:
+ *
+ * gcc -o prezero-bench prezero-bench.c -lrt
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <getopt.h>
+#include <sys/mman.h>
+
+#define PREZERO_PAGES	"/proc/sys/vm/prezero_pages"
+
+struct counters {
+	unsigned long fill, hit, miss, drain;
+};
+
+static int size_kb = 512;
+static int rounds = 10;
+static int idle_ms = 200;
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void read_counters(struct counters *c)
+{
+	FILE *f = fopen("/proc/vmstat", "r");
+	char name[64];
+	unsigned long v;
+
+	memset(c, 0, sizeof(*c));
+	if (!f)
+		return;
+	while (fscanf(f, "%63s %lu", name, &v) == 2) {
+		if (!strcmp(name, "prezero_fill"))
+			c->fill = v;
+		else if (!strcmp(name, "prezero_hit"))
+			c->hit = v;
+		else if (!strcmp(name, "prezero_miss"))
+			c->miss = v;
+		else if (!strcmp(name, "prezero_drain"))
+			c->drain = v;
+	}
+	fclose(f);
+}
+
+static int read_pool_size(void)
+{
+	FILE *f = fopen(PREZERO_PAGES, "r");
+	int n = -1;
+
+	if (f) {
+		if (fscanf(f, "%d", &n) != 1)
+			n = -1;
+		fclose(f);
+	}
+	return n;
+}
+
+static int write_pool_size(int n)
+{
+	FILE *f = fopen(PREZERO_PAGES, "w");
+
+	if (!f)
+		return -1;
+	fprintf(f, "%d\n", n);
+	return fclose(f);
+}
+
+/*
+ * Faults in a fresh anonymous mapping of @size_kb, one write per page, and
+ * returns the average time per fault in ns.
+ */
+static double fault_round(long page_size)
+{
+	long i, pages = size_kb * 1024L / page_size;
+	double t;
+	char *p;
+
+	p = mmap(NULL, pages * page_size, PROT_READ | PROT_WRITE,
+		 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED) {
+		perror("mmap");
+		exit(1);
+	}
+	t = now();
+	for (i = 0; i < pages; i++)
+		p[i * page_size] = 1;
+	t = now() - t;
+	munmap(p, pages * page_size);
+	return t * 1e9 / pages;
+}
+
+static void run(const char *label, long page_size)
+{
+	struct counters before, after;
+	double sum = 0, min = 0, max = 0;
+	int i;
+
+	read_counters(&before);
+	for (i = 0; i < rounds; i++) {
+		double ns;
+
+		/* Give the idle loop time to refill the pool */
+		usleep(idle_ms * 1000);
+		ns = fault_round(page_size);
+		sum += ns;
+		if (!i || ns < min)
+			min = ns;
+		if (ns > max)
+			max = ns;
+	}
+	read_counters(&after);
+
+	printf("%-8s %10.0f %10.0f %10.0f %10lu %10lu %10lu\n", label,
+	       sum / rounds, min, max, after.hit - before.hit,
+	       after.miss - before.miss, after.fill - before.fill);
+}
+
+static void usage(void)
+{
+	printf("Usage: prezero-bench [-s size_kb] [-r rounds] [-i idle_ms] "
+	       "[-c]\n\n"
+	       "Faults in size_kb of fresh anonymous memory, rounds times,\n"
+	       "sleeping idle_ms before each round so that the pool can be\n"
+	       "refilled, and prints the time per fault in ns along with the\n"
+	       "pool hits, misses and idle fills it took. With -c, the same\n"
+	       "is done with " PREZERO_PAGES " set to 0 for comparison\n"
+	       "(needs root).\n");
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	long page_size = sysconf(_SC_PAGESIZE);
+	int compare = 0;
+	int c, pool;
+
+	while ((c = getopt(argc, argv, "s:r:i:c")) != -1) {
+		switch (c) {
+		case 's':
+			size_kb = atoi(optarg);
+			break;
+		case 'r':
+			rounds = atoi(optarg);
+			break;
+		case 'i':
+			idle_ms = atoi(optarg);
+			break;
+		case 'c':
+			compare = 1;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (size_kb < 1 || rounds < 1 || idle_ms < 0)
+		usage();
+
+	pool = read_pool_size();
+	if (pool < 0) {
+		perror(PREZERO_PAGES);
+		return 1;
+	}
+	if (pool * page_size / 1024 < size_kb)
+		printf("note: %d kB is larger than the pool (%ld kB)\n",
+		       size_kb, pool * page_size / 1024);
+
+	printf("%-8s %10s %10s %10s %10s %10s %10s\n", "pool", "avg_ns",
+	       "min_ns", "max_ns", "hits", "misses", "fills");
+	run("on", page_size);
+
+	if (compare) {
+		if (write_pool_size(0)) {
+			perror(PREZERO_PAGES);
+			return 1;
+		}
+		run("off", page_size);
+		write_pool_size(pool);
+	}
+	return 0;
+}
@@ -0,0 +1,225 @@
+/*
+ * readahead-trace: record, replay and benchmark page cache readahead traces
+ *
+ * See Documentation/vm/readahead-trace.txt. Needs CONFIG_READAHEAD_TRACE.
+ *
+ * Compile by:
+ *
+ * gcc -o readahead-trace readahead-trace.c
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <ftw.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define TRACE_FILE	"/proc/readahead_trace"
+#define DROP_CACHES	"/proc/sys/vm/drop_caches"
+
+#ifndef POSIX_FADV_WILLNEED_TRACE
+#define POSIX_FADV_WILLNEED_TRACE 8
+#endif
+
+struct traced_file {
+	unsigned int major, minor;
+	unsigned long ino;
+};
+
+static struct traced_file *files;
+static int nr_files;
+static int replayed;
+
+static void fatal(const char *x)
+{
+	perror(x);
+	exit(1);
+}
+
+static void write_file(const char *path, const char *s)
+{
+	int fd = open(path, O_WRONLY);
+
+	if (fd < 0 || write(fd, s, strlen(s)) != (ssize_t)strlen(s))
+		fatal(path);
+	close(fd);
+}
+
+static void drop_caches(void)
+{
+	sync();
+	write_file(DROP_CACHES, "3\n");
+}
+
+/* Reads the list of traced files from the kernel */
+static void load_trace(void)
+{
+	FILE *f = fopen(TRACE_FILE, "r");
+	char line[128];
+
+	if (!f)
+		fatal(TRACE_FILE);
+
+	nr_files = 0;
+	while (fgets(line, sizeof(line), f)) {
+		struct traced_file t;
+
+		if (line[0] == '#' ||
+		    sscanf(line, "%u:%u %lu", &t.major, &t.minor, &t.ino) != 3)
+			continue;
+		/* Extents of one file are listed together */
+		if (nr_files && files[nr_files - 1].ino == t.ino &&
+		    files[nr_files - 1].major == t.major &&
+		    files[nr_files - 1].minor == t.minor)
+			continue;
+		files = realloc(files, (nr_files + 1) * sizeof(*files));
+		if (!files)
+			fatal("realloc");
+		files[nr_files++] = t;
+	}
+	fclose(f);
+}
+
+static int is_traced(const struct stat *st)
+{
+	int i;
+
+	for (i = 0; i < nr_files; i++)
+		if (files[i].ino == st->st_ino &&
+		    files[i].major == major(st->st_dev) &&
+		    files[i].minor == minor(st->st_dev))
+			return 1;
+	return 0;
+}
+
+static int replay_one(const char *path, const struct stat *st, int type,
+		      struct FTW *ftw)
+{
+	int fd;
+
+	if (type != FTW_F || !S_ISREG(st->st_mode) || !is_traced(st))
+		return 0;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	if (posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED_TRACE) == 0)
+		replayed++;
+	close(fd);
+	return 0;
+}
+
+/* Replays the trace for all traced files found below @dirs */
+static void replay(char **dirs, int n)
+{
+	int i;
+
+	load_trace();
+	replayed = 0;
+	for (i = 0; i < n; i++)
+		nftw(dirs[i], replay_one, 16, FTW_PHYS | FTW_MOUNT);
+}
+
+static double now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* Runs @argv and returns the number of major faults it took */
+static long run(char **argv, double *secs)
+{
+	struct rusage ru;
+	double t = now();
+	int status;
+	pid_t pid;
+
+	pid = fork();
+	if (pid < 0)
+		fatal("fork");
+	if (pid == 0) {
+		execvp(argv[0], argv);
+		fatal(argv[0]);
+	}
+	if (wait4(pid, &status, 0, &ru) < 0)
+		fatal("wait4");
+	*secs = now() - t;
+	return ru.ru_majflt;
+}
+
+static void usage(void)
+{
+	printf("Usage: readahead-trace start|stop|clear\n"
+	       "       readahead-trace replay <dir>...\n"
+	       "       readahead-trace bench <dir>... -- <command> [args]\n\n"
+	       "start/stop/clear control recording, the trace itself is read\n"
+	       "from and loaded into " TRACE_FILE ".\n"
+	       "replay reads in the recorded pages of all traced files found\n"
+	       "below the directories.\n"
+	       "bench runs the command cold while recording a trace, then cold\n"
+	       "again after replaying the trace, and reports major faults and\n"
+	       "time of both runs.\n");
+	exit(1);
+}
+
+static void bench(int argc, char **argv)
+{
+	double t1, t2, tr;
+	long f1, f2;
+	int ndirs;
+
+	for (ndirs = 0; ndirs < argc; ndirs++)
+		if (!strcmp(argv[ndirs], "--"))
+			break;
+	if (ndirs == 0 || ndirs + 1 >= argc)
+		usage();
+
+	write_file(TRACE_FILE, "clear\n");
+	drop_caches();
+	write_file(TRACE_FILE, "start\n");
+	f1 = run(argv + ndirs + 1, &t1);
+	write_file(TRACE_FILE, "stop\n");
+
+	drop_caches();
+	tr = now();
+	replay(argv, ndirs);
+	tr = now() - tr;
+	f2 = run(argv + ndirs + 1, &t2);
+
+	printf("traced files: %d, replayed: %d\n", nr_files, replayed);
+	printf("cold:   %6ld major faults, %.3f s\n", f1, t1);
+	printf("replay: %6ld major faults, %.3f s (+%.3f s replay)\n",
+	       f2, t2, tr);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+		usage();
+
+	if (!strcmp(argv[1], "start") || !strcmp(argv[1], "stop") ||
+	    !strcmp(argv[1], "clear")) {
+		char cmd[16];
+
+		snprintf(cmd, sizeof(cmd), "%s\n", argv[1]);
+		write_file(TRACE_FILE, cmd);
+	} else if (!strcmp(argv[1], "replay") && argc > 2) {
+		replay(argv + 2, argc - 2);
+		printf("replayed %d of %d traced files\n", replayed, nr_files);
+	} else if (!strcmp(argv[1], "bench"))
+		bench(argc - 2, argv + 2);
+	else
+		usage();
+
+	return 0;
+}
@@ -9,6 +9,9 @@
  * is compiled with the -pg flag. When using dynamic ftrace, the
  * mcount call-sites get patched lazily with NOP till they are
  * enabled. All code mutation routines here take effect atomically.
+ *
+ * The function graph tracer hooks the return of the traced
+ * functions from mcount.
  */
 
 #include <linux/ftrace.h>
@@ -16,6 +19,8 @@
 #include <asm/cacheflush.h>
 #include <asm/ftrace.h>
 
+#ifdef CONFIG_DYNAMIC_FTRACE
+
 #define PC_OFFSET      8
 #define BL_OPCODE      0xeb000000
 #define BL_OFFSET_MASK 0x00ffffff
@@ -101,3 +106,22 @@ int __init ftrace_dyn_arch_init(void *data)
 	ftrace_mcount_set(data);
 	return 0;
 }
+
+#endif /* CONFIG_DYNAMIC_FTRACE */
+
+#ifdef CONFIG_FUNCTION_GRAPH_TRACER
+/*
+ * Hook the return address and push it in the stack of return addrs
+ * of the current task.
+ *
+ * @parent is the slot of the APCS frame of the traced function holding
+ * its saved lr, which its epilogue loads back into pc.
+ */
+void prepare_ftrace_return(unsigned long *parent, unsigned long self_addr)
+{
+	if (ftrace_push_return_trace(*parent, self_addr))
+		return;
+
+	*parent = (unsigned long)&return_to_handler;
+}
+#endif /* CONFIG_FUNCTION_GRAPH_TRACER */
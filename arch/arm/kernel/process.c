@@ -30,7 +30,10 @@
 #include <linux/utsname.h>
 #include <linux/uaccess.h>
 #include <linux/kobject.h>
+#include <linux/prezero.h>
+#include <linux/notifier.h>
 
+#include <asm/idle.h>
 #include <asm/leds.h>
 #include <asm/processor.h>
 #include <asm/system.h>
@@ -124,6 +127,26 @@ void (*arm_pm_restart)(char str) = arm_machine_restart;
 EXPORT_SYMBOL_GPL(arm_pm_restart);
 
 
+static ATOMIC_NOTIFIER_HEAD(idle_notifier);
+
+/*
+ * Idle notifiers are called with IDLE_START before the idle task stops the
+ * tick, so that the timers they arm or cancel are taken into account, and
+ * with IDLE_END after it has restarted the tick, both from the idle task
+ * with interrupts enabled.
+ */
+void idle_notifier_register(struct notifier_block *n)
+{
+	atomic_notifier_chain_register(&idle_notifier, n);
+}
+EXPORT_SYMBOL_GPL(idle_notifier_register);
+
+void idle_notifier_unregister(struct notifier_block *n)
+{
+	atomic_notifier_chain_unregister(&idle_notifier, n);
+}
+EXPORT_SYMBOL_GPL(idle_notifier_unregister);
+
 /*
  * This is our default idle handler.  We need to disable
  * interrupts here to ensure we don't miss a wakeup call.
@@ -162,12 +185,19 @@ void cpu_idle(void)
 
 		if (!idle)
 			idle = default_idle;
+		prezero_idle();
 		leds_event(led_idle_start);
+		atomic_notifier_call_chain(&idle_notifier, IDLE_START, NULL);
 		tick_nohz_stop_sched_tick(1);
-		while (!need_resched())
+		while (!need_resched()) {
+			/* Don't trace irqs off for idle */
+			stop_critical_timings();
 			idle();
+			start_critical_timings();
+		}
 		leds_event(led_idle_end);
 		tick_nohz_restart_sched_tick();
+		atomic_notifier_call_chain(&idle_notifier, IDLE_END, NULL);
 		preempt_enable_no_resched();
 		schedule();
 		preempt_disable();
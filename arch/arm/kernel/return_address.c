@@ -0,0 +1,48 @@
+/*
+ * arch/arm/kernel/return_address.c
+ *
+ * gcc returns 0 for __builtin_return_address() of any frame above the
+ * current one on ARM, so the CALLER_ADDRn used by the latency tracers
+ * walk the frame pointer chain instead.
+ */
+#include <linux/module.h>
+#include <linux/sched.h>
+
+#include "stacktrace.h"
+
+struct return_address_data {
+	unsigned int level;
+	void *addr;
+};
+
+static int save_return_addr(struct stackframe *frame, void *d)
+{
+	struct return_address_data *data = d;
+
+	if (!data->level) {
+		data->addr = (void *)frame->lr;
+		return 1;
+	}
+	data->level--;
+	return 0;
+}
+
+/*
+ * The first frame walked is our own, whose lr points into the caller:
+ * return_address(0) matches __builtin_return_address(0) of the caller.
+ */
+void *return_address(unsigned int level)
+{
+	struct return_address_data data;
+	unsigned long fp, base;
+
+	data.level = level + 1;
+	data.addr = NULL;
+
+	asm("mov %0, fp" : "=r" (fp));
+	base = (unsigned long)task_stack_page(current);
+	walk_stackframe(fp, base, base + THREAD_SIZE, save_return_addr, &data);
+
+	return data.addr;
+}
+EXPORT_SYMBOL_GPL(return_address);
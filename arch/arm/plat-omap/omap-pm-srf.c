@@ -22,6 +22,7 @@
 #include <linux/cpufreq.h>
 #include <linux/device.h>
 #include <linux/module.h>
+#include <linux/pm_qos_params.h>
 
 #include <mach/omap-pm.h>
 #include <mach/powerdomain.h>
@@ -157,10 +158,23 @@ void omap_pm_set_max_dev_wakeup_lat(struct device *dev, long t)
 		pr_debug("OMAP PM: remove max device latency constraint: "
 			 "dev %s\n", dev_name(dev));
 		resource_release(lat_res_name, dev);
+		pm_qos_remove_requirement(PM_QOS_CPU_DMA_LATENCY,
+					  (char *)dev_name(dev));
 	} else {
 		pr_debug("OMAP PM: add max device latency constraint: "
 			 "dev %s, t = %ld usec\n", dev_name(dev), t);
 		resource_request(lat_res_name, dev, t);
+		/*
+		 * The power domain resource only limits the state of the
+		 * domain of the device. Also let cpuidle know, which keeps
+		 * the MPU and CORE out of states it cannot wake up from in
+		 * time. pm_qos requirements are keyed by name, so replace
+		 * any earlier one of this device.
+		 */
+		pm_qos_remove_requirement(PM_QOS_CPU_DMA_LATENCY,
+					  (char *)dev_name(dev));
+		pm_qos_add_requirement(PM_QOS_CPU_DMA_LATENCY,
+				       (char *)dev_name(dev), t);
 	}
 
 	kfree(lat_res_name);
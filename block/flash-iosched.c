@@ -0,0 +1,475 @@
+/*
+ *  Flash i/o scheduler.
+ *
+ *  Based on the deadline i/o scheduler,
+ *  Copyright (C) 2002 Jens Axboe <axboe@kernel.dk>
+ */
+#include <linux/kernel.h>
+#include <linux/fs.h>
+#include <linux/blkdev.h>
+#include <linux/elevator.h>
+#include <linux/bio.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/init.h>
+#include <linux/compiler.h>
+#include <linux/rbtree.h>
+
+/*
+ * See Documentation/block/flash-iosched.txt
+ */
+static const int write_expire = HZ / 2;	/* max time before a write is submitted */
+static const int writes_starved = 16;	/* max times reads can starve a write */
+static const int write_batch = 32;	/* max # of writes dispatched in one batch */
+static const int write_chunk = 1024;	/* write batch alignment, in KiB */
+
+struct flash_data {
+	/*
+	 * run time data
+	 */
+
+	/*
+	 * requests are present on both sort_list and fifo_list
+	 */
+	struct rb_root sort_list[2];
+	struct list_head fifo_list[2];
+
+	/*
+	 * next write of the current write batch, or NULL
+	 */
+	struct request *next_write;
+	sector_t batch_end;		/* end of the current write chunk */
+	sector_t last_sector;		/* end of the last dispatched write */
+	unsigned int batching;		/* writes dispatched in this batch */
+	unsigned int batch_forced;	/* batch started because writes starved */
+	unsigned int starved;		/* times reads have starved writes */
+
+	/*
+	 * settings that change how the i/o scheduler behaves
+	 */
+	int write_expire;
+	int writes_starved;
+	int write_batch;
+	int write_chunk;
+	int front_merges;
+};
+
+static void flash_move_to_dispatch(struct flash_data *, struct request *);
+
+static inline struct rb_root *
+flash_rb_root(struct flash_data *fd, struct request *rq)
+{
+	return &fd->sort_list[rq_data_dir(rq)];
+}
+
+/*
+ * get the request after `rq' in sector-sorted order
+ */
+static inline struct request *
+flash_latter_request(struct request *rq)
+{
+	struct rb_node *node = rb_next(&rq->rb_node);
+
+	if (node)
+		return rb_entry_rq(node);
+
+	return NULL;
+}
+
+static void
+flash_add_rq_rb(struct flash_data *fd, struct request *rq)
+{
+	struct rb_root *root = flash_rb_root(fd, rq);
+	struct request *__alias;
+
+	while (unlikely(__alias = elv_rb_add(root, rq)))
+		flash_move_to_dispatch(fd, __alias);
+}
+
+static inline void
+flash_del_rq_rb(struct flash_data *fd, struct request *rq)
+{
+	if (fd->next_write == rq)
+		fd->next_write = flash_latter_request(rq);
+
+	elv_rb_del(flash_rb_root(fd, rq), rq);
+}
+
+/*
+ * add rq to rbtree and fifo
+ */
+static void
+flash_add_request(struct request_queue *q, struct request *rq)
+{
+	struct flash_data *fd = q->elevator->elevator_data;
+	const int data_dir = rq_data_dir(rq);
+
+	flash_add_rq_rb(fd, rq);
+
+	/*
+	 * reads do not expire, they always go first. Only writes are
+	 * given a deadline.
+	 */
+	rq_set_fifo_time(rq, jiffies + fd->write_expire);
+	list_add_tail(&rq->queuelist, &fd->fifo_list[data_dir]);
+}
+
+/*
+ * remove rq from rbtree and fifo.
+ */
+static void flash_remove_request(struct request_queue *q, struct request *rq)
+{
+	struct flash_data *fd = q->elevator->elevator_data;
+
+	rq_fifo_clear(rq);
+	flash_del_rq_rb(fd, rq);
+}
+
+static int
+flash_merge(struct request_queue *q, struct request **req, struct bio *bio)
+{
+	struct flash_data *fd = q->elevator->elevator_data;
+	struct request *__rq;
+
+	/*
+	 * check for front merge
+	 */
+	if (fd->front_merges) {
+		sector_t sector = bio->bi_sector + bio_sectors(bio);
+
+		__rq = elv_rb_find(&fd->sort_list[bio_data_dir(bio)], sector);
+		if (__rq) {
+			BUG_ON(sector != __rq->sector);
+
+			if (elv_rq_merge_ok(__rq, bio)) {
+				*req = __rq;
+				return ELEVATOR_FRONT_MERGE;
+			}
+		}
+	}
+
+	return ELEVATOR_NO_MERGE;
+}
+
+static void flash_merged_request(struct request_queue *q,
+				 struct request *req, int type)
+{
+	struct flash_data *fd = q->elevator->elevator_data;
+
+	/*
+	 * if the merge was a front merge, we need to reposition request
+	 */
+	if (type == ELEVATOR_FRONT_MERGE) {
+		elv_rb_del(flash_rb_root(fd, req), req);
+		flash_add_rq_rb(fd, req);
+	}
+}
+
+static void
+flash_merged_requests(struct request_queue *q, struct request *req,
+		      struct request *next)
+{
+	/*
+	 * if next expires before rq, assign its expire time to rq
+	 * and move into next position (next will be deleted) in fifo
+	 */
+	if (!list_empty(&req->queuelist) && !list_empty(&next->queuelist)) {
+		if (time_before(rq_fifo_time(next), rq_fifo_time(req))) {
+			list_move(&req->queuelist, &next->queuelist);
+			rq_set_fifo_time(req, rq_fifo_time(next));
+		}
+	}
+
+	/*
+	 * kill knowledge of next, this one is a goner
+	 */
+	flash_remove_request(q, next);
+}
+
+/*
+ * move request from sort list to dispatch queue.
+ */
+static void
+flash_move_to_dispatch(struct flash_data *fd, struct request *rq)
+{
+	struct request_queue *q = rq->q;
+
+	flash_remove_request(q, rq);
+	elv_dispatch_add_tail(q, rq);
+}
+
+/*
+ * returns the end of the write chunk `sector' belongs to
+ */
+static sector_t flash_chunk_end(struct flash_data *fd, sector_t sector)
+{
+	unsigned int chunk = fd->write_chunk << 1;
+	sector_t start = sector;
+
+	if (chunk == 0)
+		return sector + 1;
+
+	return start - sector_div(sector, chunk) + chunk;
+}
+
+/*
+ * returns 1 if `rq' may be dispatched as part of the current write batch.
+ * Writes are dispatched in sector order within one erase-block-aligned chunk,
+ * a sequential stream of writes may carry the batch over to the next chunk.
+ */
+static int flash_in_batch(struct flash_data *fd, struct request *rq)
+{
+	if (rq->sector < fd->batch_end)
+		return 1;
+
+	if (rq->sector == fd->last_sector) {
+		fd->batch_end = flash_chunk_end(fd, rq->sector);
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * start a new write batch in the chunk of the oldest write, from the
+ * lowest-sectored write of that chunk.
+ */
+static struct request *flash_start_write_batch(struct flash_data *fd)
+{
+	struct request *rq = rq_entry_fifo(fd->fifo_list[WRITE].next);
+	struct rb_node *node = fd->sort_list[WRITE].rb_node;
+	unsigned int chunk = fd->write_chunk << 1;
+	struct request *first = rq;
+	sector_t start;
+
+	fd->batch_end = flash_chunk_end(fd, rq->sector);
+	start = chunk ? fd->batch_end - chunk : rq->sector;
+
+	while (node) {
+		struct request *__rq = rb_entry_rq(node);
+
+		if (__rq->sector < start)
+			node = node->rb_right;
+		else {
+			first = __rq;
+			node = node->rb_left;
+		}
+	}
+
+	fd->batching = 0;
+	return first;
+}
+
+/*
+ * flash_check_fifo returns 1 if the oldest write has expired.
+ * Requires !list_empty(&fd->fifo_list[WRITE])
+ */
+static inline int flash_check_fifo(struct flash_data *fd)
+{
+	struct request *rq = rq_entry_fifo(fd->fifo_list[WRITE].next);
+
+	return time_after(jiffies, rq_fifo_time(rq));
+}
+
+/*
+ * flash_dispatch_requests selects the next request. Reads always go first, in
+ * fifo order (there are no seeks to save on flash). Writes are dispatched in
+ * batches when there are no reads, or when they have been starved for too
+ * long. The device is never idled.
+ */
+static int flash_dispatch_requests(struct request_queue *q, int force)
+{
+	struct flash_data *fd = q->elevator->elevator_data;
+	const int reads = !list_empty(&fd->fifo_list[READ]);
+	const int writes = !list_empty(&fd->fifo_list[WRITE]);
+	struct request *rq;
+
+	/*
+	 * continue the current write batch. Reads break voluntary batches, but
+	 * not those which were started because writes starved.
+	 */
+	rq = fd->next_write;
+	if (rq && fd->batching < fd->write_batch &&
+	    (!reads || fd->batch_forced) && flash_in_batch(fd, rq))
+		goto dispatch_write;
+
+	fd->next_write = NULL;
+
+	if (reads) {
+		if (writes && (fd->starved++ >= fd->writes_starved ||
+			       flash_check_fifo(fd))) {
+			fd->batch_forced = 1;
+			goto start_write_batch;
+		}
+
+		rq = rq_entry_fifo(fd->fifo_list[READ].next);
+		flash_move_to_dispatch(fd, rq);
+		return 1;
+	}
+
+	if (!writes)
+		return 0;
+
+	fd->batch_forced = 0;
+
+start_write_batch:
+	fd->starved = 0;
+	rq = flash_start_write_batch(fd);
+
+dispatch_write:
+	fd->batching++;
+	fd->last_sector = rq_end_sector(rq);
+	fd->next_write = flash_latter_request(rq);
+	flash_move_to_dispatch(fd, rq);
+
+	return 1;
+}
+
+static int flash_queue_empty(struct request_queue *q)
+{
+	struct flash_data *fd = q->elevator->elevator_data;
+
+	return list_empty(&fd->fifo_list[WRITE])
+		&& list_empty(&fd->fifo_list[READ]);
+}
+
+static void flash_exit_queue(elevator_t *e)
+{
+	struct flash_data *fd = e->elevator_data;
+
+	BUG_ON(!list_empty(&fd->fifo_list[READ]));
+	BUG_ON(!list_empty(&fd->fifo_list[WRITE]));
+
+	kfree(fd);
+}
+
+/*
+ * initialize elevator private data (flash_data).
+ */
+static void *flash_init_queue(struct request_queue *q)
+{
+	struct flash_data *fd;
+
+	fd = kmalloc_node(sizeof(*fd), GFP_KERNEL | __GFP_ZERO, q->node);
+	if (!fd)
+		return NULL;
+
+	INIT_LIST_HEAD(&fd->fifo_list[READ]);
+	INIT_LIST_HEAD(&fd->fifo_list[WRITE]);
+	fd->sort_list[READ] = RB_ROOT;
+	fd->sort_list[WRITE] = RB_ROOT;
+	fd->write_expire = write_expire;
+	fd->writes_starved = writes_starved;
+	fd->write_batch = write_batch;
+	fd->write_chunk = write_chunk;
+	fd->front_merges = 1;
+	return fd;
+}
+
+/*
+ * sysfs parts below
+ */
+
+static ssize_t
+flash_var_show(int var, char *page)
+{
+	return sprintf(page, "%d\n", var);
+}
+
+static ssize_t
+flash_var_store(int *var, const char *page, size_t count)
+{
+	char *p = (char *) page;
+
+	*var = simple_strtol(p, &p, 10);
+	return count;
+}
+
+#define SHOW_FUNCTION(__FUNC, __VAR, __CONV)				\
+static ssize_t __FUNC(elevator_t *e, char *page)			\
+{									\
+	struct flash_data *fd = e->elevator_data;			\
+	int __data = __VAR;						\
+	if (__CONV)							\
+		__data = jiffies_to_msecs(__data);			\
+	return flash_var_show(__data, (page));				\
+}
+SHOW_FUNCTION(flash_write_expire_show, fd->write_expire, 1);
+SHOW_FUNCTION(flash_writes_starved_show, fd->writes_starved, 0);
+SHOW_FUNCTION(flash_write_batch_show, fd->write_batch, 0);
+SHOW_FUNCTION(flash_write_chunk_kb_show, fd->write_chunk, 0);
+SHOW_FUNCTION(flash_front_merges_show, fd->front_merges, 0);
+#undef SHOW_FUNCTION
+
+#define STORE_FUNCTION(__FUNC, __PTR, MIN, MAX, __CONV)			\
+static ssize_t __FUNC(elevator_t *e, const char *page, size_t count)	\
+{									\
+	struct flash_data *fd = e->elevator_data;			\
+	int __data;							\
+	int ret = flash_var_store(&__data, (page), count);		\
+	if (__data < (MIN))						\
+		__data = (MIN);						\
+	else if (__data > (MAX))					\
+		__data = (MAX);						\
+	if (__CONV)							\
+		*(__PTR) = msecs_to_jiffies(__data);			\
+	else								\
+		*(__PTR) = __data;					\
+	return ret;							\
+}
+STORE_FUNCTION(flash_write_expire_store, &fd->write_expire, 0, INT_MAX, 1);
+STORE_FUNCTION(flash_writes_starved_store, &fd->writes_starved, 0, INT_MAX, 0);
+STORE_FUNCTION(flash_write_batch_store, &fd->write_batch, 1, INT_MAX, 0);
+STORE_FUNCTION(flash_write_chunk_kb_store, &fd->write_chunk, 0, 65536, 0);
+STORE_FUNCTION(flash_front_merges_store, &fd->front_merges, 0, 1, 0);
+#undef STORE_FUNCTION
+
+#define FD_ATTR(name) \
+	__ATTR(name, S_IRUGO|S_IWUSR, flash_##name##_show, \
+				      flash_##name##_store)
+
+static struct elv_fs_entry flash_attrs[] = {
+	FD_ATTR(write_expire),
+	FD_ATTR(writes_starved),
+	FD_ATTR(write_batch),
+	FD_ATTR(write_chunk_kb),
+	FD_ATTR(front_merges),
+	__ATTR_NULL
+};
+
+static struct elevator_type iosched_flash = {
+	.ops = {
+		.elevator_merge_fn = 		flash_merge,
+		.elevator_merged_fn =		flash_merged_request,
+		.elevator_merge_req_fn =	flash_merged_requests,
+		.elevator_dispatch_fn =		flash_dispatch_requests,
+		.elevator_add_req_fn =		flash_add_request,
+		.elevator_queue_empty_fn =	flash_queue_empty,
+		.elevator_former_req_fn =	elv_rb_former_request,
+		.elevator_latter_req_fn =	elv_rb_latter_request,
+		.elevator_init_fn =		flash_init_queue,
+		.elevator_exit_fn =		flash_exit_queue,
+	},
+
+	.elevator_attrs = flash_attrs,
+	.elevator_name = "flash",
+	.elevator_owner = THIS_MODULE,
+};
+
+static int __init flash_init(void)
+{
+	elv_register(&iosched_flash);
+
+	return 0;
+}
+
+static void __exit flash_exit(void)
+{
+	elv_unregister(&iosched_flash);
+}
+
+module_init(flash_init);
+module_exit(flash_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("flash IO scheduler");
@@ -0,0 +1,220 @@
+/*
+ *  linux/drivers/cpufreq/cpufreq_fake.c
+ *
+ *  A cpufreq driver for testing governors: it changes no clock, but takes
+ *  latency_us for every transition and records it in debugfs, in
+ *  cpufreq_fake/transitions, one line per transition:
+ *
+ *	<time in uS> <cpu> <old kHz> <new kHz>
+ *
+ *  Writing to the file clears it. The frequency table is the one of the
+ *  OMAP3430 MPU.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/cpufreq.h>
+#include <linux/debugfs.h>
+#include <linux/delay.h>
+#include <linux/hrtimer.h>
+#include <linux/percpu.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
+
+#define FAKE_NR_TRANSITIONS	1024
+
+static struct cpufreq_frequency_table fake_freq_table[] = {
+	{ 0, 125000 },
+	{ 1, 250000 },
+	{ 2, 500000 },
+	{ 3, 550000 },
+	{ 4, 600000 },
+	{ 0, CPUFREQ_TABLE_END },
+};
+
+static unsigned int latency_us = 300;
+module_param(latency_us, uint, 0644);
+MODULE_PARM_DESC(latency_us, "Time a transition takes, in uS");
+
+struct fake_transition {
+	u64 time_us;
+	unsigned int cpu;
+	unsigned int old;
+	unsigned int new;
+};
+
+static struct fake_transition fake_transitions[FAKE_NR_TRANSITIONS];
+static unsigned int fake_head, fake_count;
+static DEFINE_SPINLOCK(fake_lock);
+
+static DEFINE_PER_CPU(unsigned int, fake_cur);
+static struct dentry *fake_dir;
+
+static void fake_record(struct cpufreq_freqs *freqs)
+{
+	struct fake_transition *t;
+	unsigned long flags;
+
+	spin_lock_irqsave(&fake_lock, flags);
+	t = &fake_transitions[fake_head];
+	t->time_us = ktime_to_us(ktime_get());
+	t->cpu = freqs->cpu;
+	t->old = freqs->old;
+	t->new = freqs->new;
+	fake_head = (fake_head + 1) % FAKE_NR_TRANSITIONS;
+	if (fake_count < FAKE_NR_TRANSITIONS)
+		fake_count++;
+	spin_unlock_irqrestore(&fake_lock, flags);
+}
+
+static int fake_verify_speed(struct cpufreq_policy *policy)
+{
+	return cpufreq_frequency_table_verify(policy, fake_freq_table);
+}
+
+static unsigned int fake_getspeed(unsigned int cpu)
+{
+	return per_cpu(fake_cur, cpu);
+}
+
+static int fake_target(struct cpufreq_policy *policy,
+		       unsigned int target_freq,
+		       unsigned int relation)
+{
+	struct cpufreq_freqs freqs;
+	unsigned int index;
+
+	if (cpufreq_frequency_table_target(policy, fake_freq_table,
+					   target_freq, relation, &index))
+		return -EINVAL;
+
+	freqs.cpu = policy->cpu;
+	freqs.old = per_cpu(fake_cur, policy->cpu);
+	freqs.new = fake_freq_table[index].frequency;
+	if (freqs.old == freqs.new)
+		return 0;
+
+	cpufreq_notify_transition(&freqs, CPUFREQ_PRECHANGE);
+	if (latency_us >= 1000)
+		msleep(latency_us / 1000);
+	udelay(latency_us % 1000);
+	per_cpu(fake_cur, policy->cpu) = freqs.new;
+	fake_record(&freqs);
+	cpufreq_notify_transition(&freqs, CPUFREQ_POSTCHANGE);
+
+	return 0;
+}
+
+static int fake_cpu_init(struct cpufreq_policy *policy)
+{
+	int result;
+
+	result = cpufreq_frequency_table_cpuinfo(policy, fake_freq_table);
+	if (result)
+		return result;
+	cpufreq_frequency_table_get_attr(fake_freq_table, policy->cpu);
+
+	per_cpu(fake_cur, policy->cpu) = policy->cpuinfo.min_freq;
+	policy->cur = policy->cpuinfo.min_freq;
+	policy->cpuinfo.transition_latency = latency_us * 1000;
+	return 0;
+}
+
+static int fake_cpu_exit(struct cpufreq_policy *policy)
+{
+	cpufreq_frequency_table_put_attr(policy->cpu);
+	return 0;
+}
+
+static struct freq_attr *fake_cpufreq_attr[] = {
+	&cpufreq_freq_attr_scaling_available_freqs,
+	NULL,
+};
+
+static struct cpufreq_driver fake_driver = {
+	.verify		= fake_verify_speed,
+	.target		= fake_target,
+	.get		= fake_getspeed,
+	.init		= fake_cpu_init,
+	.exit		= fake_cpu_exit,
+	.name		= "fake",
+	.owner		= THIS_MODULE,
+	.attr		= fake_cpufreq_attr,
+};
+
+static int fake_transitions_show(struct seq_file *m, void *v)
+{
+	unsigned int i, n;
+
+	spin_lock_irq(&fake_lock);
+	n = (fake_head + FAKE_NR_TRANSITIONS - fake_count) %
+		FAKE_NR_TRANSITIONS;
+	for (i = 0; i < fake_count; i++) {
+		struct fake_transition *t = &fake_transitions[n];
+
+		seq_printf(m, "%llu %u %u %u\n", (unsigned long long)t->time_us,
+			   t->cpu, t->old, t->new);
+		n = (n + 1) % FAKE_NR_TRANSITIONS;
+	}
+	spin_unlock_irq(&fake_lock);
+	return 0;
+}
+
+static int fake_transitions_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, fake_transitions_show, NULL);
+}
+
+static ssize_t fake_transitions_write(struct file *file,
+		const char __user *buf, size_t count, loff_t *ppos)
+{
+	spin_lock_irq(&fake_lock);
+	fake_head = fake_count = 0;
+	spin_unlock_irq(&fake_lock);
+	return count;
+}
+
+static const struct file_operations fake_transitions_fops = {
+	.open		= fake_transitions_open,
+	.read		= seq_read,
+	.write		= fake_transitions_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init fake_cpufreq_init(void)
+{
+	int ret;
+
+	fake_dir = debugfs_create_dir("cpufreq_fake", NULL);
+	if (!fake_dir)
+		return -ENOMEM;
+	if (!debugfs_create_file("transitions", 0644, fake_dir, NULL,
+				 &fake_transitions_fops)) {
+		debugfs_remove(fake_dir);
+		return -ENOMEM;
+	}
+
+	ret = cpufreq_register_driver(&fake_driver);
+	if (ret)
+		debugfs_remove_recursive(fake_dir);
+	return ret;
+}
+
+static void __exit fake_cpufreq_exit(void)
+{
+	cpufreq_unregister_driver(&fake_driver);
+	debugfs_remove_recursive(fake_dir);
+}
+
+MODULE_DESCRIPTION("cpufreq driver recording transitions, for testing "
+		"governors");
+MODULE_LICENSE("GPL");
+
+module_init(fake_cpufreq_init);
+module_exit(fake_cpufreq_exit);
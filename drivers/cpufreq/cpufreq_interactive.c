@@ -0,0 +1,847 @@
+/*
+ *  drivers/cpufreq/cpufreq_interactive.c
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * The 'interactive' governor samples the load of each CPU on a short timer
+ * which only runs while the CPU is busy, or idle above the minimum speed.
+ * When a CPU leaves idle the load is sampled again a tick or two later, so
+ * that a CPU which stays busy gets ramped to hispeed_freq right away
+ * instead of one sampling period later. An input event, like a touch,
+ * raises all CPUs to hispeed_freq before any load is seen at all.
+ *
+ * The speed is only lowered once the current one has been held for
+ * min_sample_time, so that short idle periods between bursts of work do
+ * not make it drop and ramp again. Speed changes are made from a realtime
+ * workqueue, since the driver may sleep; the time from each request to its
+ * completion is kept per transition.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/cpu.h>
+#include <linux/cpumask.h>
+#include <linux/cpufreq.h>
+#include <linux/hrtimer.h>
+#include <linux/input.h>
+#include <linux/jiffies.h>
+#include <linux/kernel_stat.h>
+#include <linux/mutex.h>
+#include <linux/notifier.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/sysfs.h>
+#include <linux/tick.h>
+#include <linux/timer.h>
+#include <linux/workqueue.h>
+
+#include <asm/idle.h>
+
+/* Load at which the speed jumps straight to hispeed_freq */
+#define DEFAULT_GO_HISPEED_LOAD		85
+
+/* Time a speed is held before it may be lowered, in uS */
+#define DEFAULT_MIN_SAMPLE_TIME		(80 * USEC_PER_MSEC)
+
+/* Sampling period while the CPU is busy, in uS */
+#define DEFAULT_TIMER_RATE		(20 * USEC_PER_MSEC)
+
+#define TRANSITION_LATENCY_LIMIT	(10 * 1000 * 1000)
+
+struct interactive_trans {
+	unsigned int count;
+	unsigned int max_us;
+	u64 total_us;
+};
+
+struct cpufreq_interactive_cpuinfo {
+	struct timer_list cpu_timer;
+	int timer_idlecancel;
+	u64 time_in_idle;	/* idle time at the start of the sample */
+	u64 idle_exit_time;	/* start of the sample */
+	int idling;
+	struct cpufreq_policy *policy;
+	struct cpufreq_frequency_table *freq_table;
+	unsigned int target_freq;
+	u64 request_time;	/* when target_freq was requested */
+	unsigned int floor_freq;
+	u64 floor_validate_time;
+	/* per policy, on policy->cpu only */
+	struct interactive_trans *trans;
+	unsigned int nr_freqs;
+	int governor_enabled;
+};
+
+static DEFINE_PER_CPU(struct cpufreq_interactive_cpuinfo, cpuinfo);
+
+/* CPUs whose target_freq has to be applied by the speedchange work */
+static cpumask_t speedchange_cpumask;
+static DEFINE_SPINLOCK(speedchange_cpumask_lock);
+static struct workqueue_struct *speedchange_wq;
+static struct work_struct speedchange_work;
+
+/* Serializes governor start/stop, speed changes and the statistics */
+static DEFINE_MUTEX(interactive_mutex);
+static unsigned int active_count;
+
+/* Protects target_freq and floor_freq against the input boost */
+static DEFINE_SPINLOCK(target_lock);
+
+struct interactive_tuners {
+	unsigned int hispeed_freq;
+	unsigned int go_hispeed_load;
+	unsigned int min_sample_time;
+	unsigned int timer_rate;
+	unsigned int input_boost;
+};
+
+static struct interactive_tuners tuners_ins = {
+	.go_hispeed_load = DEFAULT_GO_HISPEED_LOAD,
+	.min_sample_time = DEFAULT_MIN_SAMPLE_TIME,
+	.timer_rate = DEFAULT_TIMER_RATE,
+	.input_boost = 1,
+};
+
+static inline u64 interactive_now(void)
+{
+	return ktime_to_us(ktime_get());
+}
+
+/* Idle time of @cpu in uS, and the current time in @wall */
+static u64 get_cpu_idle_time(unsigned int cpu, u64 *wall)
+{
+	u64 idle_time = get_cpu_idle_time_us(cpu, wall);
+
+	if (idle_time == -1ULL) {
+		/* No NO_HZ idle accounting: fall back to the tick counts */
+		cputime64_t idle = cputime64_add(kstat_cpu(cpu).cpustat.idle,
+						 kstat_cpu(cpu).cpustat.iowait);
+
+		idle_time = div_u64(cputime64_to_jiffies64(idle) *
+				    USEC_PER_SEC, HZ);
+		/* same time base as the floor and request times */
+		*wall = interactive_now();
+	}
+	return idle_time;
+}
+
+static void interactive_timer_start(struct cpufreq_interactive_cpuinfo *pcpu,
+				    unsigned int cpu, unsigned long delay)
+{
+	pcpu->time_in_idle = get_cpu_idle_time(cpu, &pcpu->idle_exit_time);
+	pcpu->timer_idlecancel = 0;
+	mod_timer(&pcpu->cpu_timer, jiffies + delay);
+}
+
+static void interactive_queue_speedchange(unsigned int cpu)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&speedchange_cpumask_lock, flags);
+	cpu_set(cpu, speedchange_cpumask);
+	spin_unlock_irqrestore(&speedchange_cpumask_lock, flags);
+	queue_work(speedchange_wq, &speedchange_work);
+}
+
+static void cpufreq_interactive_timer(unsigned long data)
+{
+	unsigned int cpu = data;
+	struct cpufreq_interactive_cpuinfo *pcpu = &per_cpu(cpuinfo, cpu);
+	struct cpufreq_policy *policy;
+	unsigned int delta_idle, delta_time, load, new_freq, index;
+	u64 now, now_idle;
+	unsigned long flags;
+
+	smp_rmb();
+	if (!pcpu->governor_enabled)
+		return;
+	policy = pcpu->policy;
+
+	now_idle = get_cpu_idle_time(cpu, &now);
+	delta_idle = (unsigned int)(now_idle - pcpu->time_in_idle);
+	delta_time = (unsigned int)(now - pcpu->idle_exit_time);
+
+	/* A sample too short to tell anything: try again later */
+	if (!delta_time || delta_time < delta_idle)
+		goto rearm;
+
+	load = 100 * (delta_time - delta_idle) / delta_time;
+
+	spin_lock_irqsave(&target_lock, flags);
+	if (load >= tuners_ins.go_hispeed_load &&
+	    pcpu->target_freq < tuners_ins.hispeed_freq)
+		new_freq = tuners_ins.hispeed_freq;
+	else
+		new_freq = policy->max * load / 100;
+
+	if (cpufreq_frequency_table_target(policy, pcpu->freq_table, new_freq,
+					   CPUFREQ_RELATION_L, &index)) {
+		spin_unlock_irqrestore(&target_lock, flags);
+		goto rearm;
+	}
+	new_freq = pcpu->freq_table[index].frequency;
+
+	/* Hold the floor for min_sample_time before stepping down */
+	if (new_freq < pcpu->floor_freq &&
+	    now - pcpu->floor_validate_time < tuners_ins.min_sample_time) {
+		spin_unlock_irqrestore(&target_lock, flags);
+		goto rearm;
+	}
+	pcpu->floor_freq = new_freq;
+	pcpu->floor_validate_time = now;
+
+	if (new_freq == pcpu->target_freq) {
+		spin_unlock_irqrestore(&target_lock, flags);
+		goto rearm_if_notmax;
+	}
+	pcpu->target_freq = new_freq;
+	pcpu->request_time = now;
+	spin_unlock_irqrestore(&target_lock, flags);
+
+	interactive_queue_speedchange(cpu);
+
+rearm_if_notmax:
+	/*
+	 * Already at max: no need to sample until the CPU idles, which
+	 * restarts the timer if a lower speed can be considered.
+	 */
+	if (pcpu->target_freq == policy->max)
+		return;
+
+rearm:
+	if (!timer_pending(&pcpu->cpu_timer)) {
+		/*
+		 * At min speed an idle CPU has nothing to lower: let it sleep,
+		 * the idle exit restarts the timer.
+		 */
+		if (pcpu->target_freq == policy->min) {
+			smp_rmb();
+			if (pcpu->idling)
+				return;
+			pcpu->timer_idlecancel = 1;
+		}
+		pcpu->time_in_idle = get_cpu_idle_time(cpu,
+						       &pcpu->idle_exit_time);
+		mod_timer(&pcpu->cpu_timer,
+			  jiffies + usecs_to_jiffies(tuners_ins.timer_rate));
+	}
+}
+
+static void cpufreq_interactive_idle_start(void)
+{
+	unsigned int cpu = smp_processor_id();
+	struct cpufreq_interactive_cpuinfo *pcpu = &per_cpu(cpuinfo, cpu);
+	int pending;
+
+	pcpu->idling = 1;
+	smp_wmb();
+	if (!pcpu->governor_enabled)
+		return;
+
+	pending = timer_pending(&pcpu->cpu_timer);
+	if (pcpu->target_freq != pcpu->policy->min) {
+		/*
+		 * Above min speed, keep sampling while idle so that the speed
+		 * can be lowered without waiting for the CPU to wake up.
+		 */
+		if (!pending)
+			interactive_timer_start(pcpu, cpu,
+				usecs_to_jiffies(tuners_ins.timer_rate));
+	} else if (pending && pcpu->timer_idlecancel) {
+		/* At min speed, do not wake the CPU just to sample it */
+		del_timer(&pcpu->cpu_timer);
+	}
+}
+
+static void cpufreq_interactive_idle_end(void)
+{
+	unsigned int cpu = smp_processor_id();
+	struct cpufreq_interactive_cpuinfo *pcpu = &per_cpu(cpuinfo, cpu);
+
+	pcpu->idling = 0;
+	smp_wmb();
+	if (!pcpu->governor_enabled)
+		return;
+
+	/*
+	 * Sample the load from idle exit on within 1-2 ticks, so that a CPU
+	 * which stays busy ramps up quickly.
+	 */
+	if (!timer_pending(&pcpu->cpu_timer))
+		interactive_timer_start(pcpu, cpu, 2);
+}
+
+static int cpufreq_interactive_idle_notifier(struct notifier_block *nb,
+					     unsigned long val, void *data)
+{
+	switch (val) {
+	case IDLE_START:
+		cpufreq_interactive_idle_start();
+		break;
+	case IDLE_END:
+		cpufreq_interactive_idle_end();
+		break;
+	}
+	return 0;
+}
+
+static struct notifier_block cpufreq_interactive_idle_nb = {
+	.notifier_call = cpufreq_interactive_idle_notifier,
+};
+
+/* Frequency of the @n'th valid entry of the frequency table of @pcpu */
+static unsigned int interactive_index_freq(
+		struct cpufreq_interactive_cpuinfo *pcpu, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; pcpu->freq_table[i].frequency != CPUFREQ_TABLE_END; i++) {
+		if (pcpu->freq_table[i].frequency == CPUFREQ_ENTRY_INVALID)
+			continue;
+		if (!n--)
+			break;
+	}
+	return pcpu->freq_table[i].frequency;
+}
+
+/* Index of @freq among the valid entries of the table of @pcpu, or -1 */
+static int interactive_freq_index(struct cpufreq_interactive_cpuinfo *pcpu,
+				  unsigned int freq)
+{
+	int i, n = 0;
+
+	for (i = 0; pcpu->freq_table[i].frequency != CPUFREQ_TABLE_END; i++) {
+		if (pcpu->freq_table[i].frequency == CPUFREQ_ENTRY_INVALID)
+			continue;
+		if (pcpu->freq_table[i].frequency == freq)
+			return n;
+		n++;
+	}
+	return -1;
+}
+
+static void interactive_account(struct cpufreq_interactive_cpuinfo *ppol,
+				unsigned int old, unsigned int new, u64 latency)
+{
+	struct interactive_trans *trans;
+	int from, to;
+
+	from = interactive_freq_index(ppol, old);
+	to = interactive_freq_index(ppol, new);
+	if (!ppol->trans || from < 0 || to < 0)
+		return;
+
+	trans = &ppol->trans[from * ppol->nr_freqs + to];
+	trans->count++;
+	trans->total_us += latency;
+	if (latency > trans->max_us)
+		trans->max_us = latency;
+}
+
+/*
+ * Sets the policy of @cpu to the highest speed its CPUs want. Called with
+ * the policy rwsem of @cpu held for writing, and interactive_mutex.
+ */
+static void interactive_set_speed(unsigned int cpu)
+{
+	struct cpufreq_interactive_cpuinfo *pcpu = &per_cpu(cpuinfo, cpu);
+	struct cpufreq_interactive_cpuinfo *ppol;
+	struct cpufreq_policy *policy;
+	unsigned int max_freq = 0, old, j;
+	u64 request_time = 0;
+
+	if (!pcpu->governor_enabled)
+		return;
+	policy = pcpu->policy;
+	ppol = &per_cpu(cpuinfo, policy->cpu);
+
+	/* The CPUs of a policy run at the highest speed any wants */
+	for_each_cpu_mask_nr(j, policy->cpus) {
+		struct cpufreq_interactive_cpuinfo *pjcpu =
+			&per_cpu(cpuinfo, j);
+
+		if (pjcpu->target_freq > max_freq) {
+			max_freq = pjcpu->target_freq;
+			request_time = pjcpu->request_time;
+		}
+	}
+
+	old = policy->cur;
+	if (max_freq == old)
+		return;
+	__cpufreq_driver_target(policy, max_freq, CPUFREQ_RELATION_H);
+	if (policy->cur != old)
+		interactive_account(ppol, old, policy->cur,
+				    interactive_now() - request_time);
+}
+
+static void cpufreq_interactive_speedchange(struct work_struct *work)
+{
+	cpumask_t tmp_mask;
+	unsigned long flags;
+	unsigned int cpu;
+
+	spin_lock_irqsave(&speedchange_cpumask_lock, flags);
+	tmp_mask = speedchange_cpumask;
+	cpus_clear(speedchange_cpumask);
+	spin_unlock_irqrestore(&speedchange_cpumask_lock, flags);
+
+	for_each_cpu_mask_nr(cpu, tmp_mask) {
+		/* as ondemand does, and before interactive_mutex like sysfs */
+		if (lock_policy_rwsem_write(cpu) < 0)
+			continue;
+		mutex_lock(&interactive_mutex);
+		interactive_set_speed(cpu);
+		mutex_unlock(&interactive_mutex);
+		unlock_policy_rwsem_write(cpu);
+	}
+}
+
+/*
+ * Input boost: raise all CPUs to hispeed_freq as soon as the user touches
+ * the screen or presses a key, and hold it for min_sample_time.
+ */
+static void cpufreq_interactive_boost(void)
+{
+	unsigned long flags;
+	unsigned int cpu;
+	u64 now = interactive_now();
+
+	for_each_online_cpu(cpu) {
+		struct cpufreq_interactive_cpuinfo *pcpu = &per_cpu(cpuinfo, cpu);
+		unsigned int hispeed_freq = tuners_ins.hispeed_freq;
+		int changed = 0;
+
+		smp_rmb();
+		if (!pcpu->governor_enabled)
+			continue;
+
+		spin_lock_irqsave(&target_lock, flags);
+		if (hispeed_freq > pcpu->policy->max)
+			hispeed_freq = pcpu->policy->max;
+		if (pcpu->target_freq < hispeed_freq) {
+			pcpu->target_freq = hispeed_freq;
+			pcpu->request_time = now;
+			changed = 1;
+		}
+		if (pcpu->floor_freq < hispeed_freq)
+			pcpu->floor_freq = hispeed_freq;
+		pcpu->floor_validate_time = now;
+		spin_unlock_irqrestore(&target_lock, flags);
+
+		if (changed)
+			interactive_queue_speedchange(cpu);
+	}
+}
+
+static void cpufreq_interactive_input_event(struct input_handle *handle,
+					    unsigned int type,
+					    unsigned int code, int value)
+{
+	/* Key presses and touches, not releases or sync events */
+	if (!tuners_ins.input_boost)
+		return;
+	if ((type == EV_KEY && value == 1) || type == EV_ABS)
+		cpufreq_interactive_boost();
+}
+
+static int cpufreq_interactive_input_connect(struct input_handler *handler,
+					     struct input_dev *dev,
+					     const struct input_device_id *id)
+{
+	struct input_handle *handle;
+	int error;
+
+	handle = kzalloc(sizeof(struct input_handle), GFP_KERNEL);
+	if (!handle)
+		return -ENOMEM;
+
+	handle->dev = dev;
+	handle->handler = handler;
+	handle->name = "cpufreq_interactive";
+
+	error = input_register_handle(handle);
+	if (error)
+		goto err_free;
+
+	error = input_open_device(handle);
+	if (error)
+		goto err_unregister;
+
+	return 0;
+
+err_unregister:
+	input_unregister_handle(handle);
+err_free:
+	kfree(handle);
+	return error;
+}
+
+static void cpufreq_interactive_input_disconnect(struct input_handle *handle)
+{
+	input_close_device(handle);
+	input_unregister_handle(handle);
+	kfree(handle);
+}
+
+static const struct input_device_id cpufreq_interactive_ids[] = {
+	{	/* touchscreens and touchpads */
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT |
+			 INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.evbit = { BIT_MASK(EV_ABS) },
+		.absbit = { [BIT_WORD(ABS_X)] =
+				BIT_MASK(ABS_X) | BIT_MASK(ABS_Y) },
+	},
+	{	/* keypads and buttons */
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT,
+		.evbit = { BIT_MASK(EV_KEY) },
+	},
+	{ },
+};
+
+static struct input_handler cpufreq_interactive_input_handler = {
+	.event		= cpufreq_interactive_input_event,
+	.connect	= cpufreq_interactive_input_connect,
+	.disconnect	= cpufreq_interactive_input_disconnect,
+	.name		= "cpufreq_interactive",
+	.id_table	= cpufreq_interactive_ids,
+};
+
+/************************** sysfs interface ************************/
+#define show_one(file_name, object)					\
+static ssize_t show_##file_name						\
+(struct cpufreq_policy *unused, char *buf)				\
+{									\
+	return sprintf(buf, "%u\n", tuners_ins.object);			\
+}
+show_one(hispeed_freq, hispeed_freq);
+show_one(go_hispeed_load, go_hispeed_load);
+show_one(min_sample_time, min_sample_time);
+show_one(timer_rate, timer_rate);
+show_one(input_boost, input_boost);
+
+static ssize_t store_hispeed_freq(struct cpufreq_policy *policy,
+		const char *buf, size_t count)
+{
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+	if (ret != 1 || input < policy->cpuinfo.min_freq ||
+	    input > policy->cpuinfo.max_freq)
+		return -EINVAL;
+
+	tuners_ins.hispeed_freq = input;
+	return count;
+}
+
+static ssize_t store_go_hispeed_load(struct cpufreq_policy *unused,
+		const char *buf, size_t count)
+{
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+	if (ret != 1 || input > 100)
+		return -EINVAL;
+
+	tuners_ins.go_hispeed_load = input;
+	return count;
+}
+
+static ssize_t store_min_sample_time(struct cpufreq_policy *unused,
+		const char *buf, size_t count)
+{
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+	if (ret != 1)
+		return -EINVAL;
+
+	tuners_ins.min_sample_time = input;
+	return count;
+}
+
+static ssize_t store_timer_rate(struct cpufreq_policy *unused,
+		const char *buf, size_t count)
+{
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+	if (ret != 1 || usecs_to_jiffies(input) < 1)
+		return -EINVAL;
+
+	tuners_ins.timer_rate = input;
+	return count;
+}
+
+static ssize_t store_input_boost(struct cpufreq_policy *unused,
+		const char *buf, size_t count)
+{
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+	if (ret != 1)
+		return -EINVAL;
+
+	tuners_ins.input_boost = !!input;
+	return count;
+}
+
+/*
+ * Request to completion latency of the speed changes made by the
+ * governor, per transition. Writing anything clears it.
+ */
+static ssize_t show_transition_stats(struct cpufreq_policy *policy, char *buf)
+{
+	struct cpufreq_interactive_cpuinfo *ppol = &per_cpu(cpuinfo,
+							    policy->cpu);
+	unsigned int i, j;
+	ssize_t len;
+
+	mutex_lock(&interactive_mutex);
+	len = sprintf(buf, "%9s %9s %8s %8s %8s\n",
+		      "From", "To", "Count", "Avg(us)", "Max(us)");
+	for (i = 0; ppol->trans && i < ppol->nr_freqs; i++) {
+		for (j = 0; j < ppol->nr_freqs; j++) {
+			struct interactive_trans *trans =
+				&ppol->trans[i * ppol->nr_freqs + j];
+
+			if (!trans->count)
+				continue;
+			if (len >= PAGE_SIZE - 50)
+				break;
+			len += sprintf(buf + len, "%9u %9u %8u %8llu %8u\n",
+				interactive_index_freq(ppol, i),
+				interactive_index_freq(ppol, j), trans->count,
+				div_u64(trans->total_us, trans->count),
+				trans->max_us);
+		}
+	}
+	mutex_unlock(&interactive_mutex);
+	return len;
+}
+
+static ssize_t store_transition_stats(struct cpufreq_policy *policy,
+		const char *buf, size_t count)
+{
+	struct cpufreq_interactive_cpuinfo *ppol = &per_cpu(cpuinfo,
+							    policy->cpu);
+
+	mutex_lock(&interactive_mutex);
+	if (ppol->trans)
+		memset(ppol->trans, 0, ppol->nr_freqs * ppol->nr_freqs *
+		       sizeof(struct interactive_trans));
+	mutex_unlock(&interactive_mutex);
+	return count;
+}
+
+#define define_one_rw(_name) \
+static struct freq_attr _name = \
+__ATTR(_name, 0644, show_##_name, store_##_name)
+
+define_one_rw(hispeed_freq);
+define_one_rw(go_hispeed_load);
+define_one_rw(min_sample_time);
+define_one_rw(timer_rate);
+define_one_rw(input_boost);
+define_one_rw(transition_stats);
+
+static struct attribute *interactive_attributes[] = {
+	&hispeed_freq.attr,
+	&go_hispeed_load.attr,
+	&min_sample_time.attr,
+	&timer_rate.attr,
+	&input_boost.attr,
+	&transition_stats.attr,
+	NULL
+};
+
+static struct attribute_group interactive_attr_group = {
+	.attrs = interactive_attributes,
+	.name = "interactive",
+};
+
+/************************** sysfs end ************************/
+
+/*
+ * The frequency table is indexed with invalid entries skipped, which is
+ * also the layout of the transition statistics.
+ */
+static int interactive_alloc_stats(struct cpufreq_interactive_cpuinfo *ppol)
+{
+	unsigned int i, n = 0;
+
+	for (i = 0; ppol->freq_table[i].frequency != CPUFREQ_TABLE_END; i++)
+		if (ppol->freq_table[i].frequency != CPUFREQ_ENTRY_INVALID)
+			n++;
+
+	ppol->trans = kzalloc(n * n * sizeof(struct interactive_trans),
+			      GFP_KERNEL);
+	if (!ppol->trans)
+		return -ENOMEM;
+	ppol->nr_freqs = n;
+	return 0;
+}
+
+static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
+					unsigned int event)
+{
+	struct cpufreq_interactive_cpuinfo *ppol = &per_cpu(cpuinfo,
+							    policy->cpu);
+	struct cpufreq_frequency_table *freq_table;
+	unsigned int j;
+	int rc;
+
+	switch (event) {
+	case CPUFREQ_GOV_START:
+		if (!cpu_online(policy->cpu) || !policy->cur)
+			return -EINVAL;
+
+		freq_table = cpufreq_frequency_get_table(policy->cpu);
+		if (!freq_table)
+			return -EINVAL;
+
+		mutex_lock(&interactive_mutex);
+		ppol->freq_table = freq_table;
+		rc = interactive_alloc_stats(ppol);
+		if (!rc)
+			rc = sysfs_create_group(&policy->kobj,
+						&interactive_attr_group);
+		if (rc) {
+			kfree(ppol->trans);
+			ppol->trans = NULL;
+			mutex_unlock(&interactive_mutex);
+			return rc;
+		}
+
+		if (!tuners_ins.hispeed_freq)
+			tuners_ins.hispeed_freq = policy->max;
+
+		for_each_cpu_mask_nr(j, policy->cpus) {
+			struct cpufreq_interactive_cpuinfo *pcpu =
+				&per_cpu(cpuinfo, j);
+
+			pcpu->policy = policy;
+			pcpu->freq_table = freq_table;
+			pcpu->target_freq = policy->cur;
+			pcpu->floor_freq = pcpu->target_freq;
+			pcpu->floor_validate_time = interactive_now();
+			pcpu->governor_enabled = 1;
+			smp_wmb();
+			pcpu->time_in_idle = get_cpu_idle_time(j,
+						&pcpu->idle_exit_time);
+			pcpu->timer_idlecancel = 0;
+			if (!timer_pending(&pcpu->cpu_timer)) {
+				pcpu->cpu_timer.expires = jiffies +
+					usecs_to_jiffies(tuners_ins.timer_rate);
+				add_timer_on(&pcpu->cpu_timer, j);
+			}
+		}
+
+		if (++active_count == 1) {
+			idle_notifier_register(&cpufreq_interactive_idle_nb);
+			if (input_register_handler(
+					&cpufreq_interactive_input_handler))
+				printk(KERN_WARNING "cpufreq_interactive: "
+				       "input boost not available\n");
+		}
+		mutex_unlock(&interactive_mutex);
+		break;
+
+	case CPUFREQ_GOV_STOP:
+		sysfs_remove_group(&policy->kobj, &interactive_attr_group);
+
+		mutex_lock(&interactive_mutex);
+		for_each_cpu_mask_nr(j, policy->cpus) {
+			struct cpufreq_interactive_cpuinfo *pcpu =
+				&per_cpu(cpuinfo, j);
+
+			pcpu->governor_enabled = 0;
+			smp_wmb();
+			del_timer_sync(&pcpu->cpu_timer);
+		}
+
+		if (--active_count == 0) {
+			input_unregister_handler(
+				&cpufreq_interactive_input_handler);
+			idle_notifier_unregister(&cpufreq_interactive_idle_nb);
+		}
+
+		kfree(ppol->trans);
+		ppol->trans = NULL;
+		mutex_unlock(&interactive_mutex);
+		break;
+
+	case CPUFREQ_GOV_LIMITS:
+		mutex_lock(&interactive_mutex);
+		if (policy->max < policy->cur)
+			__cpufreq_driver_target(policy,
+					policy->max, CPUFREQ_RELATION_H);
+		else if (policy->min > policy->cur)
+			__cpufreq_driver_target(policy,
+					policy->min, CPUFREQ_RELATION_L);
+		mutex_unlock(&interactive_mutex);
+		break;
+	}
+	return 0;
+}
+
+#ifndef CONFIG_CPU_FREQ_DEFAULT_GOV_INTERACTIVE
+static
+#endif
+struct cpufreq_governor cpufreq_gov_interactive = {
+	.name			= "interactive",
+	.governor		= cpufreq_governor_interactive,
+	.max_transition_latency	= TRANSITION_LATENCY_LIMIT,
+	.owner			= THIS_MODULE,
+};
+
+static int __init cpufreq_gov_interactive_init(void)
+{
+	unsigned int i;
+	int err;
+
+	for_each_possible_cpu(i) {
+		struct cpufreq_interactive_cpuinfo *pcpu = &per_cpu(cpuinfo, i);
+
+		init_timer(&pcpu->cpu_timer);
+		pcpu->cpu_timer.function = cpufreq_interactive_timer;
+		pcpu->cpu_timer.data = i;
+	}
+
+	speedchange_wq = create_rt_workqueue("kinteractive");
+	if (!speedchange_wq)
+		return -ENOMEM;
+	INIT_WORK(&speedchange_work, cpufreq_interactive_speedchange);
+
+	err = cpufreq_register_governor(&cpufreq_gov_interactive);
+	if (err)
+		destroy_workqueue(speedchange_wq);
+	return err;
+}
+
+static void __exit cpufreq_gov_interactive_exit(void)
+{
+	cpufreq_unregister_governor(&cpufreq_gov_interactive);
+	destroy_workqueue(speedchange_wq);
+}
+
+MODULE_DESCRIPTION("'cpufreq_interactive' - A cpufreq governor for "
+		"latency sensitive interactive workloads");
+MODULE_LICENSE("GPL");
+
+#ifdef CONFIG_CPU_FREQ_DEFAULT_GOV_INTERACTIVE
+fs_initcall(cpufreq_gov_interactive_init);
+#else
+module_init(cpufreq_gov_interactive_init);
+#endif
+module_exit(cpufreq_gov_interactive_exit);
@@ -0,0 +1,248 @@
+/*
+ *  linux/drivers/cpufreq/cpufreq_task_stats.c
+ *
+ *  Exports the CPU time each process spent at each speed of its CPU, as
+ *  charged by the scheduler in update_curr() to the state kept here in
+ *  cpufreq_task_state. The data is a binary snapshot taken when
+ *  cpufreq/task_time in debugfs is opened, laid out as struct
+ *  task_time_header followed by one struct task_time_record per process
+ *  that has run. See Documentation/cpu-freq/cpufreq-stats.txt.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/cpufreq.h>
+#include <linux/debugfs.h>
+#include <linux/fs.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+
+#define TASK_TIME_MAGIC		0x43465454	/* "CFTT" */
+#define TASK_TIME_VERSION	1
+
+/* Extra records to allocate for processes forked while taking a snapshot */
+#define TASK_TIME_SLACK		32
+
+struct task_time_header {
+	u32 magic;
+	u16 version;
+	u16 nr_states;
+	u32 nr_records;
+	u32 reserved;
+	u32 freq[CPUFREQ_TASK_STATES];	/* kHz, 0 past the last state */
+};
+
+struct task_time_record {
+	u32 tgid;
+	u32 uid;
+	char comm[TASK_COMM_LEN];
+	u64 time[CPUFREQ_TASK_STATES];	/* ns */
+};
+
+struct task_time_snapshot {
+	size_t size;
+	char data[0];
+};
+
+DEFINE_PER_CPU(unsigned int, cpufreq_task_state);
+
+static struct dentry *task_time_dir;
+
+/* Position of @freq among the valid entries of the table of @cpu */
+static unsigned int freq_to_state(unsigned int cpu, unsigned int freq)
+{
+	struct cpufreq_frequency_table *table;
+	unsigned int i, state = 0;
+
+	table = cpufreq_frequency_get_table(cpu);
+	if (!table)
+		return 0;
+
+	for (i = 0; table[i].frequency != CPUFREQ_TABLE_END; i++) {
+		if (table[i].frequency == CPUFREQ_ENTRY_INVALID)
+			continue;
+		if (table[i].frequency == freq)
+			break;
+		state++;
+	}
+	return min(state, (unsigned int)CPUFREQ_TASK_STATES - 1);
+}
+
+static int task_stats_notifier_trans(struct notifier_block *nb,
+				     unsigned long val, void *data)
+{
+	struct cpufreq_freqs *freqs = data;
+
+	if (val == CPUFREQ_POSTCHANGE)
+		per_cpu(cpufreq_task_state, freqs->cpu) =
+			freq_to_state(freqs->cpu, freqs->new);
+	return 0;
+}
+
+static int task_stats_notifier_policy(struct notifier_block *nb,
+				      unsigned long val, void *data)
+{
+	struct cpufreq_policy *policy = data;
+	unsigned int cpu;
+
+	if (val != CPUFREQ_NOTIFY)
+		return 0;
+
+	for_each_cpu_mask_nr(cpu, policy->cpus)
+		per_cpu(cpufreq_task_state, cpu) =
+			freq_to_state(policy->cpu, policy->cur);
+	return 0;
+}
+
+static struct notifier_block notifier_trans_block = {
+	.notifier_call = task_stats_notifier_trans,
+};
+
+static struct notifier_block notifier_policy_block = {
+	.notifier_call = task_stats_notifier_policy,
+};
+
+static void fill_header(struct task_time_header *hdr)
+{
+	struct cpufreq_frequency_table *table;
+	unsigned int i, state = 0;
+
+	hdr->magic = TASK_TIME_MAGIC;
+	hdr->version = TASK_TIME_VERSION;
+	hdr->nr_states = CPUFREQ_TASK_STATES;
+
+	table = cpufreq_frequency_get_table(first_cpu(cpu_online_map));
+	if (!table)
+		return;
+	for (i = 0; table[i].frequency != CPUFREQ_TABLE_END &&
+		    state < CPUFREQ_TASK_STATES; i++) {
+		if (table[i].frequency != CPUFREQ_ENTRY_INVALID)
+			hdr->freq[state++] = table[i].frequency;
+	}
+}
+
+/*
+ * The times of a process are those its dead threads left in its
+ * signal_struct plus those of its live threads. They are read without
+ * synchronizing with the scheduler, so a value may be torn on 32-bit.
+ */
+static int fill_record(struct task_struct *p, struct task_time_record *rec)
+{
+	struct task_struct *t = p;
+	struct cpufreq_task_time sum = p->signal->cpufreq_time;
+	int i;
+
+	do {
+		cpufreq_task_time_add(&sum, &t->cpufreq_time);
+	} while_each_thread(p, t);
+
+	for (i = 0; i < CPUFREQ_TASK_STATES; i++)
+		if (sum.time[i])
+			break;
+	if (i == CPUFREQ_TASK_STATES)
+		return 0;
+
+	rec->tgid = p->tgid;
+	rec->uid = p->uid;
+	get_task_comm(rec->comm, p);
+	memcpy(rec->time, sum.time, sizeof(rec->time));
+	return 1;
+}
+
+static int task_time_open(struct inode *inode, struct file *file)
+{
+	struct task_time_snapshot *snap;
+	struct task_time_header *hdr;
+	struct task_time_record *rec;
+	struct task_struct *p;
+	unsigned int max, n = 0;
+
+	max = nr_processes() + TASK_TIME_SLACK;
+	snap = vmalloc(sizeof(*snap) + sizeof(*hdr) + max * sizeof(*rec));
+	if (!snap)
+		return -ENOMEM;
+
+	hdr = (struct task_time_header *)snap->data;
+	memset(hdr, 0, sizeof(*hdr));
+	fill_header(hdr);
+	rec = (struct task_time_record *)(hdr + 1);
+
+	read_lock(&tasklist_lock);
+	for_each_process(p) {
+		if (n == max)
+			break;
+		if (fill_record(p, &rec[n]))
+			n++;
+	}
+	read_unlock(&tasklist_lock);
+
+	hdr->nr_records = n;
+	snap->size = sizeof(*hdr) + n * sizeof(*rec);
+	file->private_data = snap;
+	return 0;
+}
+
+static ssize_t task_time_read(struct file *file, char __user *buf,
+			      size_t count, loff_t *ppos)
+{
+	struct task_time_snapshot *snap = file->private_data;
+
+	return simple_read_from_buffer(buf, count, ppos, snap->data,
+				       snap->size);
+}
+
+static int task_time_release(struct inode *inode, struct file *file)
+{
+	vfree(file->private_data);
+	return 0;
+}
+
+static const struct file_operations task_time_fops = {
+	.open		= task_time_open,
+	.read		= task_time_read,
+	.llseek		= default_llseek,
+	.release	= task_time_release,
+};
+
+static int __init cpufreq_task_stats_init(void)
+{
+	unsigned int cpu;
+	int ret;
+
+	for_each_online_cpu(cpu)
+		per_cpu(cpufreq_task_state, cpu) =
+			freq_to_state(cpu, cpufreq_quick_get(cpu));
+
+	task_time_dir = debugfs_create_dir("cpufreq", NULL);
+	if (!task_time_dir)
+		return -ENOMEM;
+	if (!debugfs_create_file("task_time", 0400, task_time_dir, NULL,
+				 &task_time_fops)) {
+		debugfs_remove(task_time_dir);
+		return -ENOMEM;
+	}
+
+	ret = cpufreq_register_notifier(&notifier_policy_block,
+					CPUFREQ_POLICY_NOTIFIER);
+	if (ret)
+		goto err;
+	ret = cpufreq_register_notifier(&notifier_trans_block,
+					CPUFREQ_TRANSITION_NOTIFIER);
+	if (ret) {
+		cpufreq_unregister_notifier(&notifier_policy_block,
+					    CPUFREQ_POLICY_NOTIFIER);
+		goto err;
+	}
+	return 0;
+
+err:
+	debugfs_remove_recursive(task_time_dir);
+	return ret;
+}
+late_initcall(cpufreq_task_stats_init);
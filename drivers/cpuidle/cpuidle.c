@@ -172,6 +172,8 @@ int cpuidle_enable_device(struct cpuidle_device *dev)
 	for (i = 0; i < dev->state_count; i++) {
 		dev->states[i].usage = 0;
 		dev->states[i].time = 0;
+		dev->states[i].hits = 0;
+		dev->states[i].misses = 0;
 	}
 	dev->last_residency = 0;
 	dev->last_state = NULL;
@@ -13,11 +13,29 @@
 #include <linux/ktime.h>
 #include <linux/hrtimer.h>
 #include <linux/tick.h>
+#include <linux/math64.h>
 #include <mach/pm.h>
 
 #define BREAK_FUZZ	4	/* 4 us */
 #define PRED_HISTORY_PCT	50
 
+/*
+ * The time to the next timer event overestimates the idle time whenever
+ * an interrupt comes first, and deep states are chosen which are left
+ * before they paid for their exit latency. For each order of magnitude
+ * of the expected time there is a correction factor, a decaying average
+ * of the ratio of measured to expected idle time in fixed point with
+ * RESOLUTION * DECAY standing for 1. The expected time multiplied by the
+ * factor of its bucket is the predicted idle time.
+ *
+ * Idle times of MAX_INTERESTING or more count as a correct prediction,
+ * they are long enough for the deepest state anyway.
+ */
+#define BUCKETS		6
+#define RESOLUTION	1024
+#define DECAY		4
+#define MAX_INTERESTING	50000
+
 struct menu_device {
 	int		last_state_idx;
 
@@ -26,10 +44,29 @@ struct menu_device {
 	unsigned int    current_predicted_us;
 	unsigned int	last_measured_us;
 	unsigned int	elapsed_us;
+
+	unsigned int	corrected_us;
+	int		bucket;
+	unsigned int	correction_factor[BUCKETS];
 };
 
 static DEFINE_PER_CPU(struct menu_device, menu_devices);
 
+static int which_bucket(unsigned int duration)
+{
+	if (duration < 10)
+		return 0;
+	if (duration < 100)
+		return 1;
+	if (duration < 1000)
+		return 2;
+	if (duration < 10000)
+		return 3;
+	if (duration < 100000)
+		return 4;
+	return 5;
+}
+
 /**
  * menu_select - selects the next idle state to enter
  * @dev: the CPU
@@ -42,17 +79,24 @@ static int menu_select(struct cpuidle_device *dev)
 	int device_not_idle;
 	struct timespec t;
 
+	/* determine the expected residency time */
+	t = ktime_to_timespec(tick_nohz_get_sleep_length());
+	data->expected_us =
+		t.tv_sec * USEC_PER_SEC + t.tv_nsec / NSEC_PER_USEC;
+
+	/* and correct it by what we measured the last times */
+	data->bucket = which_bucket(data->expected_us);
+	data->corrected_us = div_u64((u64)data->expected_us *
+				     data->correction_factor[data->bucket] +
+				     RESOLUTION * DECAY / 2,
+				     RESOLUTION * DECAY);
+
 	/* Special case when user has set very strict latency requirement */
 	if (unlikely(latency_req == 0)) {
 		data->last_state_idx = 0;
 		return 0;
 	}
 
-	/* determine the expected residency time */
-	t = ktime_to_timespec(tick_nohz_get_sleep_length());
-	data->expected_us =
-		t.tv_sec * USEC_PER_SEC + t.tv_nsec / NSEC_PER_USEC;
-
 	device_not_idle = !pm_check_idle();
 
 	/* Recalculate predicted_us based on prediction_history_pct */
@@ -67,6 +111,8 @@ static int menu_select(struct cpuidle_device *dev)
 
 		if (s->target_residency > data->expected_us)
 			break;
+		if (s->target_residency > data->corrected_us)
+			break;
 		if (device_not_idle &&
 		    s->target_residency > data->predicted_us)
 			break;
@@ -78,6 +124,29 @@ static int menu_select(struct cpuidle_device *dev)
 	return i - 1;
 }
 
+/**
+ * menu_update - learns from the idle time measured after a prediction
+ * @data: the governor data of the CPU
+ * @measured_us: time spent idle, without the exit latency
+ */
+static void menu_update(struct menu_device *data, unsigned int measured_us)
+{
+	unsigned int new_factor = data->correction_factor[data->bucket];
+
+	new_factor -= new_factor / DECAY;
+
+	if (data->expected_us > 0 && measured_us < MAX_INTERESTING)
+		new_factor += RESOLUTION * measured_us / data->expected_us;
+	else
+		new_factor += RESOLUTION;
+
+	/* a factor of 0 would never come back up */
+	if (new_factor == 0)
+		new_factor = 1;
+
+	data->correction_factor[data->bucket] = new_factor;
+}
+
 /**
  * menu_reflect - attempts to guess what happened after entry
  * @dev: the CPU
@@ -93,6 +162,23 @@ static void menu_reflect(struct cpuidle_device *dev)
 	struct cpuidle_state *target = &dev->states[last_idx];
 	unsigned int measured_us;
 
+	/*
+	 * A state is hit when it was left no earlier than its target
+	 * residency, that is when entering it paid off. Only states that
+	 * measure their residency teach the correction factors.
+	 */
+	if (likely(target->flags & CPUIDLE_FLAG_TIME_VALID)) {
+		if (last_idle_us >= target->target_residency)
+			target->hits++;
+		else
+			target->misses++;
+
+		if (last_idle_us > target->exit_latency)
+			menu_update(data, last_idle_us - target->exit_latency);
+		else
+			menu_update(data, 0);
+	}
+
 	/*
 	 * Ugh, this idle state doesn't support residency measurements, so we
 	 * are basically lost in the dark.  As a compromise, assume we slept
@@ -130,9 +216,14 @@ static void menu_reflect(struct cpuidle_device *dev)
 static int menu_enable_device(struct cpuidle_device *dev)
 {
 	struct menu_device *data = &per_cpu(menu_devices, dev->cpu);
+	int i;
 
 	memset(data, 0, sizeof(struct menu_device));
 
+	/* start out trusting the next timer event */
+	for (i = 0; i < BUCKETS; i++)
+		data->correction_factor[i] = RESOLUTION * DECAY;
+
 	return 0;
 }
 
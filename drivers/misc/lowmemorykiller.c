@@ -23,7 +23,9 @@ static int lowmem_shrink(int nr_to_scan, gfp_t gfp_mask);
 
 static struct shrinker lowmem_shrinker = {
 	.shrink = lowmem_shrink,
-	.seeks = DEFAULT_SEEKS * 16
+	.seeks = DEFAULT_SEEKS * 16,
+	/* Every call walks all tasks, so have fewer calls scan more */
+	.batch = 512
 };
 static uint32_t lowmem_debug_level = 2;
 static int lowmem_adj[6] = {
@@ -44,6 +46,7 @@ static int lowmem_minfree_size = 4;
 #define lowmem_print(level, x...) do { if(lowmem_debug_level >= (level)) printk(x); } while(0)
 
 module_param_named(cost, lowmem_shrinker.seeks, int, S_IRUGO | S_IWUSR);
+module_param_named(batch, lowmem_shrinker.batch, int, S_IRUGO | S_IWUSR);
 module_param_array_named(adj, lowmem_adj, int, &lowmem_adj_size, S_IRUGO | S_IWUSR);
 module_param_array_named(minfree, lowmem_minfree, uint, &lowmem_minfree_size, S_IRUGO | S_IWUSR);
 module_param_named(debug_level, lowmem_debug_level, uint, S_IRUGO | S_IWUSR);
@@ -962,7 +962,7 @@ static int onenand_read_oob_nolock(struct mtd_info *mtd, loff_t from,
 	size_t len = ops->ooblen;
 	mtd_oob_mode_t mode = ops->mode;
 	u_char *buf = ops->oobbuf;
-	int ret = 0;
+	int ret = 0, boundary;
 
 	from += ops->ooboffs;
 
@@ -993,22 +993,43 @@ static int onenand_read_oob_nolock(struct mtd_info *mtd, loff_t from,
 
 	stats = mtd->ecc_stats;
 
-	while (read < len) {
-		cond_resched();
-
-		thislen = oobsize - column;
-		thislen = min_t(int, thislen, len);
-
-		this->command(mtd, ONENAND_CMD_READOOB, from, mtd->oobsize);
+	/* Read-while-load method */
 
-		onenand_update_bufferram(mtd, from, 0);
+	/* Do first load to bufferRAM */
+	this->command(mtd, ONENAND_CMD_READOOB, from, mtd->oobsize);
+	onenand_update_bufferram(mtd, from, 0);
+	ret = this->wait(mtd, FL_READING);
 
-		ret = this->wait(mtd, FL_READING);
+	while (1) {
 		if (ret && ret != -EBADMSG) {
 			printk(KERN_ERR "onenand_read_oob_nolock: read failed = 0x%x\n", ret);
 			break;
 		}
 
+		thislen = oobsize - column;
+		thislen = min_t(int, thislen, len - read);
+
+		/* If there is more to load then start next load */
+		boundary = 0;
+		if (read + thislen < len) {
+			from += mtd->writesize;
+			this->command(mtd, ONENAND_CMD_READOOB, from, mtd->oobsize);
+			onenand_update_bufferram(mtd, from, 0);
+			/*
+			 * Chip boundary handling in DDP, see
+			 * onenand_read_ops_nolock. from still holds the
+			 * OOB column, compare its page.
+			 */
+			if (ONENAND_IS_DDP(this) &&
+			    unlikely((from & ~(loff_t)(mtd->writesize - 1)) ==
+				     (this->chipsize >> 1))) {
+				this->write_word(ONENAND_DDP_CHIP0, this->base + ONENAND_REG_START_ADDRESS2);
+				boundary = 1;
+			}
+			ONENAND_SET_PREV_BUFFERRAM(this);
+		}
+
+		/* While load is going, read from last bufferRAM */
 		if (mode == MTD_OOB_AUTO)
 			onenand_transfer_auto_oob(mtd, buf, column, thislen);
 		else
@@ -1019,14 +1040,15 @@ static int onenand_read_oob_nolock(struct mtd_info *mtd, loff_t from,
 		if (read == len)
 			break;
 
+		/* Set up for next read from bufferRAM */
+		if (unlikely(boundary))
+			this->write_word(ONENAND_DDP_CHIP1, this->base + ONENAND_REG_START_ADDRESS2);
+		ONENAND_SET_NEXT_BUFFERRAM(this);
 		buf += thislen;
-
-		/* Read more? */
-		if (read < len) {
-			/* Page size */
-			from += mtd->writesize;
-			column = 0;
-		}
+		column = 0;
+		cond_resched();
+		/* Now wait for load */
+		ret = this->wait(mtd, FL_READING);
 	}
 
 	ops->oobretlen = read;
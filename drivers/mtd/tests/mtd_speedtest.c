@@ -0,0 +1,402 @@
+/*
+ * MTD throughput test.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; see the file COPYING. If not, write to the Free Software
+ * Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ * The test erases, writes and reads the MTD device eraseblock by eraseblock,
+ * page by page, and two pages at a time, and prints the throughput of each
+ * pass. It also reads the OOB area of whole eraseblocks. All data on the
+ * device is destroyed, so without real hardware run it against the OneNAND
+ * simulator:
+ *
+ *	modprobe onenand_sim
+ *	modprobe mtd_speedtest dev=<number of the simulator MTD device>
+ */
+
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/err.h>
+#include <linux/mtd/mtd.h>
+#include <linux/sched.h>
+#include <linux/ktime.h>
+#include <linux/random.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+
+#define PRINT_PREF KERN_INFO "mtd_speedtest: "
+
+static int dev;
+module_param(dev, int, S_IRUGO);
+MODULE_PARM_DESC(dev, "MTD device number to use");
+
+static int count;
+module_param(count, int, S_IRUGO);
+MODULE_PARM_DESC(count, "Maximum number of eraseblocks to use "
+			"(0 means use all)");
+
+static struct mtd_info *mtd;
+static unsigned char *iobuf;
+static unsigned char *bbt;
+
+static int pgsize;
+static int ebcnt;
+static int pgcnt;
+static int goodebcnt;
+static ktime_t start;
+
+static int erase_eraseblock(int ebnum)
+{
+	int err;
+	struct erase_info ei;
+	loff_t addr = (loff_t)ebnum * mtd->erasesize;
+
+	memset(&ei, 0, sizeof(struct erase_info));
+	ei.mtd  = mtd;
+	ei.addr = addr;
+	ei.len  = mtd->erasesize;
+
+	err = mtd->erase(mtd, &ei);
+	if (err) {
+		printk(PRINT_PREF "error %d while erasing EB %d\n", err, ebnum);
+		return err;
+	}
+
+	if (ei.state == MTD_ERASE_FAILED) {
+		printk(PRINT_PREF "some erase error occurred at EB %d\n",
+		       ebnum);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static int erase_whole_device(void)
+{
+	int err, i;
+
+	for (i = 0; i < ebcnt; ++i) {
+		if (bbt[i])
+			continue;
+		err = erase_eraseblock(i);
+		if (err)
+			return err;
+		cond_resched();
+	}
+	return 0;
+}
+
+static int write_eraseblock(int ebnum)
+{
+	size_t written = 0;
+	int err;
+	loff_t addr = (loff_t)ebnum * mtd->erasesize;
+
+	err = mtd->write(mtd, addr, mtd->erasesize, &written, iobuf);
+	if (err || written != mtd->erasesize) {
+		printk(PRINT_PREF "error: write failed at %#llx\n",
+		       (unsigned long long)addr);
+		return err ? err : -EIO;
+	}
+
+	return 0;
+}
+
+static int write_eraseblock_by_page(int ebnum)
+{
+	size_t written = 0;
+	int i, err;
+	loff_t addr = (loff_t)ebnum * mtd->erasesize;
+	void *buf = iobuf;
+
+	for (i = 0; i < pgcnt; i++) {
+		err = mtd->write(mtd, addr, pgsize, &written, buf);
+		if (err || written != pgsize) {
+			printk(PRINT_PREF "error: write failed at %#llx\n",
+			       (unsigned long long)addr);
+			return err ? err : -EIO;
+		}
+		addr += pgsize;
+		buf += pgsize;
+	}
+
+	return 0;
+}
+
+/*
+ * Read errors are reported, but -EUCLEAN (corrected bit-flips) is not a
+ * failure of the read itself.
+ */
+static int check_read(int err, size_t read, size_t len, loff_t addr)
+{
+	if (err == -EUCLEAN)
+		err = 0;
+	if (err || read != len) {
+		printk(PRINT_PREF "error: read failed at %#llx\n",
+		       (unsigned long long)addr);
+		return err ? err : -EIO;
+	}
+	return 0;
+}
+
+static int read_eraseblock(int ebnum)
+{
+	size_t read = 0;
+	int err;
+	loff_t addr = (loff_t)ebnum * mtd->erasesize;
+
+	err = mtd->read(mtd, addr, mtd->erasesize, &read, iobuf);
+	return check_read(err, read, mtd->erasesize, addr);
+}
+
+static int read_eraseblock_by_page(int ebnum)
+{
+	size_t read = 0;
+	int i, err;
+	loff_t addr = (loff_t)ebnum * mtd->erasesize;
+	void *buf = iobuf;
+
+	for (i = 0; i < pgcnt; i++) {
+		err = mtd->read(mtd, addr, pgsize, &read, buf);
+		err = check_read(err, read, pgsize, addr);
+		if (err)
+			return err;
+		addr += pgsize;
+		buf += pgsize;
+	}
+
+	return 0;
+}
+
+static int read_eraseblock_by_2pages(int ebnum)
+{
+	size_t read = 0, sz = pgsize * 2;
+	int i, n = pgcnt / 2, err;
+	loff_t addr = (loff_t)ebnum * mtd->erasesize;
+	void *buf = iobuf;
+
+	for (i = 0; i < n; i++) {
+		err = mtd->read(mtd, addr, sz, &read, buf);
+		err = check_read(err, read, sz, addr);
+		if (err)
+			return err;
+		addr += sz;
+		buf += sz;
+	}
+	if (pgcnt % 2) {
+		err = mtd->read(mtd, addr, pgsize, &read, buf);
+		err = check_read(err, read, pgsize, addr);
+		if (err)
+			return err;
+	}
+
+	return 0;
+}
+
+static int read_eraseblock_oob(int ebnum)
+{
+	int err;
+	struct mtd_oob_ops ops;
+	loff_t addr = (loff_t)ebnum * mtd->erasesize;
+
+	ops.mode      = MTD_OOB_RAW;
+	ops.len       = 0;
+	ops.retlen    = 0;
+	ops.ooblen    = mtd->oobsize * pgcnt;
+	ops.oobretlen = 0;
+	ops.ooboffs   = 0;
+	ops.datbuf    = NULL;
+	ops.oobbuf    = iobuf;
+
+	err = mtd->read_oob(mtd, addr, &ops);
+	return check_read(err, ops.oobretlen, ops.ooblen, addr);
+}
+
+static inline void start_timing(void)
+{
+	start = ktime_get();
+}
+
+/* Prints the throughput of the pass which was started by 'start_timing()' */
+static void stop_timing(const char *name, long long bytes)
+{
+	s64 us = ktime_to_us(ktime_sub(ktime_get(), start));
+	long long kib = bytes >> 10;
+
+	if (us < 1)
+		us = 1;
+	printk(PRINT_PREF "%s speed is %llu KiB/s (%lld KiB in %lld us)\n",
+	       name, (unsigned long long)div64_u64(kib * USEC_PER_SEC, us),
+	       kib, (long long)us);
+}
+
+/* Runs @fn for all good eraseblocks and prints the throughput */
+static int run_pass(const char *name, int (*fn)(int ebnum), int bytes_per_eb)
+{
+	int err, i;
+
+	start_timing();
+	for (i = 0; i < ebcnt; ++i) {
+		if (bbt[i])
+			continue;
+		err = fn(i);
+		if (err)
+			return err;
+		cond_resched();
+	}
+	stop_timing(name, (long long)goodebcnt * bytes_per_eb);
+	return 0;
+}
+
+static int scan_for_bad_eraseblocks(void)
+{
+	int i, bad = 0;
+
+	bbt = kzalloc(ebcnt, GFP_KERNEL);
+	if (!bbt) {
+		printk(PRINT_PREF "error: cannot allocate memory\n");
+		return -ENOMEM;
+	}
+
+	/* NOR flash does not implement block_isbad */
+	if (mtd->block_isbad == NULL)
+		goto out;
+
+	printk(PRINT_PREF "scanning for bad eraseblocks\n");
+	for (i = 0; i < ebcnt; ++i) {
+		bbt[i] = mtd->block_isbad(mtd,
+					  (loff_t)i * mtd->erasesize) ? 1 : 0;
+		if (bbt[i])
+			bad += 1;
+		cond_resched();
+	}
+	printk(PRINT_PREF "scanned %d eraseblocks, %d are bad\n", i, bad);
+out:
+	goodebcnt = ebcnt - bad;
+	return 0;
+}
+
+static int __init mtd_speedtest_init(void)
+{
+	int err, i;
+	uint64_t tmp;
+
+	printk(KERN_INFO "\n");
+	printk(KERN_INFO "=================================================\n");
+	printk(PRINT_PREF "MTD device: %d\n", dev);
+
+	mtd = get_mtd_device(NULL, dev);
+	if (IS_ERR(mtd)) {
+		err = PTR_ERR(mtd);
+		printk(PRINT_PREF "error: cannot get MTD device\n");
+		return err;
+	}
+
+	if (mtd->writesize == 1) {
+		printk(PRINT_PREF "not NAND flash, assume page size is 512 "
+		       "bytes.\n");
+		pgsize = 512;
+	} else
+		pgsize = mtd->writesize;
+
+	tmp = mtd->size;
+	do_div(tmp, mtd->erasesize);
+	ebcnt = tmp;
+	if (count > 0 && count < ebcnt)
+		ebcnt = count;
+	pgcnt = mtd->erasesize / pgsize;
+
+	printk(PRINT_PREF "MTD device size %llu, eraseblock size %u, "
+	       "page size %u, count of eraseblocks %u, pages per "
+	       "eraseblock %u, OOB size %u\n",
+	       (unsigned long long)mtd->size, mtd->erasesize,
+	       pgsize, ebcnt, pgcnt, mtd->oobsize);
+
+	err = -ENOMEM;
+	iobuf = vmalloc(mtd->erasesize);
+	if (!iobuf) {
+		printk(PRINT_PREF "error: cannot allocate memory\n");
+		goto out;
+	}
+
+	for (i = 0; i < mtd->erasesize; ++i)
+		iobuf[i] = random32();
+
+	err = scan_for_bad_eraseblocks();
+	if (err)
+		goto out;
+
+	/* Erase all eraseblocks */
+	err = run_pass("erase", erase_eraseblock, mtd->erasesize);
+	if (err)
+		goto out;
+
+	/* Write and read whole eraseblocks */
+	err = run_pass("eraseblock write", write_eraseblock, mtd->erasesize);
+	if (err)
+		goto out;
+
+	err = run_pass("eraseblock read", read_eraseblock, mtd->erasesize);
+	if (err)
+		goto out;
+
+	err = erase_whole_device();
+	if (err)
+		goto out;
+
+	/* Write and read page by page */
+	err = run_pass("page write", write_eraseblock_by_page,
+		       mtd->erasesize);
+	if (err)
+		goto out;
+
+	err = run_pass("page read", read_eraseblock_by_page, mtd->erasesize);
+	if (err)
+		goto out;
+
+	/* Read two pages at a time */
+	err = run_pass("2 page read", read_eraseblock_by_2pages,
+		       mtd->erasesize);
+	if (err)
+		goto out;
+
+	/* Read the OOB area of whole eraseblocks */
+	if (mtd->oobsize && mtd->read_oob &&
+	    mtd->oobsize * pgcnt <= mtd->erasesize) {
+		err = run_pass("eraseblock OOB read", read_eraseblock_oob,
+			       mtd->oobsize * pgcnt);
+		if (err)
+			goto out;
+	}
+
+	printk(PRINT_PREF "finished\n");
+out:
+	kfree(bbt);
+	vfree(iobuf);
+	put_mtd_device(mtd);
+	if (err)
+		printk(PRINT_PREF "error %d occurred\n", err);
+	printk(KERN_INFO "=================================================\n");
+	return err;
+}
+module_init(mtd_speedtest_init);
+
+static void __exit mtd_speedtest_exit(void)
+{
+	return;
+}
+module_exit(mtd_speedtest_exit);
+
+MODULE_DESCRIPTION("MTD throughput test module");
+MODULE_LICENSE("GPL");
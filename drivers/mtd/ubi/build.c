@@ -120,6 +120,14 @@ static struct device_attribute dev_bgt_enabled =
 	__ATTR(bgt_enabled, S_IRUGO, dev_attribute_show, NULL);
 static struct device_attribute dev_mtd_num =
 	__ATTR(mtd_num, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_free_peb_count =
+	__ATTR(free_peb_count, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_peb_wait_count =
+	__ATTR(peb_wait_count, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_peb_wait_time =
+	__ATTR(peb_wait_time, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_peb_wait_max =
+	__ATTR(peb_wait_max, S_IRUGO, dev_attribute_show, NULL);
 
 /**
  * ubi_get_device - get UBI device.
@@ -256,6 +264,14 @@ static ssize_t dev_attribute_show(struct device *dev,
 		ret = sprintf(buf, "%d\n", ubi->thread_enabled);
 	else if (attr == &dev_mtd_num)
 		ret = sprintf(buf, "%d\n", ubi->mtd->index);
+	else if (attr == &dev_free_peb_count)
+		ret = sprintf(buf, "%d\n", ubi->free_count);
+	else if (attr == &dev_peb_wait_count)
+		ret = sprintf(buf, "%lu\n", ubi->peb_waits);
+	else if (attr == &dev_peb_wait_time)
+		ret = sprintf(buf, "%llu\n", ubi->peb_wait_time);
+	else if (attr == &dev_peb_wait_max)
+		ret = sprintf(buf, "%lu\n", ubi->peb_wait_max);
 	else
 		ret = -EINVAL;
 
@@ -316,6 +332,18 @@ static int ubi_sysfs_init(struct ubi_device *ubi)
 	if (err)
 		return err;
 	err = device_create_file(&ubi->dev, &dev_mtd_num);
+	if (err)
+		return err;
+	err = device_create_file(&ubi->dev, &dev_free_peb_count);
+	if (err)
+		return err;
+	err = device_create_file(&ubi->dev, &dev_peb_wait_count);
+	if (err)
+		return err;
+	err = device_create_file(&ubi->dev, &dev_peb_wait_time);
+	if (err)
+		return err;
+	err = device_create_file(&ubi->dev, &dev_peb_wait_max);
 	return err;
 }
 
@@ -325,6 +353,10 @@ static int ubi_sysfs_init(struct ubi_device *ubi)
  */
 static void ubi_sysfs_close(struct ubi_device *ubi)
 {
+	device_remove_file(&ubi->dev, &dev_peb_wait_max);
+	device_remove_file(&ubi->dev, &dev_peb_wait_time);
+	device_remove_file(&ubi->dev, &dev_peb_wait_count);
+	device_remove_file(&ubi->dev, &dev_free_peb_count);
 	device_remove_file(&ubi->dev, &dev_mtd_num);
 	device_remove_file(&ubi->dev, &dev_bgt_enabled);
 	device_remove_file(&ubi->dev, &dev_min_io_size);
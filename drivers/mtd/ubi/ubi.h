@@ -341,13 +341,15 @@ struct ubi_wl_entry;
  * @used: RB-tree of used physical eraseblocks
  * @erroneous: RB-tree of erroneous used physical eraseblocks
  * @free: RB-tree of free physical eraseblocks
+ * @free_count: count of physical eraseblocks in @free
  * @scrub: RB-tree of physical eraseblocks which need scrubbing
  * @pq: protection queue (contain physical eraseblocks which are temporarily
  *      protected from the wear-leveling worker)
  * @pq_head: protection queue head
- * @wl_lock: protects the @used, @free, @pq, @pq_head, @lookuptbl, @move_from,
- * 	     @move_to, @move_to_put @erase_pending, @wl_scheduled, @works,
- * 	     @erroneous, and @erroneous_peb_count fields
+ * @wl_lock: protects the @used, @free, @free_count, @pq, @pq_head, @lookuptbl,
+ * 	     @move_from, @move_to, @move_to_put @erase_pending, @wl_scheduled,
+ * 	     @works, @erroneous, @erroneous_peb_count, and the @peb_waits,
+ * 	     @peb_wait_time and @peb_wait_max fields
  * @move_mutex: serializes eraseblock moves
  * @work_sem: synchronizes the WL worker with use tasks
  * @wl_scheduled: non-zero if the wear-leveling was scheduled
@@ -361,6 +363,12 @@ struct ubi_wl_entry;
  * @bgt_thread: background thread description object
  * @thread_enabled: if the background thread is enabled
  * @bgt_name: background thread name
+ * @peb_waits: how many times 'ubi_wl_get_peb()' found no free physical
+ *             eraseblocks and had to do pending works synchronously
+ * @peb_wait_time: total time spent waiting for free physical eraseblocks
+ *                 (microseconds)
+ * @peb_wait_max: the longest wait for a free physical eraseblock
+ *                (microseconds)
  *
  * @flash_size: underlying MTD device size (in bytes)
  * @peb_count: count of physical eraseblocks on the MTD device
@@ -431,6 +439,7 @@ struct ubi_device {
 	struct rb_root used;
 	struct rb_root erroneous;
 	struct rb_root free;
+	int free_count;
 	struct rb_root scrub;
 	struct list_head pq[UBI_PROT_QUEUE_LEN];
 	int pq_head;
@@ -447,6 +456,9 @@ struct ubi_device {
 	struct task_struct *bgt_thread;
 	int thread_enabled;
 	char bgt_name[sizeof(UBI_BGT_NAME_PATTERN)+2];
+	unsigned long peb_waits;
+	unsigned long long peb_wait_time;
+	unsigned long peb_wait_max;
 
 	/* I/O sub-system's stuff */
 	long long flash_size;
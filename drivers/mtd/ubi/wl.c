@@ -109,6 +109,7 @@
 #include <linux/crc32.h>
 #include <linux/freezer.h>
 #include <linux/kthread.h>
+#include <linux/ktime.h>
 #include "ubi.h"
 
 /* Number of physical eraseblocks reserved for wear-leveling purposes */
@@ -135,6 +136,14 @@
  */
 #define WL_FREE_MAX_DIFF (2*UBI_WL_THRESHOLD)
 
+/*
+ * If there are fewer than this number of free (erased) physical eraseblocks,
+ * erase works are put to the head of the pending works queue instead of the
+ * tail, so that the background thread refills the pool of free physical
+ * eraseblocks before it does anything else (e.g., wear-leveling copies).
+ */
+#define WL_FREE_RESERVE CONFIG_MTD_UBI_FREE_RESERVE
+
 /*
  * Maximum number of consecutive background thread failures which is enough to
  * switch to read-only mode.
@@ -395,6 +404,9 @@ int ubi_wl_get_peb(struct ubi_device *ubi, int dtype)
 retry:
 	spin_lock(&ubi->wl_lock);
 	if (!ubi->free.rb_node) {
+		ktime_t start;
+		unsigned long us;
+
 		if (ubi->works_count == 0) {
 			ubi_assert(list_empty(&ubi->works));
 			ubi_err("no free eraseblocks");
@@ -403,7 +415,18 @@ retry:
 		}
 		spin_unlock(&ubi->wl_lock);
 
+		start = ktime_get();
 		err = produce_free_peb(ubi);
+		us = ktime_us_delta(ktime_get(), start);
+
+		spin_lock(&ubi->wl_lock);
+		ubi->peb_waits += 1;
+		ubi->peb_wait_time += us;
+		if (us > ubi->peb_wait_max)
+			ubi->peb_wait_max = us;
+		spin_unlock(&ubi->wl_lock);
+		dbg_wl("waited %lu us for a free PEB", us);
+
 		if (err < 0)
 			return err;
 		goto retry;
@@ -456,6 +479,7 @@ retry:
 	 * be protected from being moved for some time.
 	 */
 	rb_erase(&e->u.rb, &ubi->free);
+	ubi->free_count -= 1;
 	dbg_wl("PEB %d EC %d", e->pnum, e->ec);
 	prot_queue_add(ubi, e);
 	spin_unlock(&ubi->wl_lock);
@@ -591,18 +615,26 @@ repeat:
 	spin_unlock(&ubi->wl_lock);
 }
 
+static int erase_worker(struct ubi_device *ubi, struct ubi_work *wl_wrk,
+			int cancel);
+
 /**
  * schedule_ubi_work - schedule a work.
  * @ubi: UBI device description object
  * @wrk: the work to schedule
  *
  * This function adds a work defined by @wrk to the tail of the pending works
- * list.
+ * list. However, if the pool of free physical eraseblocks is running low,
+ * erase works are added to the head of the list, so that they are done before
+ * wear-leveling works which would consume free physical eraseblocks instead.
  */
 static void schedule_ubi_work(struct ubi_device *ubi, struct ubi_work *wrk)
 {
 	spin_lock(&ubi->wl_lock);
-	list_add_tail(&wrk->list, &ubi->works);
+	if (wrk->func == &erase_worker && ubi->free_count < WL_FREE_RESERVE)
+		list_add(&wrk->list, &ubi->works);
+	else
+		list_add_tail(&wrk->list, &ubi->works);
 	ubi_assert(ubi->works_count >= 0);
 	ubi->works_count += 1;
 	if (ubi->thread_enabled)
@@ -610,9 +642,6 @@ static void schedule_ubi_work(struct ubi_device *ubi, struct ubi_work *wrk)
 	spin_unlock(&ubi->wl_lock);
 }
 
-static int erase_worker(struct ubi_device *ubi, struct ubi_work *wl_wrk,
-			int cancel);
-
 /**
  * schedule_erase - schedule an erase work.
  * @ubi: UBI device description object
@@ -719,6 +748,7 @@ static int wear_leveling_worker(struct ubi_device *ubi, struct ubi_work *wrk,
 
 	paranoid_check_in_wl_tree(e2, &ubi->free);
 	rb_erase(&e2->u.rb, &ubi->free);
+	ubi->free_count -= 1;
 	ubi->move_from = e1;
 	ubi->move_to = e2;
 	spin_unlock(&ubi->wl_lock);
@@ -998,6 +1028,7 @@ static int erase_worker(struct ubi_device *ubi, struct ubi_work *wl_wrk,
 
 		spin_lock(&ubi->wl_lock);
 		wl_tree_add(e, &ubi->free);
+		ubi->free_count += 1;
 		spin_unlock(&ubi->wl_lock);
 
 		/*
@@ -1396,6 +1427,7 @@ int ubi_wl_init_scan(struct ubi_device *ubi, struct ubi_scan_info *si)
 	struct ubi_wl_entry *e;
 
 	ubi->used = ubi->erroneous = ubi->free = ubi->scrub = RB_ROOT;
+	ubi->free_count = 0;
 	spin_lock_init(&ubi->wl_lock);
 	mutex_init(&ubi->move_mutex);
 	init_rwsem(&ubi->work_sem);
@@ -1440,6 +1472,7 @@ int ubi_wl_init_scan(struct ubi_device *ubi, struct ubi_scan_info *si)
 		e->ec = seb->ec;
 		ubi_assert(e->ec >= 0);
 		wl_tree_add(e, &ubi->free);
+		ubi->free_count += 1;
 		ubi->lookuptbl[e->pnum] = e;
 	}
 
@@ -1236,6 +1236,7 @@ static int fuse_page_mkwrite(struct vm_area_struct *vma, struct page *page)
 static struct vm_operations_struct fuse_file_vm_ops = {
 	.close		= fuse_vma_close,
 	.fault		= filemap_fault,
+	.map_pages	= filemap_map_pages,
 	.page_mkwrite	= fuse_page_mkwrite,
 };
 
@@ -1052,6 +1052,61 @@ static const struct file_operations proc_oom_adjust_operations = {
 	.write		= oom_adjust_write,
 };
 
+static ssize_t latency_nice_read(struct file *file, char __user *buf,
+				 size_t count, loff_t *ppos)
+{
+	struct task_struct *task = get_proc_task(file->f_path.dentry->d_inode);
+	char buffer[PROC_NUMBUF];
+	size_t len;
+	int latency_nice;
+
+	if (!task)
+		return -ESRCH;
+	latency_nice = task->se.latency_nice;
+	put_task_struct(task);
+
+	len = snprintf(buffer, sizeof(buffer), "%i\n", latency_nice);
+
+	return simple_read_from_buffer(buf, count, ppos, buffer, len);
+}
+
+static ssize_t latency_nice_write(struct file *file, const char __user *buf,
+				  size_t count, loff_t *ppos)
+{
+	struct task_struct *task;
+	char buffer[PROC_NUMBUF], *end;
+	int latency_nice, err;
+
+	memset(buffer, 0, sizeof(buffer));
+	if (count > sizeof(buffer) - 1)
+		count = sizeof(buffer) - 1;
+	if (copy_from_user(buffer, buf, count))
+		return -EFAULT;
+	latency_nice = simple_strtol(buffer, &end, 0);
+	if (*end == '\n')
+		end++;
+	if (end - buffer == 0)
+		return -EIO;
+	task = get_proc_task(file->f_path.dentry->d_inode);
+	if (!task)
+		return -ESRCH;
+	err = sched_set_latency_nice(task, latency_nice);
+	put_task_struct(task);
+	if (err)
+		return err;
+	return end - buffer;
+}
+
+/* System Server sets the latency-nice of application threads like oom_adj */
+static const struct inode_operations proc_latency_nice_inode_operations = {
+	.permission	= oom_adjust_permission,
+};
+
+static const struct file_operations proc_latency_nice_operations = {
+	.read		= latency_nice_read,
+	.write		= latency_nice_write,
+};
+
 #ifdef CONFIG_AUDITSYSCALL
 #define TMPBUFLEN 21
 static ssize_t proc_loginuid_read(struct file * file, char __user * buf,
@@ -2451,6 +2506,39 @@ static int proc_tgid_io_accounting(struct task_struct *task, char *buffer)
 }
 #endif /* CONFIG_TASK_IO_ACCOUNTING */
 
+static int do_reclaim_stall(struct task_struct *task, char *buffer, int whole)
+{
+	struct reclaim_stall stall = task->reclaim_stall;
+	unsigned long flags;
+
+	if (whole && lock_task_sighand(task, &flags)) {
+		struct task_struct *t = task;
+
+		reclaim_stall_add(&stall, &task->signal->reclaim_stall);
+		while_each_thread(task, t)
+			reclaim_stall_add(&stall, &t->reclaim_stall);
+
+		unlock_task_sighand(task, &flags);
+	}
+	return sprintf(buffer,
+			"count: %lu\n"
+			"total_us: %llu\n"
+			"max_us: %llu\n",
+			stall.count,
+			(unsigned long long)div_u64(stall.total_ns, NSEC_PER_USEC),
+			(unsigned long long)div_u64(stall.max_ns, NSEC_PER_USEC));
+}
+
+static int proc_tid_reclaim_stall(struct task_struct *task, char *buffer)
+{
+	return do_reclaim_stall(task, buffer, 0);
+}
+
+static int proc_tgid_reclaim_stall(struct task_struct *task, char *buffer)
+{
+	return do_reclaim_stall(task, buffer, 1);
+}
+
 static int proc_pid_personality(struct seq_file *m, struct pid_namespace *ns,
 				struct pid *pid, struct task_struct *task)
 {
@@ -2521,6 +2609,7 @@ static const struct pid_entry tgid_base_stuff[] = {
 #endif
 	INF("oom_score",  S_IRUGO, oom_score),
 	ANDROID("oom_adj",    S_IRUGO|S_IWUSR, oom_adjust),
+	ANDROID("latency_nice", S_IRUGO|S_IWUSR, latency_nice),
 #ifdef CONFIG_AUDITSYSCALL
 	REG("loginuid",   S_IWUSR|S_IRUGO, loginuid),
 	REG("sessionid",  S_IRUGO, sessionid),
@@ -2534,6 +2623,7 @@ static const struct pid_entry tgid_base_stuff[] = {
 #ifdef CONFIG_TASK_IO_ACCOUNTING
 	INF("io",	S_IRUGO, tgid_io_accounting),
 #endif
+	INF("reclaim_stall", S_IRUGO, tgid_reclaim_stall),
 };
 
 static int proc_tgid_base_readdir(struct file * filp,
@@ -2856,6 +2946,7 @@ static const struct pid_entry tid_base_stuff[] = {
 #endif
 	INF("oom_score", S_IRUGO, oom_score),
 	REG("oom_adj",   S_IRUGO|S_IWUSR, oom_adjust),
+	ANDROID("latency_nice", S_IRUGO|S_IWUSR, latency_nice),
 #ifdef CONFIG_AUDITSYSCALL
 	REG("loginuid",  S_IWUSR|S_IRUGO, loginuid),
 	REG("sessionid",  S_IRUSR, sessionid),
@@ -2866,6 +2957,7 @@ static const struct pid_entry tid_base_stuff[] = {
 #ifdef CONFIG_TASK_IO_ACCOUNTING
 	INF("io",	S_IRUGO, tid_io_accounting),
 #endif
+	INF("reclaim_stall", S_IRUGO, tid_reclaim_stall),
 };
 
 static int proc_tid_base_readdir(struct file * filp,
@@ -5,6 +5,7 @@
 #include <linux/mm.h>
 #include <linux/mman.h>
 #include <linux/mmzone.h>
+#include <linux/prezero.h>
 #include <linux/proc_fs.h>
 #include <linux/quicklist.h>
 #include <linux/seq_file.h>
@@ -86,6 +87,9 @@ static int meminfo_proc_show(struct seq_file *m, void *v)
 		"PageTables:     %8lu kB\n"
 #ifdef CONFIG_QUICKLIST
 		"Quicklists:     %8lu kB\n"
+#endif
+#ifdef CONFIG_PREZERO_PAGES
+		"PreZeroed:      %8lu kB\n"
 #endif
 		"NFS_Unstable:   %8lu kB\n"
 		"Bounce:         %8lu kB\n"
@@ -129,6 +133,9 @@ static int meminfo_proc_show(struct seq_file *m, void *v)
 		K(global_page_state(NR_PAGETABLE)),
 #ifdef CONFIG_QUICKLIST
 		K(quicklist_total_size()),
+#endif
+#ifdef CONFIG_PREZERO_PAGES
+		K(prezero_total_pages()),
 #endif
 		K(global_page_state(NR_UNSTABLE_NFS)),
 		K(global_page_state(NR_BOUNCE)),
@@ -217,6 +217,80 @@ out:
 	return 0;
 }
 
+/**
+ * bg_gc_wanted - check if background garbage collection has work to do.
+ * @c: UBIFS file-system description object
+ *
+ * Background GC is wanted if it is enabled, the file-system is mounted
+ * read-write, there are fewer than @c->bg_gc_lebs empty LEBs, and lprops
+ * report at least one LEB worth of dirty space. If the previous background GC
+ * run found nothing to reclaim, it is not retried until the amount of dirty
+ * space changes. Returns %1 if background GC is wanted and %0 if not.
+ */
+static int bg_gc_wanted(struct ubifs_info *c)
+{
+	int empty_lebs;
+	long long dirty;
+
+	if (!c->bg_gc_lebs || c->ro_media || !c->vfs_sb->s_root ||
+	    (c->vfs_sb->s_flags & MS_RDONLY))
+		return 0;
+
+	spin_lock(&c->space_lock);
+	empty_lebs = c->lst.empty_lebs;
+	dirty = c->lst.total_dirty;
+	spin_unlock(&c->space_lock);
+
+	return empty_lebs < c->bg_gc_lebs && dirty >= c->leb_size &&
+	       dirty != c->bg_gc_dirty;
+}
+
+/**
+ * run_bg_gc - run background garbage collection.
+ * @c: UBIFS file-system description object
+ *
+ * This function garbage-collects dirty LEBs one at a time and returns the
+ * freed LEBs to lprops, until there are enough empty LEBs or there is nothing
+ * more to reclaim. It stops as soon as somebody reserves journal space, so
+ * that writers do not have to wait for the GC head which background GC holds.
+ */
+static void run_bg_gc(struct ubifs_info *c)
+{
+	int lnum, err;
+	unsigned long last_write = c->last_jnl_write;
+
+	while (bg_gc_wanted(c)) {
+		if (kthread_should_stop() || c->last_jnl_write != last_write)
+			break;
+
+		down_read(&c->commit_sem);
+		lnum = ubifs_garbage_collect(c, 1);
+		up_read(&c->commit_sem);
+		if (lnum < 0) {
+			if (lnum == -ENOSPC) {
+				spin_lock(&c->space_lock);
+				c->bg_gc_dirty = c->lst.total_dirty;
+				spin_unlock(&c->space_lock);
+				dbg_gc("background GC found nothing to reclaim");
+			}
+			/*
+			 * %-EAGAIN means commit is needed, which is done by
+			 * 'run_bg_commit()'. Other errors have already
+			 * switched the file-system to R/O mode.
+			 */
+			break;
+		}
+
+		dbg_gc("background GC freed LEB %d", lnum);
+		err = ubifs_return_leb(c, lnum);
+		if (err) {
+			ubifs_ro_mode(c, err);
+			break;
+		}
+		cond_resched();
+	}
+}
+
 /**
  * ubifs_bg_thread - UBIFS background thread function.
  * @info: points to the file-system description object
@@ -224,14 +298,14 @@ out:
  * This function implements various file-system background activities:
  * o when a write-buffer timer expires it synchronizes the appropriate
  *   write-buffer;
- * o when the journal is about to be full, it starts in-advance commit.
- *
- * Note, other stuff like background garbage collection may be added here in
- * future.
+ * o when the journal is about to be full, it starts in-advance commit;
+ * o when background garbage collection is enabled and the journal has been
+ *   idle for @c->bg_gc_idle jiffies, it garbage-collects dirty LEBs.
  */
 int ubifs_bg_thread(void *info)
 {
 	int err;
+	unsigned long now, idle_end;
 	struct ubifs_info *c = info;
 
 	dbg_msg("background thread \"%s\" started, PID %d",
@@ -255,16 +329,27 @@ int ubifs_bg_thread(void *info)
 			 */
 			if (kthread_should_stop())
 				break;
-			schedule();
-			continue;
-		} else
-			__set_current_state(TASK_RUNNING);
+			if (!bg_gc_wanted(c)) {
+				schedule();
+				continue;
+			}
+			/* Background GC is wanted, wait until journal is idle */
+			now = jiffies;
+			idle_end = c->last_jnl_write + c->bg_gc_idle;
+			if (time_before(now, idle_end)) {
+				schedule_timeout(idle_end - now);
+				continue;
+			}
+		}
+		__set_current_state(TASK_RUNNING);
 
 		c->need_bgt = 0;
 		err = ubifs_bg_wbufs_sync(c);
 		if (err)
 			ubifs_ro_mode(c, err);
 
+		if (time_after_eq(jiffies, c->last_jnl_write + c->bg_gc_idle))
+			run_bg_gc(c);
 		run_bg_commit(c);
 		cond_resched();
 	}
@@ -646,6 +646,47 @@ void dbg_dump_budg(struct ubifs_info *c)
 	spin_unlock(&dbg_lock);
 }
 
+void dbg_dump_stats(struct ubifs_info *c)
+{
+	int i;
+	unsigned long long units = 0, kib;
+	struct ubifs_gc_stats *st = &c->gc_stats;
+
+	ubifs_assert(mutex_is_locked(&c->tnc_mutex));
+	ubifs_assert(spin_is_locked(&c->space_lock));
+	spin_lock(&dbg_lock);
+	printk(KERN_DEBUG "(pid %d) GC statistics: bg_gc_lebs %d, "
+	       "bg_gc_idle %u ms\n", current->pid, c->bg_gc_lebs,
+	       jiffies_to_msecs(c->bg_gc_idle));
+	printk(KERN_DEBUG "\tforeground: runs %lu, freed LEBs %lu, "
+	       "time %llu us, max stall %lu us\n", st->fg_cnt, st->fg_lebs,
+	       st->fg_time, st->fg_max);
+	printk(KERN_DEBUG "\tbackground: runs %lu, freed LEBs %lu, "
+	       "time %llu us\n", st->bg_cnt, st->bg_lebs, st->bg_time);
+	printk(KERN_DEBUG "LNC statistics: cached %ld, max %ld, hits %lu, "
+	       "misses %lu, evicted %lu\n", c->lnc_cnt, c->lnc_max,
+	       c->lnc_hits, c->lnc_misses, c->lnc_evicted);
+	printk(KERN_DEBUG "Journal statistics: jnl_batch %u ms, data %llu KiB\n",
+	       jiffies_to_msecs(c->jnl_batch), c->jnl_data_bytes >> 10);
+	for (i = 0; i < c->jhead_cnt; i++) {
+		struct ubifs_wbuf *wbuf = &c->jheads[i].wbuf;
+
+		units += wbuf->io_units;
+		printk(KERN_DEBUG "\tjhead %d: min. I/O units %lu, batch waits "
+		       "%lu, batch hits %lu\n", i, wbuf->io_units,
+		       wbuf->batch_waits, wbuf->batch_hits);
+	}
+	kib = c->jnl_data_bytes >> 10;
+	if (kib) {
+		u32 rem;
+
+		units = div_u64_rem(div64_u64(units * 1000, kib), 1000, &rem);
+		printk(KERN_DEBUG "\tmin. I/O units per KiB of data: "
+		       "%llu.%03u\n", units, rem);
+	}
+	spin_unlock(&dbg_lock);
+}
+
 void dbg_dump_lprop(const struct ubifs_info *c, const struct ubifs_lprops *lp)
 {
 	printk(KERN_DEBUG "LEB %d lprops: free %d, dirty %d (used %d), "
@@ -2520,6 +2561,12 @@ static ssize_t write_debugfs_file(struct file *file, const char __user *buf,
 		mutex_lock(&c->tnc_mutex);
 		dbg_dump_tnc(c);
 		mutex_unlock(&c->tnc_mutex);
+	} else if (file->f_path.dentry == d->dfs_dump_stats) {
+		mutex_lock(&c->tnc_mutex);
+		spin_lock(&c->space_lock);
+		dbg_dump_stats(c);
+		spin_unlock(&c->space_lock);
+		mutex_unlock(&c->tnc_mutex);
 	} else
 		return -EINVAL;
 
@@ -2579,6 +2626,12 @@ int dbg_debugfs_init_fs(struct ubifs_info *c)
 		goto out_remove;
 	d->dfs_dump_tnc = dent;
 
+	fname = "dump_stats";
+	dent = debugfs_create_file(fname, S_IWUGO, d->dfs_dir, c, &dfs_fops);
+	if (IS_ERR(dent))
+		goto out_remove;
+	d->dfs_dump_stats = dent;
+
 	return 0;
 
 out_remove:
@@ -52,6 +52,7 @@
  * dfs_dump_lprops: "dump lprops" debugfs knob
  * dfs_dump_budg: "dump budgeting information" debugfs knob
  * dfs_dump_tnc: "dump TNC" debugfs knob
+ * dfs_dump_stats: "dump performance statistics" debugfs knob
  */
 struct ubifs_debug_info {
 	void *buf;
@@ -79,6 +80,7 @@ struct ubifs_debug_info {
 	struct dentry *dfs_dump_lprops;
 	struct dentry *dfs_dump_budg;
 	struct dentry *dfs_dump_tnc;
+	struct dentry *dfs_dump_stats;
 };
 
 #define ubifs_assert(expr) do {                                                \
@@ -280,6 +282,7 @@ void dbg_dump_lpt_node(const struct ubifs_info *c, void *node, int lnum,
 void dbg_dump_budget_req(const struct ubifs_budget_req *req);
 void dbg_dump_lstats(const struct ubifs_lp_stats *lst);
 void dbg_dump_budg(struct ubifs_info *c);
+void dbg_dump_stats(struct ubifs_info *c);
 void dbg_dump_lprop(const struct ubifs_info *c, const struct ubifs_lprops *lp);
 void dbg_dump_lprops(struct ubifs_info *c);
 void dbg_dump_lpt_info(struct ubifs_info *c);
@@ -432,6 +435,7 @@ void dbg_debugfs_exit_fs(struct ubifs_info *c);
 #define dbg_dump_budget_req(req)               ({})
 #define dbg_dump_lstats(lst)                   ({})
 #define dbg_dump_budg(c)                       ({})
+#define dbg_dump_stats(c)                      ({})
 #define dbg_dump_lprop(c, lp)                  ({})
 #define dbg_dump_lprops(c)                     ({})
 #define dbg_dump_lpt_info(c)                   ({})
@@ -462,7 +462,7 @@ out_inc_seq:
 }
 
 /**
- * ubifs_garbage_collect - UBIFS garbage collector.
+ * garbage_collect - UBIFS garbage collector.
  * @c: UBIFS file-system description object
  * @anyway: do GC even if there are free LEBs
  *
@@ -497,7 +497,7 @@ out_inc_seq:
  * but another kernel process consumes too much memory. Anyway, infinite
  * %-EAGAIN may happen, but in some extreme/misconfiguration cases.
  */
-int ubifs_garbage_collect(struct ubifs_info *c, int anyway)
+static int garbage_collect(struct ubifs_info *c, int anyway)
 {
 	int i, err, ret, min_space = c->dead_wm;
 	struct ubifs_lprops lp;
@@ -710,6 +710,47 @@ out:
 	return ret;
 }
 
+/**
+ * ubifs_garbage_collect - run the garbage collector and account it.
+ * @c: UBIFS file-system description object
+ * @anyway: do GC even if there are free LEBs
+ *
+ * This function is a wrapper over 'garbage_collect()' which also updates
+ * @c->gc_stats. GC runs done by the background thread are accounted
+ * separately from the ones which stall writers. The return codes are the same
+ * as for 'garbage_collect()'.
+ */
+int ubifs_garbage_collect(struct ubifs_info *c, int anyway)
+{
+	int ret;
+	unsigned long us;
+	ktime_t start = ktime_get();
+	struct ubifs_gc_stats *st = &c->gc_stats;
+
+	ret = garbage_collect(c, anyway);
+	us = ktime_us_delta(ktime_get(), start);
+
+	spin_lock(&c->space_lock);
+	if (current == c->bgt) {
+		st->bg_cnt += 1;
+		st->bg_time += us;
+		if (ret >= 0)
+			st->bg_lebs += 1;
+	} else {
+		st->fg_cnt += 1;
+		st->fg_time += us;
+		if (us > st->fg_max)
+			st->fg_max = us;
+		if (ret >= 0)
+			st->fg_lebs += 1;
+	}
+	spin_unlock(&c->space_lock);
+
+	if (current != c->bgt)
+		dbg_gc("writer stalled for %lu us in GC, ret %d", us, ret);
+	return ret;
+}
+
 /**
  * ubifs_gc_start_commit - garbage collection at start of commit.
  * @c: UBIFS file-system description object
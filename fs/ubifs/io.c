@@ -31,6 +31,13 @@
  * buffer is full or when it is not used for some time (by timer). This is
  * similar to the mechanism is used by JFFS2.
  *
+ * Many small files which are 'fsync()'ed one after the other (e.g., databases
+ * and their journals) would make every 'fsync()' flush a write-buffer which is
+ * mostly empty. If journal write batching is enabled by the "jnl_batch" mount
+ * option, 'fsync()' waits for a bounded time for nodes of other inodes to fill
+ * the write-buffer before flushing it, so fewer partially filled min. I/O units
+ * are written.
+ *
  * Write-buffers are defined by 'struct ubifs_wbuf' objects and protected by
  * mutexes defined inside these objects. Since sometimes upper-level code
  * has to lock the write-buffer (e.g. journal space reservation code), many
@@ -371,6 +378,7 @@ int ubifs_wbuf_sync_nolock(struct ubifs_wbuf *wbuf)
 	}
 
 	dirt = wbuf->avail;
+	wbuf->io_units += 1;
 
 	spin_lock(&wbuf->lock);
 	wbuf->offs += c->min_io_size;
@@ -378,6 +386,7 @@ int ubifs_wbuf_sync_nolock(struct ubifs_wbuf *wbuf)
 	wbuf->used = 0;
 	wbuf->next_ino = 0;
 	spin_unlock(&wbuf->lock);
+	wake_up(&wbuf->batch_wq);
 
 	if (wbuf->sync_callback)
 		err = wbuf->sync_callback(c, wbuf->lnum,
@@ -543,12 +552,14 @@ int ubifs_wbuf_write_nolock(struct ubifs_wbuf *wbuf, void *buf, int len)
 			if (err)
 				goto out;
 
+			wbuf->io_units += 1;
 			spin_lock(&wbuf->lock);
 			wbuf->offs += c->min_io_size;
 			wbuf->avail = c->min_io_size;
 			wbuf->used = 0;
 			wbuf->next_ino = 0;
 			spin_unlock(&wbuf->lock);
+			wake_up(&wbuf->batch_wq);
 		} else {
 			spin_lock(&wbuf->lock);
 			wbuf->avail -= aligned_len;
@@ -572,6 +583,7 @@ int ubifs_wbuf_write_nolock(struct ubifs_wbuf *wbuf, void *buf, int len)
 	if (err)
 		goto out;
 
+	wbuf->io_units += 1;
 	offs = wbuf->offs + c->min_io_size;
 	len -= wbuf->avail;
 	aligned_len -= wbuf->avail;
@@ -591,6 +603,7 @@ int ubifs_wbuf_write_nolock(struct ubifs_wbuf *wbuf, void *buf, int len)
 				    wbuf->dtype);
 		if (err)
 			goto out;
+		wbuf->io_units += n >> c->min_io_shift;
 		offs += n;
 		aligned_len -= n;
 		len -= n;
@@ -611,6 +624,7 @@ int ubifs_wbuf_write_nolock(struct ubifs_wbuf *wbuf, void *buf, int len)
 	wbuf->avail = c->min_io_size - aligned_len;
 	wbuf->next_ino = 0;
 	spin_unlock(&wbuf->lock);
+	wake_up(&wbuf->batch_wq);
 
 exit:
 	if (wbuf->sync_callback) {
@@ -851,6 +865,7 @@ int ubifs_wbuf_init(struct ubifs_info *c, struct ubifs_wbuf *wbuf)
 	spin_lock_init(&wbuf->lock);
 	wbuf->c = c;
 	wbuf->next_ino = 0;
+	init_waitqueue_head(&wbuf->batch_wq);
 
 	hrtimer_init(&wbuf->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
 	wbuf->timer.function = wbuf_timer_callback_nolock;
@@ -903,14 +918,55 @@ static int wbuf_has_ino(struct ubifs_wbuf *wbuf, ino_t inum)
 	return ret;
 }
 
+/**
+ * wbuf_batch_wait - wait for other inodes to fill the write-buffer.
+ * @c: UBIFS file-system description object
+ * @wbuf: the write-buffer
+ * @inum: the inode number which is being synchronized
+ *
+ * This function implements journal write batching. If the write-buffer
+ * contains nodes of other inodes as well, it is likely that more nodes will be
+ * written to it soon, so this function waits at most @c->jnl_batch jiffies for
+ * the write-buffer to be flushed by somebody else. Otherwise it does not wait
+ * at all, so a lone writer does not pay any latency.
+ */
+static void wbuf_batch_wait(struct ubifs_info *c, struct ubifs_wbuf *wbuf,
+			    ino_t inum)
+{
+	int i, others = 0;
+
+	spin_lock(&wbuf->lock);
+	for (i = 0; i < wbuf->next_ino; i++)
+		if (inum != wbuf->inodes[i]) {
+			others = 1;
+			break;
+		}
+	if (others)
+		wbuf->batch_waits += 1;
+	spin_unlock(&wbuf->lock);
+
+	if (!others)
+		return;
+
+	dbg_io("jhead %d, ino %lu, wait up to %u ms", wbuf->jhead,
+	       (unsigned long)inum, jiffies_to_msecs(c->jnl_batch));
+	if (wait_event_timeout(wbuf->batch_wq, !wbuf_has_ino(wbuf, inum),
+			       c->jnl_batch)) {
+		spin_lock(&wbuf->lock);
+		wbuf->batch_hits += 1;
+		spin_unlock(&wbuf->lock);
+	}
+}
+
 /**
  * ubifs_sync_wbufs_by_inode - synchronize write-buffers for an inode.
  * @c: UBIFS file-system description object
  * @inode: inode to synchronize
  *
  * This function synchronizes write-buffers which contain nodes belonging to
- * @inode. Returns zero in case of success and a negative error code in case of
- * failure.
+ * @inode. If journal write batching is enabled, it may first wait for a while
+ * for the write-buffers to be filled up by other inodes. Returns zero in case
+ * of success and a negative error code in case of failure.
  */
 int ubifs_sync_wbufs_by_inode(struct ubifs_info *c, struct inode *inode)
 {
@@ -931,6 +987,12 @@ int ubifs_sync_wbufs_by_inode(struct ubifs_info *c, struct inode *inode)
 		if (!wbuf_has_ino(wbuf, inode->i_ino))
 			continue;
 
+		if (c->jnl_batch) {
+			wbuf_batch_wait(c, wbuf, inode->i_ino);
+			if (!wbuf_has_ino(wbuf, inode->i_ino))
+				continue;
+		}
+
 		mutex_lock_nested(&wbuf->io_mutex, wbuf->jhead);
 		if (wbuf_has_ino(wbuf, inode->i_ino))
 			err = ubifs_wbuf_sync_nolock(wbuf);
@@ -123,6 +123,9 @@ static int reserve_space(struct ubifs_info *c, int jhead, int len)
 	 * what the squeeze parameter does.
 	 */
 	squeeze = (jhead == BASEHD);
+
+	/* Tell background GC that the journal is busy */
+	c->last_jnl_write = jiffies;
 again:
 	mutex_lock_nested(&wbuf->io_mutex, wbuf->jhead);
 
@@ -729,6 +732,7 @@ int ubifs_jnl_write_data(struct ubifs_info *c, const struct inode *inode,
 	if (err)
 		goto out_release;
 	ubifs_wbuf_add_ino_nolock(&c->jheads[DATAHD].wbuf, key_inum(c, key));
+	c->jnl_data_bytes += len;
 	release_head(c, DATAHD);
 
 	err = ubifs_tnc_add(c, key, lnum, offs, dlen);
@@ -21,8 +21,11 @@
  */
 
 /*
- * This file implements UBIFS shrinker which evicts clean znodes from the TNC
- * tree when Linux VM needs more RAM.
+ * This file implements UBIFS shrinker which evicts cached leaf nodes and clean
+ * znodes from the TNC tree when Linux VM needs more RAM.
+ *
+ * Cached leaf nodes (LNC) are kept in an LRU list, so they are evicted first,
+ * from the tail of the list, which is cheap and does not need a tree walk.
  *
  * We do not implement any LRU lists to find oldest znodes to free because it
  * would add additional overhead to the file system fast paths. So the shrinker
@@ -57,6 +60,9 @@ DEFINE_SPINLOCK(ubifs_infos_lock);
 /* Global clean znode counter (for all mounted UBIFS instances) */
 atomic_long_t ubifs_clean_zn_cnt;
 
+/* Global LNC leaf node counter (for all mounted UBIFS instances) */
+atomic_long_t ubifs_lnc_cnt;
+
 /**
  * shrink_tnc - shrink TNC tree.
  * @c: UBIFS file-system description object
@@ -64,8 +70,9 @@ atomic_long_t ubifs_clean_zn_cnt;
  * @age: the age of znodes to free
  * @contention: if any contention, this is set to %1
  *
- * This function traverses TNC tree and frees clean znodes. It does not free
- * clean znodes which younger then @age. Returns number of freed znodes.
+ * This function evicts least recently used leaf nodes from LNC, then traverses
+ * TNC tree and frees clean znodes. It does not free clean znodes which younger
+ * then @age. Returns number of freed leaf nodes and znodes.
  */
 static int shrink_tnc(struct ubifs_info *c, int nr, int age, int *contention)
 {
@@ -76,8 +83,12 @@ static int shrink_tnc(struct ubifs_info *c, int nr, int age, int *contention)
 	ubifs_assert(mutex_is_locked(&c->umount_mutex));
 	ubifs_assert(mutex_is_locked(&c->tnc_mutex));
 
+	total_freed = ubifs_lnc_shrink(c, nr);
+	if (total_freed >= nr)
+		return total_freed;
+
 	if (!c->zroot.znode || atomic_long_read(&c->clean_zn_cnt) == 0)
-		return 0;
+		return total_freed;
 
 	/*
 	 * Traverse the TNC tree in levelorder manner, so that it is possible
@@ -125,7 +136,7 @@ static int shrink_tnc(struct ubifs_info *c, int nr, int age, int *contention)
 			else
 				c->zroot.znode = NULL;
 
-			freed = ubifs_destroy_tnc_subtree(znode);
+			freed = ubifs_destroy_tnc_subtree(c, znode);
 			atomic_long_sub(freed, &ubifs_clean_zn_cnt);
 			atomic_long_sub(freed, &c->clean_zn_cnt);
 			ubifs_assert(atomic_long_read(&c->clean_zn_cnt) >= 0);
@@ -283,11 +294,12 @@ int ubifs_shrinker(int nr, gfp_t gfp_mask)
 {
 	int freed, contention = 0;
 	long clean_zn_cnt = atomic_long_read(&ubifs_clean_zn_cnt);
+	long lnc_cnt = atomic_long_read(&ubifs_lnc_cnt);
 
 	if (nr == 0)
-		return clean_zn_cnt;
+		return clean_zn_cnt + lnc_cnt;
 
-	if (!clean_zn_cnt) {
+	if (!clean_zn_cnt && !lnc_cnt) {
 		/*
 		 * No clean znodes, nothing to reap. All we can do in this case
 		 * is to kick background threads to start commit, which will
@@ -317,6 +329,7 @@ int ubifs_shrinker(int nr, gfp_t gfp_mask)
 	}
 
 out:
-	dbg_tnc("%d znodes were freed, requested %d", freed, nr);
+	dbg_tnc("%d leaf nodes and znodes were freed, requested %d",
+		freed, nr);
 	return freed;
 }
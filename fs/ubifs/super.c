@@ -430,6 +430,14 @@ static int ubifs_show_options(struct seq_file *s, struct vfsmount *mnt)
 		seq_printf(s, ubifs_compr_name(c->mount_opts.compr_type));
 	}
 
+	if (c->bg_gc_lebs) {
+		seq_printf(s, ",bg_gc=%d", c->bg_gc_lebs);
+		seq_printf(s, ",bg_gc_idle=%u", jiffies_to_msecs(c->bg_gc_idle));
+	}
+
+	if (c->jnl_batch)
+		seq_printf(s, ",jnl_batch=%u", jiffies_to_msecs(c->jnl_batch));
+
 	return 0;
 }
 
@@ -912,6 +920,10 @@ static int check_volume_empty(struct ubifs_info *c)
  * Opt_chk_data_crc: check CRCs when reading data nodes
  * Opt_no_chk_data_crc: do not check CRCs when reading data nodes
  * Opt_override_compr: override default compressor
+ * Opt_bg_gc: number of empty LEBs background GC tries to maintain
+ * Opt_bg_gc_idle: journal idle time (milliseconds) before background GC starts
+ * Opt_jnl_batch: how long (milliseconds) fsync may wait for write-buffers to
+ *                fill up
  * Opt_err: just end of array marker
  */
 enum {
@@ -922,6 +934,9 @@ enum {
 	Opt_chk_data_crc,
 	Opt_no_chk_data_crc,
 	Opt_override_compr,
+	Opt_bg_gc,
+	Opt_bg_gc_idle,
+	Opt_jnl_batch,
 	Opt_err,
 };
 
@@ -933,6 +948,9 @@ static const match_table_t tokens = {
 	{Opt_chk_data_crc, "chk_data_crc"},
 	{Opt_no_chk_data_crc, "no_chk_data_crc"},
 	{Opt_override_compr, "compr=%s"},
+	{Opt_bg_gc, "bg_gc=%u"},
+	{Opt_bg_gc_idle, "bg_gc_idle=%u"},
+	{Opt_jnl_batch, "jnl_batch=%u"},
 	{Opt_err, NULL},
 };
 
@@ -1013,6 +1031,41 @@ static int ubifs_parse_options(struct ubifs_info *c, char *options,
 			c->default_compr = c->mount_opts.compr_type;
 			break;
 		}
+		case Opt_bg_gc:
+		{
+			int lebs;
+
+			if (match_int(&args[0], &lebs) || lebs < 0) {
+				ubifs_err("bad background GC LEB count");
+				return -EINVAL;
+			}
+			c->bg_gc_lebs = lebs;
+			break;
+		}
+		case Opt_bg_gc_idle:
+		{
+			int ms;
+
+			if (match_int(&args[0], &ms) || ms < 0) {
+				ubifs_err("bad background GC idle time");
+				return -EINVAL;
+			}
+			c->bg_gc_idle = msecs_to_jiffies(ms);
+			break;
+		}
+		case Opt_jnl_batch:
+		{
+			int ms;
+
+			if (match_int(&args[0], &ms) || ms < 0 ||
+			    ms > MAX_JNL_BATCH) {
+				ubifs_err("bad journal batching time, max. %d ms",
+					  MAX_JNL_BATCH);
+				return -EINVAL;
+			}
+			c->jnl_batch = msecs_to_jiffies(ms);
+			break;
+		}
 		default:
 			ubifs_err("unrecognized mount option \"%s\" "
 				  "or missing value", p);
@@ -1780,6 +1833,10 @@ static int ubifs_remount_fs(struct super_block *sb, int *flags, char *data)
 		c->bu.buf = NULL;
 	}
 
+	/* Background GC settings may have changed */
+	if (c->bgt)
+		wake_up_process(c->bgt);
+
 	ubifs_assert(c->lst.taken_empty_lebs == 1);
 	return 0;
 }
@@ -1889,9 +1946,12 @@ static int ubifs_fill_super(struct super_block *sb, void *data, int silent)
 	INIT_LIST_HEAD(&c->old_buds);
 	INIT_LIST_HEAD(&c->orph_list);
 	INIT_LIST_HEAD(&c->orph_new);
+	INIT_LIST_HEAD(&c->lnc_lru);
 
 	c->highest_inum = UBIFS_FIRST_INO;
 	c->lhead_lnum = c->ltail_lnum = UBIFS_LOG_LNUM;
+	c->bg_gc_idle = msecs_to_jiffies(DEFAULT_BG_GC_IDLE);
+	c->lnc_max = DEFAULT_LNC_MAX;
 
 	ubi_get_volume_info(ubi, &c->vi);
 	ubi_get_device_info(c->vi.ubi_num, &c->di);
@@ -2174,6 +2234,7 @@ static void __exit ubifs_exit(void)
 {
 	ubifs_assert(list_empty(&ubifs_infos));
 	ubifs_assert(atomic_long_read(&ubifs_clean_zn_cnt) == 0);
+	ubifs_assert(atomic_long_read(&ubifs_lnc_cnt) == 0);
 
 	dbg_debugfs_exit();
 	ubifs_compressors_exit();
@@ -306,68 +306,55 @@ static struct ubifs_znode *dirty_cow_znode(struct ubifs_info *c,
 }
 
 /**
- * lnc_add - add a leaf node to the leaf node cache.
+ * lnc_lookup - look up a leaf node in the leaf node cache.
  * @c: UBIFS file-system description object
  * @zbr: zbranch of leaf node
- * @node: leaf node
  *
- * Leaf nodes are non-index nodes directory entry nodes or data nodes. The
- * purpose of the leaf node cache is to save re-reading the same leaf node over
- * and over again. Most things are cached by VFS, however the file system must
- * cache directory entries for readdir and for resolving hash collisions. The
- * present implementation of the leaf node cache is extremely simple, and
- * allows for error returns that are not used but that may be needed if a more
- * complex implementation is created.
- *
- * Note, this function does not add the @node object to LNC directly, but
- * allocates a copy of the object and adds the copy to LNC. The reason for this
- * is that @node has been allocated outside of the TNC subsystem and will be
- * used with @c->tnc_mutex unlock upon return from the TNC subsystem. But LNC
- * may be changed at any time, e.g. freed by the shrinker.
+ * This function returns the cached copy of the leaf node referred by @zbr and
+ * moves it to the head of the LNC LRU list, or returns %NULL if the node is
+ * not cached.
  */
-static int lnc_add(struct ubifs_info *c, struct ubifs_zbranch *zbr,
-		   const void *node)
+static void *lnc_lookup(struct ubifs_info *c, struct ubifs_zbranch *zbr)
 {
-	int err;
-	void *lnc_node;
-	const struct ubifs_dent_node *dent = node;
-
-	ubifs_assert(!zbr->leaf);
-	ubifs_assert(zbr->len != 0);
-	ubifs_assert(is_hash_key(c, &zbr->key));
+	struct ubifs_lnc_entry *lnc = zbr->leaf;
 
-	err = ubifs_validate_entry(c, dent);
-	if (err) {
-		dbg_dump_stack();
-		dbg_dump_node(c, dent);
-		return err;
+	if (!lnc || !lnc->node) {
+		c->lnc_misses += 1;
+		return NULL;
 	}
 
-	lnc_node = kmalloc(zbr->len, GFP_NOFS);
-	if (!lnc_node)
-		/* We don't have to have the cache, so no error */
-		return 0;
-
-	memcpy(lnc_node, node, zbr->len);
-	zbr->leaf = lnc_node;
-	return 0;
+	ubifs_assert(zbr->len != 0);
+	c->lnc_hits += 1;
+	list_move(&lnc->list, &c->lnc_lru);
+	return lnc->node;
 }
 
- /**
+/**
  * lnc_add_directly - add a leaf node to the leaf-node-cache.
  * @c: UBIFS file-system description object
  * @zbr: zbranch of leaf node
  * @node: leaf node
  *
- * This function is similar to 'lnc_add()', but it does not create a copy of
- * @node but inserts @node to TNC directly.
+ * Leaf nodes are non-index nodes directory entry nodes or data nodes. The
+ * purpose of the leaf node cache is to save re-reading the same leaf node over
+ * and over again. Most things are cached by VFS, however the file system must
+ * cache directory entries for readdir and for resolving hash collisions.
+ *
+ * The cache holds at most @c->lnc_max nodes which are kept in an LRU list. If
+ * the cache is full, the least recently used node is evicted to make room.
+ *
+ * This function inserts @node to LNC directly, so @node belongs to LNC upon
+ * successful return. Returns zero in case of success and a negative error code
+ * in case of failure. %-ENOMEM means only that @node could not be cached: it
+ * still belongs to the caller, which may use it and has to free it.
  */
 static int lnc_add_directly(struct ubifs_info *c, struct ubifs_zbranch *zbr,
 			    void *node)
 {
 	int err;
+	struct ubifs_lnc_entry *lnc = zbr->leaf;
 
-	ubifs_assert(!zbr->leaf);
+	ubifs_assert(!lnc || !lnc->node);
 	ubifs_assert(zbr->len != 0);
 
 	err = ubifs_validate_entry(c, node);
@@ -377,21 +364,58 @@ static int lnc_add_directly(struct ubifs_info *c, struct ubifs_zbranch *zbr,
 		return err;
 	}
 
-	zbr->leaf = node;
+	if (!lnc) {
+		lnc = kmalloc(sizeof(struct ubifs_lnc_entry), GFP_NOFS);
+		if (!lnc)
+			return -ENOMEM;
+		zbr->leaf = lnc;
+	}
+
+	if (c->lnc_cnt >= c->lnc_max)
+		ubifs_lnc_shrink(c, 1);
+
+	lnc->node = node;
+	list_add(&lnc->list, &c->lnc_lru);
+	c->lnc_cnt += 1;
+	atomic_long_inc(&ubifs_lnc_cnt);
 	return 0;
 }
 
 /**
- * lnc_free - remove a leaf node from the leaf node cache.
+ * lnc_add - add a leaf node to the leaf node cache.
+ * @c: UBIFS file-system description object
  * @zbr: zbranch of leaf node
  * @node: leaf node
+ *
+ * This function is similar to 'lnc_add_directly()', but it does not add the
+ * @node object to LNC directly, but allocates a copy of the object and adds
+ * the copy to LNC. The reason for this is that @node has been allocated
+ * outside of the TNC subsystem and will be used with @c->tnc_mutex unlock upon
+ * return from the TNC subsystem. But LNC may be changed at any time, e.g.
+ * freed by the shrinker.
  */
-static void lnc_free(struct ubifs_zbranch *zbr)
+static int lnc_add(struct ubifs_info *c, struct ubifs_zbranch *zbr,
+		   const void *node)
 {
-	if (!zbr->leaf)
-		return;
-	kfree(zbr->leaf);
-	zbr->leaf = NULL;
+	int err;
+	void *lnc_node;
+
+	ubifs_assert(is_hash_key(c, &zbr->key));
+
+	lnc_node = kmalloc(zbr->len, GFP_NOFS);
+	if (!lnc_node)
+		/* We don't have to have the cache, so no error */
+		return 0;
+
+	memcpy(lnc_node, node, zbr->len);
+	err = lnc_add_directly(c, zbr, lnc_node);
+	if (err) {
+		kfree(lnc_node);
+		/* The cache is optional, only a corrupted node is an error */
+		if (err == -ENOMEM)
+			err = 0;
+	}
+	return err;
 }
 
 /**
@@ -409,13 +433,14 @@ static int tnc_read_node_nm(struct ubifs_info *c, struct ubifs_zbranch *zbr,
 			    void *node)
 {
 	int err;
+	void *lnc_node;
 
 	ubifs_assert(is_hash_key(c, &zbr->key));
 
-	if (zbr->leaf) {
+	lnc_node = lnc_lookup(c, zbr);
+	if (lnc_node) {
 		/* Read from the leaf node cache */
-		ubifs_assert(zbr->len != 0);
-		memcpy(node, zbr->leaf, zbr->len);
+		memcpy(node, lnc_node, zbr->len);
 		return 0;
 	}
 
@@ -535,10 +560,11 @@ static int matches_name(struct ubifs_info *c, struct ubifs_zbranch *zbr,
 			const struct qstr *nm)
 {
 	struct ubifs_dent_node *dent;
-	int nlen, err;
+	int nlen, err, cached = 1;
 
 	/* If possible, match against the dent in the leaf node cache */
-	if (!zbr->leaf) {
+	dent = lnc_lookup(c, zbr);
+	if (!dent) {
 		dent = kmalloc(zbr->len, GFP_NOFS);
 		if (!dent)
 			return -ENOMEM;
@@ -549,24 +575,28 @@ static int matches_name(struct ubifs_info *c, struct ubifs_zbranch *zbr,
 
 		/* Add the node to the leaf node cache */
 		err = lnc_add_directly(c, zbr, dent);
-		if (err)
+		/* The cache is optional, match and free the node instead */
+		if (err == -ENOMEM)
+			cached = 0;
+		else if (err)
 			goto out_free;
-	} else
-		dent = zbr->leaf;
+	}
 
 	nlen = le16_to_cpu(dent->nlen);
 	err = memcmp(dent->name, nm->name, min_t(int, nlen, nm->len));
 	if (err == 0) {
 		if (nlen == nm->len)
-			return NAME_MATCHES;
+			err = NAME_MATCHES;
 		else if (nlen < nm->len)
-			return NAME_LESS;
+			err = NAME_LESS;
 		else
-			return NAME_GREATER;
+			err = NAME_GREATER;
 	} else if (err < 0)
-		return NAME_LESS;
+		err = NAME_LESS;
 	else
-		return NAME_GREATER;
+		err = NAME_GREATER;
+	if (cached)
+		return err;
 
 out_free:
 	kfree(dent);
@@ -823,10 +853,11 @@ static int fallible_matches_name(struct ubifs_info *c,
 				 const struct qstr *nm)
 {
 	struct ubifs_dent_node *dent;
-	int nlen, err;
+	int nlen, err, cached = 1;
 
 	/* If possible, match against the dent in the leaf node cache */
-	if (!zbr->leaf) {
+	dent = lnc_lookup(c, zbr);
+	if (!dent) {
 		dent = kmalloc(zbr->len, GFP_NOFS);
 		if (!dent)
 			return -ENOMEM;
@@ -842,24 +873,28 @@ static int fallible_matches_name(struct ubifs_info *c,
 		ubifs_assert(err == 1);
 
 		err = lnc_add_directly(c, zbr, dent);
-		if (err)
+		/* The cache is optional, match and free the node instead */
+		if (err == -ENOMEM)
+			cached = 0;
+		else if (err)
 			goto out_free;
-	} else
-		dent = zbr->leaf;
+	}
 
 	nlen = le16_to_cpu(dent->nlen);
 	err = memcmp(dent->name, nm->name, min_t(int, nlen, nm->len));
 	if (err == 0) {
 		if (nlen == nm->len)
-			return NAME_MATCHES;
+			err = NAME_MATCHES;
 		else if (nlen < nm->len)
-			return NAME_LESS;
+			err = NAME_LESS;
 		else
-			return NAME_GREATER;
+			err = NAME_GREATER;
 	} else if (err < 0)
-		return NAME_LESS;
+		err = NAME_LESS;
 	else
-		return NAME_GREATER;
+		err = NAME_GREATER;
+	if (cached)
+		return err;
 
 out_free:
 	kfree(dent);
@@ -2180,7 +2215,7 @@ int ubifs_tnc_add(struct ubifs_info *c, const union ubifs_key *key, int lnum,
 	} else if (found == 1) {
 		struct ubifs_zbranch *zbr = &znode->zbranch[n];
 
-		lnc_free(zbr);
+		ubifs_lnc_free(c, zbr);
 		err = ubifs_add_dirt(c, zbr->lnum, zbr->len);
 		zbr->lnum = lnum;
 		zbr->offs = offs;
@@ -2228,7 +2263,7 @@ int ubifs_tnc_replace(struct ubifs_info *c, const union ubifs_key *key,
 
 		found = 0;
 		if (zbr->lnum == old_lnum && zbr->offs == old_offs) {
-			lnc_free(zbr);
+			ubifs_lnc_free(c, zbr);
 			err = ubifs_add_dirt(c, zbr->lnum, zbr->len);
 			if (err)
 				goto out_unlock;
@@ -2256,7 +2291,7 @@ int ubifs_tnc_replace(struct ubifs_info *c, const union ubifs_key *key,
 					}
 				}
 				zbr = &znode->zbranch[n];
-				lnc_free(zbr);
+				ubifs_lnc_free(c, zbr);
 				err = ubifs_add_dirt(c, zbr->lnum,
 						     zbr->len);
 				if (err)
@@ -2330,7 +2365,7 @@ int ubifs_tnc_add_nm(struct ubifs_info *c, const union ubifs_key *key,
 		if (found == 1) {
 			struct ubifs_zbranch *zbr = &znode->zbranch[n];
 
-			lnc_free(zbr);
+			ubifs_lnc_free(c, zbr);
 			err = ubifs_add_dirt(c, zbr->lnum, zbr->len);
 			zbr->lnum = lnum;
 			zbr->offs = offs;
@@ -2395,7 +2430,7 @@ static int tnc_delete(struct ubifs_info *c, struct ubifs_znode *znode, int n)
 	dbg_tnc("deleting %s", DBGKEY(&znode->zbranch[n].key));
 
 	zbr = &znode->zbranch[n];
-	lnc_free(zbr);
+	ubifs_lnc_free(c, zbr);
 
 	err = ubifs_add_dirt(c, zbr->lnum, zbr->len);
 	if (err) {
@@ -2642,7 +2677,7 @@ int ubifs_tnc_remove_range(struct ubifs_info *c, union ubifs_key *from_key,
 			key = &znode->zbranch[i].key;
 			if (!key_in_range(c, key, from_key, to_key))
 				break;
-			lnc_free(&znode->zbranch[i]);
+			ubifs_lnc_free(c, &znode->zbranch[i]);
 			err = ubifs_add_dirt(c, znode->zbranch[i].lnum,
 					     znode->zbranch[i].len);
 			if (err) {
@@ -2874,7 +2909,7 @@ void ubifs_tnc_close(struct ubifs_info *c)
 
 	tnc_destroy_cnext(c);
 	if (c->zroot.znode) {
-		clean_freed = ubifs_destroy_tnc_subtree(c->zroot.znode);
+		clean_freed = ubifs_destroy_tnc_subtree(c, c->zroot.znode);
 		atomic_long_sub(clean_freed, &ubifs_clean_zn_cnt);
 	}
 	kfree(c->gap_lebs);
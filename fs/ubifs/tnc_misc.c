@@ -218,14 +218,70 @@ struct ubifs_znode *ubifs_tnc_postorder_next(struct ubifs_znode *znode)
 	return ubifs_tnc_postorder_first(zn);
 }
 
+/**
+ * ubifs_lnc_free - remove a leaf node from the leaf node cache.
+ * @c: UBIFS file-system description object
+ * @zbr: zbranch of leaf node
+ *
+ * This function frees the LNC entry of the leaf node referred by @zbr, if
+ * there is one, as well as the cached node itself, if it has not been evicted
+ * yet.
+ */
+void ubifs_lnc_free(struct ubifs_info *c, struct ubifs_zbranch *zbr)
+{
+	struct ubifs_lnc_entry *lnc = zbr->leaf;
+
+	if (!lnc)
+		return;
+	if (lnc->node) {
+		list_del(&lnc->list);
+		kfree(lnc->node);
+		c->lnc_cnt -= 1;
+		atomic_long_dec(&ubifs_lnc_cnt);
+	}
+	kfree(lnc);
+	zbr->leaf = NULL;
+}
+
+/**
+ * ubifs_lnc_shrink - evict least recently used leaf nodes from LNC.
+ * @c: UBIFS file-system description object
+ * @nr: number of leaf nodes to evict
+ *
+ * This function frees up to @nr least recently used leaf nodes from the tail
+ * of the LNC LRU list. Each eviction takes constant time. The LNC entries stay
+ * attached to their zbranches (see 'struct ubifs_lnc_entry'). Returns the
+ * number of evicted leaf nodes.
+ */
+long ubifs_lnc_shrink(struct ubifs_info *c, long nr)
+{
+	long freed = 0;
+	struct ubifs_lnc_entry *lnc;
+
+	ubifs_assert(mutex_is_locked(&c->tnc_mutex));
+	while (freed < nr && !list_empty(&c->lnc_lru)) {
+		lnc = list_entry(c->lnc_lru.prev, struct ubifs_lnc_entry, list);
+		list_del_init(&lnc->list);
+		kfree(lnc->node);
+		lnc->node = NULL;
+		freed += 1;
+	}
+
+	c->lnc_cnt -= freed;
+	c->lnc_evicted += freed;
+	atomic_long_sub(freed, &ubifs_lnc_cnt);
+	return freed;
+}
+
 /**
  * ubifs_destroy_tnc_subtree - destroy all znodes connected to a subtree.
+ * @c: UBIFS file-system description object
  * @znode: znode defining subtree to destroy
  *
- * This function destroys subtree of the TNC tree. Returns number of clean
- * znodes in the subtree.
+ * This function destroys subtree of the TNC tree, including the leaf nodes
+ * cached in LNC. Returns number of clean znodes in the subtree.
  */
-long ubifs_destroy_tnc_subtree(struct ubifs_znode *znode)
+long ubifs_destroy_tnc_subtree(struct ubifs_info *c, struct ubifs_znode *znode)
 {
 	struct ubifs_znode *zn = ubifs_tnc_postorder_first(znode);
 	long clean_freed = 0;
@@ -237,8 +293,12 @@ long ubifs_destroy_tnc_subtree(struct ubifs_znode *znode)
 			if (!zn->zbranch[n].znode)
 				continue;
 
-			if (zn->level > 0 &&
-			    !ubifs_zn_dirty(zn->zbranch[n].znode))
+			if (zn->level == 0) {
+				ubifs_lnc_free(c, &zn->zbranch[n]);
+				continue;
+			}
+
+			if (!ubifs_zn_dirty(zn->zbranch[n].znode))
 				clean_freed += 1;
 
 			cond_resched();
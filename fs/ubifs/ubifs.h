@@ -99,6 +99,20 @@
 #define WBUF_TIMEOUT_SOFTLIMIT 3
 #define WBUF_TIMEOUT_HARDLIMIT 5
 
+/*
+ * Default time in milliseconds the file-system has to be free of journal
+ * writes before the background thread starts garbage collecting dirty LEBs
+ * (only if background GC was enabled with the "bg_gc" mount option).
+ */
+#define DEFAULT_BG_GC_IDLE 500
+
+/*
+ * Maximum time in milliseconds 'fsync()' may wait for other inodes' nodes to
+ * fill the write-buffer when journal write batching is enabled with the
+ * "jnl_batch" mount option.
+ */
+#define MAX_JNL_BATCH 1000
+
 /* Maximum possible inode number (only 32-bit inodes are supported now) */
 #define MAX_INUM 0xFFFFFFFF
 
@@ -141,6 +155,13 @@
 #define OLD_ZNODE_AGE 20
 #define YOUNG_ZNODE_AGE 5
 
+/*
+ * Default maximum number of leaf nodes (directory and extended attribute
+ * entries) cached in the leaf node cache (LNC) of one file-system. When the
+ * LNC is full, the least recently used leaf node is evicted.
+ */
+#define DEFAULT_LNC_MAX 1024
+
 /*
  * Some compressors, like LZO, may end up with more data then the input buffer.
  * So UBIFS always allocates larger output buffer, to be sure the compressor
@@ -659,6 +680,12 @@ typedef int (*ubifs_lpt_scan_callback)(struct ubifs_info *c,
  * @need_sync: non-zero if the timer expired and the wbuf needs sync'ing
  * @next_ino: points to the next position of the following inode number
  * @inodes: stores the inode numbers of the nodes which are in wbuf
+ * @batch_wq: wait queue to sleep on while waiting for the write-buffer to be
+ *            flushed (journal write batching)
+ * @io_units: how many min. I/O units were written via this write-buffer
+ * @batch_waits: how many times 'fsync()' waited for the write-buffer to fill
+ * @batch_hits: how many of those waits ended because the write-buffer was
+ *              flushed by somebody else
  *
  * The write-buffer synchronization callback is called when the write-buffer is
  * synchronized in order to notify how much space was wasted due to
@@ -669,6 +696,9 @@ typedef int (*ubifs_lpt_scan_callback)(struct ubifs_info *c,
  * @buf is appended to under mutex but overwritten under both mutex and
  * spin-lock. Thus the data between @buf and @buf + @used can be read under
  * spinlock.
+ *
+ * @io_units is protected by @io_mutex, @batch_waits and @batch_hits are
+ * protected by @lock.
  */
 struct ubifs_wbuf {
 	struct ubifs_info *c;
@@ -689,6 +719,10 @@ struct ubifs_wbuf {
 	unsigned int need_sync:1;
 	int next_ino;
 	ino_t *inodes;
+	wait_queue_head_t batch_wq;
+	unsigned long io_units;
+	unsigned long batch_waits;
+	unsigned long batch_hits;
 };
 
 /**
@@ -738,6 +772,22 @@ struct ubifs_zbranch {
 	int len;
 };
 
+/**
+ * struct ubifs_lnc_entry - leaf node cache entry.
+ * @list: link in the LNC LRU list (@c->lnc_lru), empty if @node was evicted
+ * @node: the cached leaf node, or %NULL if it was evicted from LNC
+ *
+ * The @leaf field of a level 0 zbranch points to an object of this type if the
+ * leaf node was cached. Zbranches are copied around inside the TNC, so LNC
+ * cannot find the zbranch which refers to a cache entry. Instead, evicting a
+ * leaf node frees only the node, and the (small) entry object stays until the
+ * zbranch goes away.
+ */
+struct ubifs_lnc_entry {
+	struct list_head list;
+	void *node;
+};
+
 /**
  * struct ubifs_znode - in-memory representation of an indexing node.
  * @parent: parent znode or NULL if it is the root
@@ -906,6 +956,28 @@ struct ubifs_orphan {
 	int new;
 };
 
+/**
+ * struct ubifs_gc_stats - garbage collection statistics.
+ * @fg_cnt: how many times writers ran the garbage collector synchronously
+ * @fg_lebs: how many LEBs were freed by synchronous garbage collection
+ * @fg_time: total time writers spent in the garbage collector (microseconds)
+ * @fg_max: the longest single synchronous garbage collection (microseconds)
+ * @bg_cnt: how many times the background thread ran the garbage collector
+ * @bg_lebs: how many LEBs were freed by background garbage collection
+ * @bg_time: total time spent in background garbage collection (microseconds)
+ *
+ * All fields are protected by @c->space_lock.
+ */
+struct ubifs_gc_stats {
+	unsigned long fg_cnt;
+	unsigned long fg_lebs;
+	unsigned long long fg_time;
+	unsigned long fg_max;
+	unsigned long bg_cnt;
+	unsigned long bg_lebs;
+	unsigned long long bg_time;
+};
+
 /**
  * struct ubifs_mount_opts - UBIFS-specific mount options information.
  * @unmount_mode: selected unmount mode (%0 default, %1 normal, %2 fast)
@@ -961,6 +1033,11 @@ struct ubifs_debug_info;
  * @bg_bud_bytes: number of bud bytes when background commit is initiated
  * @old_buds: buds to be released after commit ends
  * @max_bud_cnt: maximum number of buds
+ * @jnl_batch: how long 'fsync()' may wait for the data head write-buffer to be
+ *             filled by other inodes before flushing it (jiffies, %0 disables
+ *             journal write batching)
+ * @jnl_data_bytes: how many bytes of uncompressed file data were written to
+ *                  the journal (protected by the data head @io_mutex)
  *
  * @commit_sem: synchronizes committer with other processes
  * @cmt_state: commit state
@@ -973,8 +1050,8 @@ struct ubifs_debug_info;
  * @bulk_read: enable bulk-reads
  * @default_compr: default compression algorithm (%UBIFS_COMPR_LZO, etc)
  *
- * @tnc_mutex: protects the Tree Node Cache (TNC), @zroot, @cnext, @enext, and
- *             @calc_idx_sz
+ * @tnc_mutex: protects the Tree Node Cache (TNC), @zroot, @cnext, @enext,
+ *             @calc_idx_sz, and the leaf node cache (LNC) fields
  * @zroot: zbranch which points to the root index node and znode
  * @cnext: next znode to commit
  * @enext: next znode to commit to empty space
@@ -989,6 +1066,12 @@ struct ubifs_debug_info;
  * @ileb_nxt: next pre-allocated index LEBs
  * @old_idx: tree of index nodes obsoleted since the last commit start
  * @bottom_up_buf: a buffer which is used by 'dirty_cow_bottom_up()' in tnc.c
+ * @lnc_lru: LNC LRU list, the most recently used leaf node first
+ * @lnc_cnt: number of leaf nodes in LNC
+ * @lnc_max: maximum number of leaf nodes in LNC
+ * @lnc_hits: how many times a leaf node was found in LNC
+ * @lnc_misses: how many times a leaf node had to be read from the media
+ * @lnc_evicted: how many leaf nodes were evicted from LNC
  *
  * @mst_node: master node
  * @mst_offs: offset of valid master node
@@ -1092,6 +1175,14 @@ struct ubifs_debug_info;
  * @bgt_name: background thread name
  * @need_bgt: if background thread should run
  * @need_wbuf_sync: if write-buffers have to be synchronized
+ * @bg_gc_lebs: background GC keeps garbage-collecting dirty LEBs while there
+ *              are fewer than this many empty LEBs (%0 disables background GC)
+ * @bg_gc_idle: how long the journal has to be idle before background GC starts
+ *              (jiffies)
+ * @bg_gc_dirty: total dirty space at the time background GC last found
+ *               nothing to reclaim
+ * @last_jnl_write: time of the last journal space reservation (jiffies)
+ * @gc_stats: garbage collection statistics
  *
  * @gc_lnum: LEB number used for garbage collection
  * @sbuf: a buffer of LEB size used by GC and replay for scanning
@@ -1201,6 +1292,8 @@ struct ubifs_info {
 	long long bg_bud_bytes;
 	struct list_head old_buds;
 	int max_bud_cnt;
+	unsigned long jnl_batch;
+	unsigned long long jnl_data_bytes;
 
 	struct rw_semaphore commit_sem;
 	int cmt_state;
@@ -1227,6 +1320,12 @@ struct ubifs_info {
 	int ileb_nxt;
 	struct rb_root old_idx;
 	int *bottom_up_buf;
+	struct list_head lnc_lru;
+	long lnc_cnt;
+	long lnc_max;
+	unsigned long lnc_hits;
+	unsigned long lnc_misses;
+	unsigned long lnc_evicted;
 
 	struct ubifs_mst_node *mst_node;
 	int mst_offs;
@@ -1320,6 +1419,11 @@ struct ubifs_info {
 	char bgt_name[sizeof(BGT_NAME_PATTERN) + 9];
 	int need_bgt;
 	int need_wbuf_sync;
+	int bg_gc_lebs;
+	unsigned long bg_gc_idle;
+	long long bg_gc_dirty;
+	unsigned long last_jnl_write;
+	struct ubifs_gc_stats gc_stats;
 
 	int gc_lnum;
 	void *sbuf;
@@ -1408,6 +1512,7 @@ struct ubifs_info {
 extern struct list_head ubifs_infos;
 extern spinlock_t ubifs_infos_lock;
 extern atomic_long_t ubifs_clean_zn_cnt;
+extern atomic_long_t ubifs_lnc_cnt;
 extern struct kmem_cache *ubifs_inode_slab;
 extern const struct super_operations ubifs_super_operations;
 extern const struct address_space_operations ubifs_file_address_operations;
@@ -1557,7 +1662,9 @@ int ubifs_search_zbranch(const struct ubifs_info *c,
 			 const union ubifs_key *key, int *n);
 struct ubifs_znode *ubifs_tnc_postorder_first(struct ubifs_znode *znode);
 struct ubifs_znode *ubifs_tnc_postorder_next(struct ubifs_znode *znode);
-long ubifs_destroy_tnc_subtree(struct ubifs_znode *zr);
+long ubifs_destroy_tnc_subtree(struct ubifs_info *c, struct ubifs_znode *zr);
+void ubifs_lnc_free(struct ubifs_info *c, struct ubifs_zbranch *zbr);
+long ubifs_lnc_shrink(struct ubifs_info *c, long nr);
 struct ubifs_znode *ubifs_load_znode(struct ubifs_info *c,
 				     struct ubifs_zbranch *zbr,
 				     struct ubifs_znode *parent, int iip);
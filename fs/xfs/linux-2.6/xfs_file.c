@@ -357,5 +357,6 @@ const struct file_operations xfs_dir_file_operations = {
 
 static struct vm_operations_struct xfs_file_vm_ops = {
 	.fault		= filemap_fault,
+	.map_pages	= filemap_map_pages,
 	.page_mkwrite	= xfs_vm_page_mkwrite,
 };
@@ -20,6 +20,7 @@
 #include <linux/completion.h>
 #include <linux/workqueue.h>
 #include <linux/cpumask.h>
+#include <linux/percpu.h>
 #include <asm/div64.h>
 
 #define CPUFREQ_NAME_LEN 16
@@ -294,6 +295,15 @@ static inline unsigned int cpufreq_quick_get(unsigned int cpu)
 }
 #endif
 
+#ifdef CONFIG_CPU_FREQ_TASK_STATS
+/*
+ * Index in its frequency table of the current speed of each CPU, which
+ * the scheduler charges the runtime of tasks to (see struct
+ * cpufreq_task_time).
+ */
+DECLARE_PER_CPU(unsigned int, cpufreq_task_state);
+#endif
+
 
 /*********************************************************************
  *                       CPUFREQ DEFAULT GOVERNOR                    *
@@ -321,6 +331,9 @@ extern struct cpufreq_governor cpufreq_gov_ondemand;
 #elif defined(CONFIG_CPU_FREQ_DEFAULT_GOV_CONSERVATIVE)
 extern struct cpufreq_governor cpufreq_gov_conservative;
 #define CPUFREQ_DEFAULT_GOVERNOR	(&cpufreq_gov_conservative)
+#elif defined(CONFIG_CPU_FREQ_DEFAULT_GOV_INTERACTIVE)
+extern struct cpufreq_governor cpufreq_gov_interactive;
+#define CPUFREQ_DEFAULT_GOVERNOR	(&cpufreq_gov_interactive)
 #endif
 
 
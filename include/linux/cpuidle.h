@@ -40,6 +40,8 @@ struct cpuidle_state {
 
 	unsigned long long	usage;
 	unsigned long long	time; /* in US */
+	unsigned long long	hits; /* stayed target_residency or longer */
+	unsigned long long	misses; /* woken before target_residency */
 
 	int (*enter)	(struct cpuidle_device *dev,
 			 struct cpuidle_state *state);
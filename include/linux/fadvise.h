@@ -18,4 +18,11 @@
 #define POSIX_FADV_NOREUSE	5 /* Data will be accessed once.  */
 #endif
 
+/* Linux specific: read in what the readahead trace recorded for the file. */
+#define POSIX_FADV_WILLNEED_TRACE	8
+
+/* Linux specific: keep these pages in the page cache, or stop doing so. */
+#define POSIX_FADV_PIN		9
+#define POSIX_FADV_UNPIN	10
+
 #endif	/* FADVISE_H_INCLUDED */
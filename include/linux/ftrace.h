@@ -146,8 +146,17 @@ static inline void __ftrace_enabled_restore(int enabled)
 #endif
 }
 
-#ifdef CONFIG_FRAME_POINTER
-/* TODO: need to fix this for ARM */
+#if defined(CONFIG_FRAME_POINTER) && defined(CONFIG_ARM)
+/* gcc only returns the address of the current frame on ARM */
+extern void *return_address(unsigned int level);
+# define CALLER_ADDR0 ((unsigned long)__builtin_return_address(0))
+# define CALLER_ADDR1 ((unsigned long)return_address(1))
+# define CALLER_ADDR2 ((unsigned long)return_address(2))
+# define CALLER_ADDR3 ((unsigned long)return_address(3))
+# define CALLER_ADDR4 ((unsigned long)return_address(4))
+# define CALLER_ADDR5 ((unsigned long)return_address(5))
+# define CALLER_ADDR6 ((unsigned long)return_address(6))
+#elif defined(CONFIG_FRAME_POINTER)
 # define CALLER_ADDR0 ((unsigned long)__builtin_return_address(0))
 # define CALLER_ADDR1 ((unsigned long)__builtin_return_address(1))
 # define CALLER_ADDR2 ((unsigned long)__builtin_return_address(2))
@@ -174,9 +183,11 @@ static inline void __ftrace_enabled_restore(int enabled)
 #endif
 
 #ifdef CONFIG_PREEMPT_TRACER
+  extern int trace_preempt_active;
   extern void trace_preempt_on(unsigned long a0, unsigned long a1);
   extern void trace_preempt_off(unsigned long a0, unsigned long a1);
 #else
+# define trace_preempt_active			0
 # define trace_preempt_on(a0, a1)		do { } while (0)
 # define trace_preempt_off(a0, a1)		do { } while (0)
 #endif
@@ -249,6 +260,73 @@ static inline void start_boot_trace(void) { }
 static inline void stop_boot_trace(void) { }
 #endif
 
+struct task_struct;
+
+/*
+ * Structure that defines an entry function trace.
+ */
+struct ftrace_graph_ent {
+	unsigned long func; /* Current function */
+	int depth;
+};
+
+/*
+ * Structure that defines a return function trace.
+ */
+struct ftrace_graph_ret {
+	unsigned long func; /* Current function */
+	unsigned long long calltime;
+	unsigned long long rettime;
+	/* Number of functions that overran the depth limit for current task */
+	unsigned long overrun;
+	int depth;
+};
 
+#ifdef CONFIG_FUNCTION_GRAPH_TRACER
+
+/*
+ * Stack of return addresses for functions
+ * of a thread.
+ * Kept in struct task_struct
+ */
+struct ftrace_ret_stack {
+	unsigned long ret;
+	unsigned long func;
+	unsigned long long calltime;
+};
+
+/* Maximum depth of nested functions traced per task */
+#define FTRACE_RETFUNC_DEPTH 50
+#define FTRACE_RETSTACK_ALLOC_SIZE 32
+
+/* Type of the callback handlers for tracing function graph */
+typedef void (*trace_func_graph_ret_t)(struct ftrace_graph_ret *); /* return */
+typedef int (*trace_func_graph_ent_t)(struct ftrace_graph_ent *); /* entry */
+
+extern trace_func_graph_ret_t ftrace_graph_return;
+extern trace_func_graph_ent_t ftrace_graph_entry;
+extern int ftrace_graph_entry_stub(struct ftrace_graph_ent *trace);
+
+/*
+ * The entry handler returns nonzero to have the return of the function
+ * traced too. Both handlers, and all they call, may be run from any
+ * context, interrupts included.
+ */
+extern int register_ftrace_graph(trace_func_graph_ret_t retfunc,
+				 trace_func_graph_ent_t entryfunc);
+extern void unregister_ftrace_graph(void);
+
+extern void ftrace_graph_init_task(struct task_struct *t);
+extern void ftrace_graph_exit_task(struct task_struct *t);
+
+/* called by the arch mcount and return trampolines */
+extern int ftrace_push_return_trace(unsigned long ret, unsigned long func);
+extern unsigned long ftrace_return_to_handler(void);
+extern void return_to_handler(void);
+
+#else
+static inline void ftrace_graph_init_task(struct task_struct *t) { }
+static inline void ftrace_graph_exit_task(struct task_struct *t) { }
+#endif /* CONFIG_FUNCTION_GRAPH_TRACER */
 
 #endif /* _LINUX_FTRACE_H */
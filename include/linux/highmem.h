@@ -4,6 +4,7 @@
 #include <linux/fs.h>
 #include <linux/mm.h>
 #include <linux/uaccess.h>
+#include <linux/prezero.h>
 
 #include <asm/cacheflush.h>
 
@@ -81,7 +82,8 @@ static inline void clear_user_highpage(struct page *page, unsigned long vaddr)
  *
  * This function will allocate a page for a VMA but the caller is expected
  * to specify via movableflags whether the page will be movable in the
- * future or not
+ * future or not. The page is taken from the pool of pre-zeroed pages if
+ * there is one.
  *
  * An architecture may override this function by defining
  * __HAVE_ARCH_ALLOC_ZEROED_USER_HIGHPAGE and providing their own
@@ -92,9 +94,12 @@ __alloc_zeroed_user_highpage(gfp_t movableflags,
 			struct vm_area_struct *vma,
 			unsigned long vaddr)
 {
-	struct page *page = alloc_page_vma(GFP_HIGHUSER | movableflags,
-			vma, vaddr);
+	struct page *page = prezero_alloc(GFP_HIGHUSER | movableflags);
 
+	if (page)
+		return page;
+
+	page = alloc_page_vma(GFP_HIGHUSER | movableflags, vma, vaddr);
 	if (page)
 		clear_user_highpage(page, vaddr);
 
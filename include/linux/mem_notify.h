@@ -0,0 +1,25 @@
+#ifndef _LINUX_MEM_NOTIFY_H
+#define _LINUX_MEM_NOTIFY_H
+
+/*
+ * Memory pressure levels reported by /dev/mem_notify, see
+ * Documentation/vm/mem_notify.txt.
+ */
+enum mem_pressure {
+	MEM_PRESSURE_NONE,	/* all zones above pages_low */
+	MEM_PRESSURE_LOW,	/* a zone below pages_low */
+	MEM_PRESSURE_MEDIUM,	/* below pages_min, or reclaim struggles */
+	MEM_PRESSURE_CRITICAL,	/* direct reclaim struggles */
+};
+
+#ifdef __KERNEL__
+#ifdef CONFIG_MEM_NOTIFY
+extern void mem_notify_pressure(enum mem_pressure level);
+#else
+static inline void mem_notify_pressure(enum mem_pressure level)
+{
+}
+#endif
+#endif /* __KERNEL__ */
+
+#endif /* _LINUX_MEM_NOTIFY_H */
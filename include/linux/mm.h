@@ -114,6 +114,7 @@ extern unsigned int kobjsize(const void *objp);
 #define VM_CAN_NONLINEAR 0x08000000	/* Has ->fault & does nonlinear pages */
 #define VM_MIXEDMAP	0x10000000	/* Can contain "struct page" and pure PFN pages */
 #define VM_SAO		0x20000000	/* Strong Access Ordering (powerpc) */
+#define VM_MERGEABLE	0x80000000	/* KSM may merge identical pages */
 
 #ifndef VM_STACK_DEFAULT_FLAGS		/* arch can override this */
 #define VM_STACK_DEFAULT_FLAGS VM_DATA_DEFAULT_FLAGS
@@ -165,6 +166,10 @@ struct vm_fault {
 					 * is set (which is also implied by
 					 * VM_FAULT_ERROR).
 					 */
+	/* for ->map_pages() only */
+	pgoff_t max_pgoff;		/* map pages for offset from pgoff till
+					 * max_pgoff inclusive */
+	pte_t *pte;			/* pte entry associated with ->pgoff */
 };
 
 /*
@@ -177,6 +182,10 @@ struct vm_operations_struct {
 	void (*close)(struct vm_area_struct * area);
 	int (*fault)(struct vm_area_struct *vma, struct vm_fault *vmf);
 
+	/* map the pages around a read fault which are already in the page
+	 * cache, without sleeping: called with the page table lock held */
+	void (*map_pages)(struct vm_area_struct *vma, struct vm_fault *vmf);
+
 	/* notification that a previously read-only page is about to become
 	 * writable, if an error is returned it will cause a SIGBUS */
 	int (*page_mkwrite)(struct vm_area_struct *vma, struct page *page);
@@ -796,6 +805,8 @@ extern int vmtruncate_range(struct inode * inode, loff_t offset, loff_t end);
 #ifdef CONFIG_MMU
 extern int handle_mm_fault(struct mm_struct *mm, struct vm_area_struct *vma,
 			unsigned long address, int write_access);
+extern void do_set_pte(struct vm_area_struct *vma, unsigned long address,
+			struct page *page, pte_t *pte);
 #else
 static inline int handle_mm_fault(struct mm_struct *mm,
 			struct vm_area_struct *vma, unsigned long address,
@@ -861,14 +872,23 @@ int get_user_pages_fast(unsigned long start, int nr_pages, int write,
  *
  * Note that 'shrink' will be passed nr_to_scan == 0 when the VM is
  * querying the cache size, so a fastpath for that case is appropriate.
+ *
+ * 'batch' is the 'nr_to_scan' the VM passes in one call. Shrinkers which
+ * are expensive to call regardless of the count (eg. because they walk
+ * all tasks) should set it higher, so that they are called less often
+ * with more to scan. 0 means the default of 128.
  */
 struct shrinker {
 	int (*shrink)(int nr_to_scan, gfp_t gfp_mask);
 	int seeks;	/* seeks to recreate an obj */
+	int batch;	/* objs to scan per call, 0 for the default */
 
 	/* These are for internal use */
 	struct list_head list;
 	long nr;	/* objs pending delete */
+	unsigned long nr_calls;	/* calls which scanned objs */
+	unsigned long nr_freed;	/* objs freed by those calls */
+	u64 time_ns;		/* time spent in 'shrink' */
 };
 #define DEFAULT_SEEKS 2 /* A good number if you don't know better. */
 extern void register_shrinker(struct shrinker *);
@@ -1153,6 +1173,7 @@ extern void truncate_inode_pages_range(struct address_space *,
 
 /* generic vm_area_ops exported for stackable file systems */
 extern int filemap_fault(struct vm_area_struct *, struct vm_fault *);
+extern void filemap_map_pages(struct vm_area_struct *vma, struct vm_fault *vmf);
 
 /* mm/page-writeback.c */
 int write_one_page(struct page *page, int wait);
@@ -1181,6 +1202,33 @@ void page_cache_async_readahead(struct address_space *mapping,
 
 unsigned long max_sane_readahead(unsigned long nr);
 
+/* readahead_trace.c */
+#ifdef CONFIG_READAHEAD_TRACE
+extern int ra_trace_enabled;
+
+void __ra_trace_record(struct address_space *mapping, pgoff_t offset,
+		       unsigned long nr);
+int ra_trace_replay(struct file *filp, pgoff_t start, pgoff_t end);
+
+static inline void ra_trace_record(struct address_space *mapping,
+				   pgoff_t offset, unsigned long nr)
+{
+	if (unlikely(ra_trace_enabled))
+		__ra_trace_record(mapping, offset, nr);
+}
+#else
+static inline void ra_trace_record(struct address_space *mapping,
+				   pgoff_t offset, unsigned long nr)
+{
+}
+
+static inline int ra_trace_replay(struct file *filp, pgoff_t start,
+				  pgoff_t end)
+{
+	return -EINVAL;
+}
+#endif
+
 /* Do stack extension */
 extern int expand_stack(struct vm_area_struct *vma, unsigned long address);
 #ifdef CONFIG_IA64
@@ -1275,6 +1323,9 @@ int in_gate_area_no_task(unsigned long addr);
 
 int drop_caches_sysctl_handler(struct ctl_table *, int, struct file *,
 					void __user *, size_t *, loff_t *);
+extern int sysctl_fault_around_bytes;
+int fault_around_bytes_handler(struct ctl_table *, int, struct file *,
+					void __user *, size_t *, loff_t *);
 unsigned long shrink_slab(unsigned long scanned, gfp_t gfp_mask,
 			unsigned long lru_pages);
 
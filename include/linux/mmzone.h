@@ -266,6 +266,11 @@ enum zone_type {
 struct zone {
 	/* Fields commonly accessed by the page allocator */
 	unsigned long		pages_min, pages_low, pages_high;
+	/*
+	 * Extra free pages kswapd keeps above pages_low/pages_high after
+	 * a direct reclaim, until it has balanced the zone once.
+	 */
+	unsigned long		watermark_boost;
 	/*
 	 * We don't know if the memory that we're going to allocate will be freeable
 	 * or/and it will be released eventually, so to avoid totally wasting several
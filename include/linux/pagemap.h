@@ -25,6 +25,9 @@ enum mapping_flags {
 #ifdef CONFIG_UNEVICTABLE_LRU
 	AS_UNEVICTABLE	= __GFP_BITS_SHIFT + 3,	/* e.g., ramdisk, SHM_LOCK */
 #endif
+#ifdef CONFIG_PAGECACHE_PIN
+	AS_PINNED	= __GFP_BITS_SHIFT + 4,	/* has ranges pinned by fadvise */
+#endif
 };
 
 static inline void mapping_set_error(struct address_space *mapping, int error)
@@ -64,6 +67,44 @@ static inline int mapping_unevictable(struct address_space *mapping)
 }
 #endif
 
+#ifdef CONFIG_PAGECACHE_PIN
+extern int pagecache_pin_kbytes;
+
+int pagecache_pin(struct file *file, pgoff_t start, pgoff_t end);
+int pagecache_unpin(struct file *file, pgoff_t start, pgoff_t end);
+int __pagecache_pinned(struct address_space *mapping, pgoff_t index);
+
+/*
+ * Tests whether @page is in a file range pinned with POSIX_FADV_PIN, which
+ * keeps it on the unevictable list. Only mappings with pinned ranges need
+ * the lookup.
+ */
+static inline int pagecache_pinned(struct page *page)
+{
+	struct address_space *mapping = page_mapping(page);
+
+	if (likely(!mapping || !test_bit(AS_PINNED, &mapping->flags)))
+		return 0;
+	return __pagecache_pinned(mapping, page->index);
+}
+#else
+static inline int pagecache_pin(struct file *file, pgoff_t start, pgoff_t end)
+{
+	return -EINVAL;
+}
+
+static inline int pagecache_unpin(struct file *file, pgoff_t start,
+				  pgoff_t end)
+{
+	return -EINVAL;
+}
+
+static inline int pagecache_pinned(struct page *page)
+{
+	return 0;
+}
+#endif
+
 static inline gfp_t mapping_gfp_mask(struct address_space * mapping)
 {
 	return (__force gfp_t)mapping->flags & __GFP_BITS_MASK;
@@ -85,4 +85,10 @@
 #define PR_SET_TIMERSLACK 29
 #define PR_GET_TIMERSLACK 30
 
+/*
+ * Set the timerslack of the thread whose pid is arg3, or of the caller
+ * when it is 0, e.g. to let the timers of background tasks be batched
+ */
+#define PR_SET_TIMERSLACK_PID 31
+
 #endif /* _LINUX_PRCTL_H */
@@ -0,0 +1,36 @@
+#ifndef _LINUX_PREZERO_H
+#define _LINUX_PREZERO_H
+/*
+ * Pool of pages zeroed by idle CPUs, see mm/prezero.c.
+ */
+#include <linux/gfp.h>
+
+#ifdef CONFIG_PREZERO_PAGES
+extern int sysctl_prezero_pages;
+
+struct page *prezero_alloc(gfp_t gfp_mask);
+void prezero_idle(void);
+unsigned long prezero_total_pages(void);
+
+struct ctl_table;
+struct file;
+int prezero_sysctl_handler(struct ctl_table *table, int write,
+			   struct file *file, void __user *buffer,
+			   size_t *length, loff_t *ppos);
+#else
+static inline struct page *prezero_alloc(gfp_t gfp_mask)
+{
+	return NULL;
+}
+
+static inline void prezero_idle(void)
+{
+}
+
+static inline unsigned long prezero_total_pages(void)
+{
+	return 0;
+}
+#endif
+
+#endif /* _LINUX_PREZERO_H */
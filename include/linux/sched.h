@@ -331,6 +331,7 @@ extern signed long schedule_timeout(signed long timeout);
 extern signed long schedule_timeout_interruptible(signed long timeout);
 extern signed long schedule_timeout_killable(signed long timeout);
 extern signed long schedule_timeout_uninterruptible(signed long timeout);
+extern signed long schedule_timeout_slack(signed long timeout);
 asmlinkage void schedule(void);
 
 struct nsproxy;
@@ -420,6 +421,8 @@ extern int get_dumpable(struct mm_struct *mm);
 # define MMF_DUMP_MASK_DEFAULT_ELF	0
 #endif
 
+#define MMF_VM_MERGEABLE	16	/* KSM may merge identical pages */
+
 struct sighand_struct {
 	atomic_t		count;
 	struct k_sigaction	action[_NSIG];
@@ -468,6 +471,48 @@ struct thread_group_cputime {
 	struct task_cputime *totals;
 };
 
+/*
+ * Time a task spent stalled in direct reclaim, exported in
+ * /proc/<pid>/reclaim_stall.
+ */
+struct reclaim_stall {
+	unsigned long count;	/* number of direct reclaim runs */
+	u64 total_ns;		/* time spent in them */
+	u64 max_ns;		/* longest single run */
+};
+
+static inline void reclaim_stall_add(struct reclaim_stall *dst,
+				     struct reclaim_stall *src)
+{
+	dst->count += src->count;
+	dst->total_ns += src->total_ns;
+	if (src->max_ns > dst->max_ns)
+		dst->max_ns = src->max_ns;
+}
+
+#ifdef CONFIG_CPU_FREQ_TASK_STATS
+/*
+ * CPU time a task ran at each speed of its CPU, in ns, indexed by the
+ * position of the speed in the frequency table of the CPU. Speeds past
+ * the last state are counted in it. Exported by
+ * drivers/cpufreq/cpufreq_task_stats.c.
+ */
+#define CPUFREQ_TASK_STATES	8
+
+struct cpufreq_task_time {
+	u64 time[CPUFREQ_TASK_STATES];
+};
+
+static inline void cpufreq_task_time_add(struct cpufreq_task_time *dst,
+					 struct cpufreq_task_time *src)
+{
+	int i;
+
+	for (i = 0; i < CPUFREQ_TASK_STATES; i++)
+		dst->time[i] += src->time[i];
+}
+#endif
+
 /*
  * NOTE! "signal_struct" does not have it's own
  * locking, because a shared signal_struct always
@@ -561,6 +606,10 @@ struct signal_struct {
 	unsigned long min_flt, maj_flt, cmin_flt, cmaj_flt;
 	unsigned long inblock, oublock, cinblock, coublock;
 	struct task_io_accounting ioac;
+	struct reclaim_stall reclaim_stall;
+#ifdef CONFIG_CPU_FREQ_TASK_STATS
+	struct cpufreq_task_time cpufreq_time;
+#endif
 
 	/*
 	 * We don't bother to synchronize most readers of this at all,
@@ -1013,6 +1062,8 @@ struct sched_entity {
 	u64			last_wakeup;
 	u64			avg_overlap;
 
+	int			latency_nice;
+
 #ifdef CONFIG_SCHEDSTATS
 	u64			wait_start;
 	u64			wait_max;
@@ -1294,6 +1345,11 @@ struct task_struct {
 
 /* VM state */
 	struct reclaim_state *reclaim_state;
+	struct reclaim_stall reclaim_stall;
+
+#ifdef CONFIG_CPU_FREQ_TASK_STATS
+	struct cpufreq_task_time cpufreq_time;
+#endif
 
 	struct backing_dev_info *backing_dev_info;
 
@@ -1356,6 +1412,19 @@ struct task_struct {
 	unsigned long default_timer_slack_ns;
 
 	struct list_head	*scm_work_list;
+#ifdef CONFIG_FUNCTION_GRAPH_TRACER
+	/* Index of current stored adress in ret_stack */
+	int curr_ret_stack;
+	/* Stack of return addresses for return function tracing */
+	struct ftrace_ret_stack	*ret_stack;
+	/*
+	 * Number of functions that haven't been traced
+	 * because of depth overrun.
+	 */
+	atomic_t trace_overrun;
+	/* Pause for the tracing, against the tracer recursing */
+	atomic_t tracing_graph_pause;
+#endif
 };
 
 /*
@@ -1377,6 +1446,14 @@ struct task_struct {
 #define MAX_PRIO		(MAX_RT_PRIO + 40)
 #define DEFAULT_PRIO		(MAX_RT_PRIO + 20)
 
+/*
+ * Latency-nice values of SCHED_NORMAL tasks, see sched_set_latency_nice().
+ * Like nice values, lower means more urgent.
+ */
+#define MIN_LATENCY_NICE	-20
+#define MAX_LATENCY_NICE	19
+#define LATENCY_NICE_WIDTH	(MAX_LATENCY_NICE - MIN_LATENCY_NICE + 1)
+
 static inline int rt_prio(int prio)
 {
 	if (unlikely(prio < MAX_RT_PRIO))
@@ -1690,6 +1767,10 @@ int sched_rt_handler(struct ctl_table *table, int write,
 
 extern unsigned int sysctl_sched_compat_yield;
 
+#ifdef CONFIG_CFS_BANDWIDTH
+extern unsigned int sysctl_sched_cfs_bandwidth_slice;
+#endif
+
 #ifdef CONFIG_RT_MUTEXES
 extern int rt_mutex_getprio(struct task_struct *p);
 extern void rt_mutex_setprio(struct task_struct *p, int prio);
@@ -1706,6 +1787,7 @@ extern void set_user_nice(struct task_struct *p, long nice);
 extern int task_prio(const struct task_struct *p);
 extern int task_nice(const struct task_struct *p);
 extern int can_nice(const struct task_struct *p, const int nice);
+extern int sched_set_latency_nice(struct task_struct *p, int latency_nice);
 extern int task_curr(const struct task_struct *p);
 extern int idle_cpu(int cpu);
 extern int sched_setscheduler(struct task_struct *, int, struct sched_param *);
@@ -2233,6 +2315,14 @@ extern void sched_move_task(struct task_struct *tsk);
 extern int sched_group_set_shares(struct task_group *tg, unsigned long shares);
 extern unsigned long sched_group_shares(struct task_group *tg);
 #endif
+#ifdef CONFIG_CFS_BANDWIDTH
+extern int sched_group_set_cfs_quota(struct task_group *tg,
+				     long cfs_quota_us);
+extern long sched_group_cfs_quota(struct task_group *tg);
+extern int sched_group_set_cfs_period(struct task_group *tg,
+				      long cfs_period_us);
+extern long sched_group_cfs_period(struct task_group *tg);
+#endif
 #ifdef CONFIG_RT_GROUP_SCHED
 extern int sched_group_set_rt_runtime(struct task_group *tg,
 				      long rt_runtime_us);
@@ -94,6 +94,10 @@ struct kmem_cache {
 #ifdef CONFIG_SLUB_DEBUG
 	struct kobject kobj;	/* For sysfs */
 #endif
+#ifdef CONFIG_SLUB_PROFILE
+	unsigned int profile_rate;	/* Sample 1 in profile_rate calls */
+	struct kmem_profile *profile;
+#endif
 
 #ifdef CONFIG_NUMA
 	/*
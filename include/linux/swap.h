@@ -246,6 +246,7 @@ extern unsigned long try_to_free_mem_cgroup_pages(struct mem_cgroup *mem,
 extern int __isolate_lru_page(struct page *page, int mode, int file);
 extern unsigned long shrink_all_memory(unsigned long nr_pages);
 extern int vm_swappiness;
+extern int watermark_boost_factor;
 extern int remove_mapping(struct address_space *mapping, struct page *page);
 extern long vm_total_pages;
 
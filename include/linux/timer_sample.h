@@ -0,0 +1,44 @@
+#ifndef _LINUX_TIMER_SAMPLE_H
+#define _LINUX_TIMER_SAMPLE_H
+
+#include <linux/percpu.h>
+
+struct task_struct;
+
+#define TIMER_SAMPLE_WHEEL	0
+#define TIMER_SAMPLE_HRTIMER	1
+
+#ifdef CONFIG_TIMER_SAMPLE
+
+DECLARE_PER_CPU(int, timer_sample_wakeup);
+
+extern void timer_sample(void *function, struct task_struct *task, int type);
+extern void timer_sample_idle_exit(int cpu);
+
+/*
+ * Called from irq_exit(), after the softirqs ran: the interrupt woke the
+ * CPU for no timer if none has claimed the wakeup by now.
+ */
+static inline void timer_sample_irq_exit(void)
+{
+	__get_cpu_var(timer_sample_wakeup) = 0;
+}
+
+#else
+
+static inline void timer_sample(void *function, struct task_struct *task,
+				int type)
+{
+}
+
+static inline void timer_sample_idle_exit(int cpu)
+{
+}
+
+static inline void timer_sample_irq_exit(void)
+{
+}
+
+#endif
+
+#endif
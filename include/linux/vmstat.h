@@ -32,12 +32,14 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 		FOR_ALL_ZONES(PGALLOC),
 		PGFREE, PGACTIVATE, PGDEACTIVATE,
 		PGFAULT, PGMAJFAULT,
+		FAULTAROUND_MAPPED,	/* pages mapped around a read fault */
+		FAULTAROUND_HIT,	/* faults served by fault-around alone */
 		FOR_ALL_ZONES(PGREFILL),
 		FOR_ALL_ZONES(PGSTEAL),
 		FOR_ALL_ZONES(PGSCAN_KSWAPD),
 		FOR_ALL_ZONES(PGSCAN_DIRECT),
 		PGINODESTEAL, SLABS_SCANNED, KSWAPD_STEAL, KSWAPD_INODESTEAL,
-		PAGEOUTRUN, ALLOCSTALL, PGROTATED,
+		PAGEOUTRUN, ALLOCSTALL, KSWAPD_BOOST, PGROTATED,
 #ifdef CONFIG_HUGETLB_PAGE
 		HTLB_BUDDY_PGALLOC, HTLB_BUDDY_PGALLOC_FAIL,
 #endif
@@ -50,6 +52,12 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 		UNEVICTABLE_PGCLEARED,	/* on COW, page truncate */
 		UNEVICTABLE_PGSTRANDED,	/* unable to isolate on unlock */
 		UNEVICTABLE_MLOCKFREED,
+#endif
+#ifdef CONFIG_PREZERO_PAGES
+		PREZERO_FILL,		/* zeroed by an idle cpu */
+		PREZERO_HIT,		/* allocation served from the pool */
+		PREZERO_MISS,		/* allocation found the pool empty */
+		PREZERO_DRAIN,		/* given back to the page allocator */
 #endif
 		NR_VM_EVENT_ITEMS
 };
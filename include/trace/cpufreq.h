@@ -0,0 +1,18 @@
+#ifndef _TRACE_CPUFREQ_H
+#define _TRACE_CPUFREQ_H
+
+#include <linux/cpufreq.h>
+#include <linux/tracepoint.h>
+
+/* A governor or user asks for a speed */
+DEFINE_TRACE(cpufreq_target,
+	TPPROTO(struct cpufreq_policy *policy, unsigned int target_freq,
+		unsigned int relation),
+		TPARGS(policy, target_freq, relation));
+
+/* The driver has changed the speed of freqs->cpu */
+DEFINE_TRACE(cpufreq_transition,
+	TPPROTO(struct cpufreq_freqs *freqs),
+		TPARGS(freqs));
+
+#endif
@@ -120,6 +120,10 @@ static void __exit_signal(struct task_struct *tsk)
 		sig->inblock += task_io_get_inblock(tsk);
 		sig->oublock += task_io_get_oublock(tsk);
 		task_io_accounting_add(&sig->ioac, &tsk->ioac);
+		reclaim_stall_add(&sig->reclaim_stall, &tsk->reclaim_stall);
+#ifdef CONFIG_CPU_FREQ_TASK_STATS
+		cpufreq_task_time_add(&sig->cpufreq_time, &tsk->cpufreq_time);
+#endif
 		sig = NULL; /* Marker for below. */
 	}
 
@@ -59,6 +59,8 @@
 #include <linux/tty.h>
 #include <linux/proc_fs.h>
 #include <linux/blkdev.h>
+#include <linux/ksm.h>
+#include <linux/ftrace.h>
 #include <trace/sched.h>
 
 #include <asm/pgtable.h>
@@ -137,6 +139,7 @@ void free_task(struct task_struct *tsk)
 	prop_local_destroy_single(&tsk->dirties);
 	free_thread_info(tsk->stack);
 	rt_mutex_debug_task_free(tsk);
+	ftrace_graph_exit_task(tsk);
 	free_task_struct(tsk);
 }
 EXPORT_SYMBOL(free_task);
@@ -281,6 +284,9 @@ static int dup_mmap(struct mm_struct *mm, struct mm_struct *oldmm)
 	rb_link = &mm->mm_rb.rb_node;
 	rb_parent = NULL;
 	pprev = &mm->mmap;
+	retval = ksm_fork(mm, oldmm);
+	if (retval)
+		goto out;
 
 	for (mpnt = oldmm->mmap; mpnt; mpnt = mpnt->vm_next) {
 		struct file *file;
@@ -407,6 +413,7 @@ static struct mm_struct * mm_init(struct mm_struct * mm, struct task_struct *p)
 	INIT_LIST_HEAD(&mm->mmlist);
 	mm->flags = (current->mm) ? current->mm->flags
 				  : MMF_DUMP_FILTER_DEFAULT;
+	clear_bit(MMF_VM_MERGEABLE, &mm->flags);
 	mm->core_state = NULL;
 	mm->nr_ptes = 0;
 	set_mm_counter(mm, file_rss, 0);
@@ -467,6 +474,7 @@ void mmput(struct mm_struct *mm)
 
 	if (atomic_dec_and_test(&mm->mm_users)) {
 		exit_aio(mm);
+		ksm_exit(mm);
 		exit_mmap(mm);
 		set_mm_exe_file(mm, NULL);
 		if (!list_empty(&mm->mmlist)) {
@@ -850,6 +858,10 @@ static int copy_signal(unsigned long clone_flags, struct task_struct *tsk)
 	sig->min_flt = sig->maj_flt = sig->cmin_flt = sig->cmaj_flt = 0;
 	sig->inblock = sig->oublock = sig->cinblock = sig->coublock = 0;
 	task_io_accounting_init(&sig->ioac);
+	memset(&sig->reclaim_stall, 0, sizeof(sig->reclaim_stall));
+#ifdef CONFIG_CPU_FREQ_TASK_STATS
+	memset(&sig->cpufreq_time, 0, sizeof(sig->cpufreq_time));
+#endif
 	taskstats_tgid_init(sig);
 
 	task_lock(current->group_leader);
@@ -977,6 +989,8 @@ static struct task_struct *copy_process(unsigned long clone_flags,
 	if (!p)
 		goto fork_out;
 
+	ftrace_graph_init_task(p);
+
 	rt_mutex_init_task(p);
 
 #ifdef CONFIG_PROVE_LOCKING
@@ -1040,6 +1054,10 @@ static struct task_struct *copy_process(unsigned long clone_flags,
 #endif
 
 	task_io_accounting_init(&p->ioac);
+	memset(&p->reclaim_stall, 0, sizeof(p->reclaim_stall));
+#ifdef CONFIG_CPU_FREQ_TASK_STATS
+	memset(&p->cpufreq_time, 0, sizeof(p->cpufreq_time));
+#endif
 	acct_clear_integrals(p);
 
 	posix_cpu_timers_init(p);
@@ -44,6 +44,7 @@
 #include <linux/seq_file.h>
 #include <linux/err.h>
 #include <linux/debugobjects.h>
+#include <linux/timer_sample.h>
 
 #include <asm/uaccess.h>
 
@@ -1194,6 +1195,34 @@ int hrtimer_get_res(const clockid_t which_clock, struct timespec *tp)
 }
 EXPORT_SYMBOL_GPL(hrtimer_get_res);
 
+#ifdef CONFIG_TIMER_SAMPLE
+static enum hrtimer_restart hrtimer_wakeup(struct hrtimer *timer);
+
+static void sample_hrtimer(struct hrtimer *timer)
+{
+	enum hrtimer_restart (*fn)(struct hrtimer *) = timer->function;
+	struct task_struct *task = NULL;
+
+#ifdef CONFIG_TICK_ONESHOT
+	/* The tick is accounted to the timer wheel timers it runs */
+	if (timer == &tick_get_tick_sched(smp_processor_id())->sched_timer)
+		return;
+#endif
+	if (fn == hrtimer_wakeup)
+		task = container_of(timer, struct hrtimer_sleeper, timer)->task;
+
+	rcu_read_lock();
+	if (fn == it_real_fn)
+		task = pid_task(container_of(timer, struct signal_struct,
+					     real_timer)->leader_pid,
+				PIDTYPE_PID);
+	timer_sample(fn, task, TIMER_SAMPLE_HRTIMER);
+	rcu_read_unlock();
+}
+#else
+static inline void sample_hrtimer(struct hrtimer *timer) { }
+#endif
+
 static void run_hrtimer_pending(struct hrtimer_cpu_base *cpu_base)
 {
 	spin_lock_irq(&cpu_base->lock);
@@ -1209,6 +1238,7 @@ static void run_hrtimer_pending(struct hrtimer_cpu_base *cpu_base)
 
 		debug_hrtimer_deactivate(timer);
 		timer_stats_account_hrtimer(timer);
+		sample_hrtimer(timer);
 
 		fn = timer->function;
 		/*
@@ -1273,6 +1303,7 @@ static void __run_hrtimer(struct hrtimer *timer)
 	debug_hrtimer_deactivate(timer);
 	__remove_hrtimer(timer, base, HRTIMER_STATE_CALLBACK, 0);
 	timer_stats_account_hrtimer(timer);
+	sample_hrtimer(timer);
 
 	fn = timer->function;
 	if (timer->cb_mode == HRTIMER_CB_IRQSAFE_PERCPU ||
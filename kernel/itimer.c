@@ -167,7 +167,9 @@ again:
 		if (expires.tv64 != 0) {
 			tsk->signal->it_real_incr =
 				timeval_to_ktime(value->it_interval);
-			hrtimer_start(timer, expires, HRTIMER_MODE_REL);
+			hrtimer_start_range_ns(timer, expires,
+					       tsk->timer_slack_ns,
+					       HRTIMER_MODE_REL);
 		} else
 			tsk->signal->it_real_incr.tv64 = 0;
 
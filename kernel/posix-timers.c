@@ -744,7 +744,10 @@ common_timer_set(struct k_itimer *timr, int flags,
 	hrtimer_init(&timr->it.real.timer, timr->it_clock, mode);
 	timr->it.real.timer.function = posix_timer_fn;
 
-	hrtimer_set_expires(timer, timespec_to_ktime(new_setting->it_value));
+	/* The timer may expire as late as the slack of its owner allows */
+	hrtimer_set_expires_range_ns(timer,
+				     timespec_to_ktime(new_setting->it_value),
+				     current->timer_slack_ns);
 
 	/* Convert interval */
 	timr->it.real.interval = timespec_to_ktime(new_setting->it_interval);
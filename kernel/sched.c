@@ -242,6 +242,97 @@ static void destroy_rt_bandwidth(struct rt_bandwidth *rt_b)
 }
 #endif
 
+#ifdef CONFIG_CFS_BANDWIDTH
+/*
+ * CPU time a group of fair tasks may use per period, handed out to its
+ * cfs_rqs a slice at a time and refilled by the period timer, which is
+ * stopped once the group asked for nothing over a period.
+ */
+static inline u64 default_cfs_period(void)
+{
+	return 100000000ULL;
+}
+
+struct cfs_bandwidth {
+	/* nests inside the rq lock: */
+	spinlock_t		lock;
+	ktime_t			period;
+	u64			quota;
+	u64			runtime;
+	int			idle;
+	int			timer_active;
+	struct hrtimer		period_timer;
+
+	/* statistics */
+	u64			nr_periods;
+	u64			nr_throttled;
+	u64			throttled_time;
+};
+
+static int do_sched_cfs_period_timer(struct cfs_bandwidth *cfs_b, int overrun);
+
+static enum hrtimer_restart sched_cfs_period_timer(struct hrtimer *timer)
+{
+	struct cfs_bandwidth *cfs_b =
+		container_of(timer, struct cfs_bandwidth, period_timer);
+	ktime_t now;
+	int overrun;
+	int idle = 0;
+
+	for (;;) {
+		now = hrtimer_cb_get_time(timer);
+		overrun = hrtimer_forward(timer, now, cfs_b->period);
+
+		if (!overrun)
+			break;
+
+		/* Once idle, the timer may be restarted: don't touch it */
+		idle = do_sched_cfs_period_timer(cfs_b, overrun);
+		if (idle)
+			break;
+	}
+
+	return idle ? HRTIMER_NORESTART : HRTIMER_RESTART;
+}
+
+static void init_cfs_bandwidth(struct cfs_bandwidth *cfs_b)
+{
+	spin_lock_init(&cfs_b->lock);
+	cfs_b->period = ns_to_ktime(default_cfs_period());
+	cfs_b->quota = RUNTIME_INF;
+	cfs_b->runtime = 0;
+
+	hrtimer_init(&cfs_b->period_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	cfs_b->period_timer.function = sched_cfs_period_timer;
+	cfs_b->period_timer.cb_mode = HRTIMER_CB_IRQSAFE_UNLOCKED;
+}
+
+/*
+ * Called with cfs_b->lock held. The callback of the timer may still be
+ * running after it cleared timer_active, so this does not check whether
+ * the timer is active but whether it got queued, like start_rt_bandwidth().
+ */
+static void __start_cfs_bandwidth(struct cfs_bandwidth *cfs_b)
+{
+	ktime_t now;
+
+	if (cfs_b->timer_active)
+		return;
+
+	cfs_b->timer_active = 1;
+	while (!hrtimer_is_queued(&cfs_b->period_timer)) {
+		now = hrtimer_cb_get_time(&cfs_b->period_timer);
+		hrtimer_forward(&cfs_b->period_timer, now, cfs_b->period);
+		hrtimer_start_expires(&cfs_b->period_timer, HRTIMER_MODE_ABS);
+	}
+}
+
+static void destroy_cfs_bandwidth(struct cfs_bandwidth *cfs_b)
+{
+	hrtimer_cancel(&cfs_b->period_timer);
+}
+#endif
+
 /*
  * sched_domains_mutex serializes calls to arch_init_sched_domains,
  * detach_destroy_domains and partition_sched_domains.
@@ -268,6 +359,9 @@ struct task_group {
 	/* runqueue "owned" by this group on each cpu */
 	struct cfs_rq **cfs_rq;
 	unsigned long shares;
+#ifdef CONFIG_CFS_BANDWIDTH
+	struct cfs_bandwidth cfs_bandwidth;
+#endif
 #endif
 
 #ifdef CONFIG_RT_GROUP_SCHED
@@ -416,6 +510,18 @@ struct cfs_rq {
 	struct list_head leaf_cfs_rq_list;
 	struct task_group *tg;	/* group that "owns" this runqueue */
 
+#ifdef CONFIG_CFS_BANDWIDTH
+	/*
+	 * Runtime left of the slices taken from tg->cfs_bandwidth. Once it
+	 * is used up and the group has none left, the cfs_rq is throttled:
+	 * its entity is taken off the parent until the next period.
+	 */
+	int runtime_enabled;
+	s64 runtime_remaining;
+	int throttled;
+	u64 throttled_timestamp;
+#endif
+
 #ifdef CONFIG_SMP
 	/*
 	 * the part of load.weight contributed by tasks
@@ -1391,6 +1497,18 @@ static void cpuacct_charge(struct task_struct *tsk, u64 cputime);
 static inline void cpuacct_charge(struct task_struct *tsk, u64 cputime) {}
 #endif
 
+#ifdef CONFIG_CPU_FREQ_TASK_STATS
+/* Charge runtime to the speed its CPU is running at, for cpufreq_task_stats */
+static inline void cpufreq_charge(struct task_struct *tsk, u64 cputime)
+{
+	unsigned int state = per_cpu(cpufreq_task_state, task_cpu(tsk));
+
+	tsk->cpufreq_time.time[state] += cputime;
+}
+#else
+static inline void cpufreq_charge(struct task_struct *tsk, u64 cputime) {}
+#endif
+
 static inline void inc_cpu_load(struct rq *rq, unsigned long load)
 {
 	update_load_add(&rq->load, load);
@@ -4361,6 +4479,13 @@ static inline unsigned long get_parent_ip(unsigned long addr)
 	return addr;
 }
 
+/*
+ * Finding the parent walks the stack on ARM: leave it to the times a
+ * preempt-off tracer or histogram wants it.
+ */
+#define preempt_parent_ip()						\
+	(trace_preempt_active ? get_parent_ip(CALLER_ADDR1) : 0UL)
+
 void __kprobes add_preempt_count(int val)
 {
 #ifdef CONFIG_DEBUG_PREEMPT
@@ -4379,7 +4504,7 @@ void __kprobes add_preempt_count(int val)
 				PREEMPT_MASK - 10);
 #endif
 	if (preempt_count() == val)
-		trace_preempt_off(CALLER_ADDR0, get_parent_ip(CALLER_ADDR1));
+		trace_preempt_off(CALLER_ADDR0, preempt_parent_ip());
 }
 EXPORT_SYMBOL(add_preempt_count);
 
@@ -4400,7 +4525,7 @@ void __kprobes sub_preempt_count(int val)
 #endif
 
 	if (preempt_count() == val)
-		trace_preempt_on(CALLER_ADDR0, get_parent_ip(CALLER_ADDR1));
+		trace_preempt_on(CALLER_ADDR0, preempt_parent_ip());
 	preempt_count() -= val;
 }
 EXPORT_SYMBOL(sub_preempt_count);
@@ -5066,6 +5191,31 @@ int can_nice(const struct task_struct *p, const int nice)
 		capable(CAP_SYS_NICE));
 }
 
+/**
+ * sched_set_latency_nice - set the latency-nice value of a task
+ * @p: the task in question.
+ * @latency_nice: new value, from MIN_LATENCY_NICE to MAX_LATENCY_NICE.
+ *
+ * A lower latency-nice value makes a fair task preempt others sooner on
+ * wakeup and run in shorter slices, without changing its share of the
+ * CPU. Lowering the value needs CAP_SYS_NICE.
+ */
+int sched_set_latency_nice(struct task_struct *p, int latency_nice)
+{
+	unsigned long flags;
+	struct rq *rq;
+
+	if (latency_nice < MIN_LATENCY_NICE || latency_nice > MAX_LATENCY_NICE)
+		return -EINVAL;
+	if (latency_nice < p->se.latency_nice && !capable(CAP_SYS_NICE))
+		return -EPERM;
+
+	rq = task_rq_lock(p, &flags);
+	p->se.latency_nice = latency_nice;
+	task_rq_unlock(rq, &flags);
+	return 0;
+}
+
 #ifdef __ARCH_WANT_SYS_NICE
 
 /*
@@ -8255,6 +8405,10 @@ void __init sched_init(void)
 #endif /* CONFIG_USER_SCHED */
 #endif /* CONFIG_RT_GROUP_SCHED */
 
+#ifdef CONFIG_CFS_BANDWIDTH
+	init_cfs_bandwidth(&init_task_group.cfs_bandwidth);
+#endif
+
 #ifdef CONFIG_GROUP_SCHED
 	list_add(&init_task_group.list, &task_groups);
 	INIT_LIST_HEAD(&init_task_group.children);
@@ -8537,6 +8691,10 @@ static void free_fair_sched_group(struct task_group *tg)
 {
 	int i;
 
+#ifdef CONFIG_CFS_BANDWIDTH
+	destroy_cfs_bandwidth(&tg->cfs_bandwidth);
+#endif
+
 	for_each_possible_cpu(i) {
 		if (tg->cfs_rq)
 			kfree(tg->cfs_rq[i]);
@@ -8556,6 +8714,10 @@ int alloc_fair_sched_group(struct task_group *tg, struct task_group *parent)
 	struct rq *rq;
 	int i;
 
+#ifdef CONFIG_CFS_BANDWIDTH
+	init_cfs_bandwidth(&tg->cfs_bandwidth);
+#endif
+
 	tg->cfs_rq = kzalloc(sizeof(cfs_rq) * nr_cpu_ids, GFP_KERNEL);
 	if (!tg->cfs_rq)
 		goto err;
@@ -8910,6 +9072,100 @@ unsigned long sched_group_shares(struct task_group *tg)
 }
 #endif
 
+#ifdef CONFIG_CFS_BANDWIDTH
+static DEFINE_MUTEX(cfs_constraints_mutex);
+
+/* Bounds of the period of a group, and least quota: 1ms to 1s */
+#define MIN_CFS_PERIOD	NSEC_PER_MSEC
+#define MAX_CFS_PERIOD	NSEC_PER_SEC
+
+static int tg_set_cfs_bandwidth(struct task_group *tg, u64 period, u64 quota)
+{
+	struct cfs_bandwidth *cfs_b = tg_cfs_bandwidth(tg);
+	int i, runtime_enabled = quota != RUNTIME_INF;
+
+	/*
+	 * We can't limit the root cgroup.
+	 */
+	if (!tg->se[0])
+		return -EINVAL;
+
+	if (period < MIN_CFS_PERIOD || period > MAX_CFS_PERIOD)
+		return -EINVAL;
+	if (quota < MIN_CFS_PERIOD)
+		return -EINVAL;
+
+	mutex_lock(&cfs_constraints_mutex);
+	spin_lock_irq(&cfs_b->lock);
+	cfs_b->period = ns_to_ktime(period);
+	cfs_b->quota = quota;
+	cfs_b->runtime = runtime_enabled ? quota : 0;
+	if (runtime_enabled)
+		__start_cfs_bandwidth(cfs_b);
+	spin_unlock_irq(&cfs_b->lock);
+
+	for_each_possible_cpu(i) {
+		struct cfs_rq *cfs_rq = tg->cfs_rq[i];
+		struct rq *rq = rq_of(cfs_rq);
+
+		spin_lock_irq(&rq->lock);
+		cfs_rq->runtime_enabled = runtime_enabled;
+		cfs_rq->runtime_remaining = 0;
+		if (cfs_rq_throttled(cfs_rq)) {
+			update_rq_clock(rq);
+			unthrottle_cfs_rq(cfs_rq);
+		}
+		spin_unlock_irq(&rq->lock);
+	}
+	mutex_unlock(&cfs_constraints_mutex);
+
+	return 0;
+}
+
+int sched_group_set_cfs_quota(struct task_group *tg, long cfs_quota_us)
+{
+	u64 quota, period;
+
+	period = ktime_to_ns(tg_cfs_bandwidth(tg)->period);
+	quota = (u64)cfs_quota_us * NSEC_PER_USEC;
+	if (cfs_quota_us < 0)
+		quota = RUNTIME_INF;
+
+	return tg_set_cfs_bandwidth(tg, period, quota);
+}
+
+long sched_group_cfs_quota(struct task_group *tg)
+{
+	u64 quota_us;
+
+	if (tg_cfs_bandwidth(tg)->quota == RUNTIME_INF)
+		return -1;
+
+	quota_us = tg_cfs_bandwidth(tg)->quota;
+	do_div(quota_us, NSEC_PER_USEC);
+	return quota_us;
+}
+
+int sched_group_set_cfs_period(struct task_group *tg, long cfs_period_us)
+{
+	u64 quota, period;
+
+	period = (u64)cfs_period_us * NSEC_PER_USEC;
+	quota = tg_cfs_bandwidth(tg)->quota;
+
+	return tg_set_cfs_bandwidth(tg, period, quota);
+}
+
+long sched_group_cfs_period(struct task_group *tg)
+{
+	u64 period_us;
+
+	period_us = ktime_to_ns(tg_cfs_bandwidth(tg)->period);
+	do_div(period_us, NSEC_PER_USEC);
+	return period_us;
+}
+#endif /* CONFIG_CFS_BANDWIDTH */
+
 #ifdef CONFIG_RT_GROUP_SCHED
 /*
  * Ensure that the real time constraints are schedulable.
@@ -9238,6 +9494,49 @@ static u64 cpu_shares_read_u64(struct cgroup *cgrp, struct cftype *cft)
 }
 #endif /* CONFIG_FAIR_GROUP_SCHED */
 
+#ifdef CONFIG_CFS_BANDWIDTH
+static int cpu_cfs_quota_write_s64(struct cgroup *cgrp, struct cftype *cftype,
+				   s64 cfs_quota_us)
+{
+	return sched_group_set_cfs_quota(cgroup_tg(cgrp), cfs_quota_us);
+}
+
+static s64 cpu_cfs_quota_read_s64(struct cgroup *cgrp, struct cftype *cft)
+{
+	return sched_group_cfs_quota(cgroup_tg(cgrp));
+}
+
+static int cpu_cfs_period_write_u64(struct cgroup *cgrp, struct cftype *cftype,
+				    u64 cfs_period_us)
+{
+	return sched_group_set_cfs_period(cgroup_tg(cgrp), cfs_period_us);
+}
+
+static u64 cpu_cfs_period_read_u64(struct cgroup *cgrp, struct cftype *cft)
+{
+	return sched_group_cfs_period(cgroup_tg(cgrp));
+}
+
+static int cpu_stats_show(struct cgroup *cgrp, struct cftype *cft,
+			  struct cgroup_map_cb *cb)
+{
+	struct cfs_bandwidth *cfs_b = tg_cfs_bandwidth(cgroup_tg(cgrp));
+	u64 nr_periods, nr_throttled, throttled_time;
+
+	spin_lock_irq(&cfs_b->lock);
+	nr_periods = cfs_b->nr_periods;
+	nr_throttled = cfs_b->nr_throttled;
+	throttled_time = cfs_b->throttled_time;
+	spin_unlock_irq(&cfs_b->lock);
+
+	cb->fill(cb, "nr_periods", nr_periods);
+	cb->fill(cb, "nr_throttled", nr_throttled);
+	cb->fill(cb, "throttled_time", throttled_time);
+
+	return 0;
+}
+#endif /* CONFIG_CFS_BANDWIDTH */
+
 #ifdef CONFIG_RT_GROUP_SCHED
 static int cpu_rt_runtime_write(struct cgroup *cgrp, struct cftype *cft,
 				s64 val)
@@ -9270,6 +9569,22 @@ static struct cftype cpu_files[] = {
 		.write_u64 = cpu_shares_write_u64,
 	},
 #endif
+#ifdef CONFIG_CFS_BANDWIDTH
+	{
+		.name = "cfs_quota_us",
+		.read_s64 = cpu_cfs_quota_read_s64,
+		.write_s64 = cpu_cfs_quota_write_s64,
+	},
+	{
+		.name = "cfs_period_us",
+		.read_u64 = cpu_cfs_period_read_u64,
+		.write_u64 = cpu_cfs_period_write_u64,
+	},
+	{
+		.name = "stat",
+		.read_map = cpu_stats_show,
+	},
+#endif
 #ifdef CONFIG_RT_GROUP_SCHED
 	{
 		.name = "rt_runtime_us",
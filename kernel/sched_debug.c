@@ -355,6 +355,7 @@ void proc_sched_show_task(struct task_struct *p, struct seq_file *m)
 	PN(se.vruntime);
 	PN(se.sum_exec_runtime);
 	PN(se.avg_overlap);
+	P(se.latency_nice);
 
 	nr_switches = p->nvcsw + p->nivcsw;
 
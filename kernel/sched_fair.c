@@ -73,6 +73,16 @@ unsigned int sysctl_sched_wakeup_granularity = 5000000UL;
 
 const_debug unsigned int sysctl_sched_migration_cost = 500000UL;
 
+#ifdef CONFIG_CFS_BANDWIDTH
+/*
+ * Amount of runtime a cfs_rq takes from the bandwidth of its group at a
+ * time; a larger slice means fewer trips to the group-wide lock but more
+ * runtime left unused on other CPUs.
+ * (default: 5 msec, units: microseconds)
+ */
+unsigned int sysctl_sched_cfs_bandwidth_slice = 5000UL;
+#endif
+
 static const struct sched_class fair_sched_class;
 
 /**************************************************************
@@ -441,11 +451,33 @@ static u64 __sched_period(unsigned long nr_running)
 static u64 sched_slice(struct cfs_rq *cfs_rq, struct sched_entity *se)
 {
 	unsigned long nr_running = cfs_rq->nr_running;
+	u64 slice;
 
 	if (unlikely(!se->on_rq))
 		nr_running++;
 
-	return calc_delta_weight(__sched_period(nr_running), se);
+	slice = calc_delta_weight(__sched_period(nr_running), se);
+
+	/*
+	 * Latency-nice scales the slice from half of it at -20 to about
+	 * one and a half at 19, but a latency-sensitive task is not made
+	 * to run less than the minimal granularity at a time:
+	 *
+	 * s' = s*(W+l)/W
+	 */
+	if (sched_feat(LATENCY_NICE) && se->latency_nice) {
+		u64 scaled = div_u64(slice * (LATENCY_NICE_WIDTH +
+					      se->latency_nice),
+				     LATENCY_NICE_WIDTH);
+
+		if (se->latency_nice > 0)
+			slice = scaled;
+		else if (slice > sysctl_sched_min_granularity)
+			slice = max_t(u64, scaled,
+				      sysctl_sched_min_granularity);
+	}
+
+	return slice;
 }
 
 /*
@@ -458,6 +490,75 @@ static u64 sched_vslice(struct cfs_rq *cfs_rq, struct sched_entity *se)
 	return calc_delta_fair(sched_slice(cfs_rq, se), se);
 }
 
+#ifdef CONFIG_CFS_BANDWIDTH
+static inline u64 sched_cfs_bandwidth_slice(void)
+{
+	return (u64)sysctl_sched_cfs_bandwidth_slice * NSEC_PER_USEC;
+}
+
+static inline struct cfs_bandwidth *tg_cfs_bandwidth(struct task_group *tg)
+{
+	return &tg->cfs_bandwidth;
+}
+
+static inline int cfs_rq_throttled(struct cfs_rq *cfs_rq)
+{
+	return cfs_rq->throttled;
+}
+
+/*
+ * Tops up the runtime of @cfs_rq to a slice from what its group has left
+ * for this period, which may be nothing.
+ */
+static void assign_cfs_rq_runtime(struct cfs_rq *cfs_rq)
+{
+	struct cfs_bandwidth *cfs_b = tg_cfs_bandwidth(cfs_rq->tg);
+	u64 amount;
+
+	amount = sched_cfs_bandwidth_slice() - cfs_rq->runtime_remaining;
+
+	spin_lock(&cfs_b->lock);
+	if (cfs_b->quota != RUNTIME_INF) {
+		__start_cfs_bandwidth(cfs_b);
+		cfs_b->idle = 0;
+		amount = min(amount, cfs_b->runtime);
+		cfs_b->runtime -= amount;
+	}
+	spin_unlock(&cfs_b->lock);
+
+	cfs_rq->runtime_remaining += amount;
+}
+
+static void account_cfs_rq_runtime(struct cfs_rq *cfs_rq,
+				   unsigned long delta_exec)
+{
+	if (!cfs_rq->runtime_enabled)
+		return;
+
+	cfs_rq->runtime_remaining -= delta_exec;
+	if (likely(cfs_rq->runtime_remaining > 0))
+		return;
+
+	/*
+	 * Out of runtime: the cfs_rq is throttled once its entity is put
+	 * back, see check_cfs_rq_runtime().
+	 */
+	assign_cfs_rq_runtime(cfs_rq);
+	if (cfs_rq->runtime_remaining <= 0 && likely(cfs_rq->curr))
+		resched_task(rq_of(cfs_rq)->curr);
+}
+#else /* !CONFIG_CFS_BANDWIDTH */
+static inline int cfs_rq_throttled(struct cfs_rq *cfs_rq)
+{
+	return 0;
+}
+
+static inline void account_cfs_rq_runtime(struct cfs_rq *cfs_rq,
+					  unsigned long delta_exec)
+{
+}
+#endif /* CONFIG_CFS_BANDWIDTH */
+
 /*
  * Update the current task's runtime statistics. Skip current tasks that
  * are not in our scheduling class.
@@ -495,11 +596,13 @@ static void update_curr(struct cfs_rq *cfs_rq)
 
 	__update_curr(cfs_rq, curr, delta_exec);
 	curr->exec_start = now;
+	account_cfs_rq_runtime(cfs_rq, delta_exec);
 
 	if (entity_is_task(curr)) {
 		struct task_struct *curtask = task_of(curr);
 
 		cpuacct_charge(curtask, delta_exec);
+		cpufreq_charge(curtask, delta_exec);
 		account_group_exec_runtime(curtask, delta_exec);
 	}
 }
@@ -759,6 +862,163 @@ dequeue_entity(struct cfs_rq *cfs_rq, struct sched_entity *se, int sleep)
 	update_min_vruntime(cfs_rq);
 }
 
+#ifdef CONFIG_CFS_BANDWIDTH
+/* Takes the entity of @cfs_rq, and so all it holds, off the parent */
+static void throttle_cfs_rq(struct cfs_rq *cfs_rq)
+{
+	struct rq *rq = rq_of(cfs_rq);
+	struct sched_entity *se = cfs_rq->tg->se[cpu_of(rq)];
+
+	for_each_sched_entity(se) {
+		struct cfs_rq *qcfs_rq = cfs_rq_of(se);
+
+		if (!se->on_rq)
+			break;
+		dequeue_entity(qcfs_rq, se, 1);
+		/* Don't dequeue parent if it has other entities besides us */
+		if (qcfs_rq->load.weight)
+			break;
+	}
+
+	cfs_rq->throttled = 1;
+	cfs_rq->throttled_timestamp = rq->clock;
+}
+
+static void unthrottle_cfs_rq(struct cfs_rq *cfs_rq)
+{
+	struct rq *rq = rq_of(cfs_rq);
+	struct cfs_bandwidth *cfs_b = tg_cfs_bandwidth(cfs_rq->tg);
+	struct sched_entity *se = cfs_rq->tg->se[cpu_of(rq)];
+
+	cfs_rq->throttled = 0;
+	spin_lock(&cfs_b->lock);
+	cfs_b->throttled_time += rq->clock - cfs_rq->throttled_timestamp;
+	spin_unlock(&cfs_b->lock);
+
+	if (!cfs_rq->load.weight)
+		return;
+
+	for_each_sched_entity(se) {
+		if (se->on_rq)
+			break;
+		cfs_rq = cfs_rq_of(se);
+		enqueue_entity(cfs_rq, se, 1);
+		if (cfs_rq_throttled(cfs_rq))
+			break;
+	}
+
+	if (rq->cfs.nr_running)
+		resched_task(rq->curr);
+}
+
+/*
+ * Throttles @cfs_rq if it is out of runtime and its group has none left,
+ * when its entity stops running.
+ */
+static void check_cfs_rq_runtime(struct cfs_rq *cfs_rq)
+{
+	if (!cfs_rq->runtime_enabled || cfs_rq->runtime_remaining > 0)
+		return;
+	if (cfs_rq_throttled(cfs_rq))
+		return;
+
+	/* The period may have been refilled since we last asked */
+	assign_cfs_rq_runtime(cfs_rq);
+	if (cfs_rq->runtime_remaining <= 0)
+		throttle_cfs_rq(cfs_rq);
+}
+
+/* Is @se, or one of the entities above it, on a throttled cfs_rq? */
+static int throttled_hierarchy(struct sched_entity *se)
+{
+	for_each_sched_entity(se) {
+		if (cfs_rq_throttled(cfs_rq_of(se)))
+			return 1;
+	}
+	return 0;
+}
+
+/*
+ * Refills the bandwidth of a group for a new period and unthrottles the
+ * cfs_rqs it can give runtime to. Returns 1 when the timer can stop: the
+ * group asked for no runtime over the last period and nothing of it is
+ * throttled.
+ */
+static int do_sched_cfs_period_timer(struct cfs_bandwidth *cfs_b, int overrun)
+{
+	struct task_group *tg =
+		container_of(cfs_b, struct task_group, cfs_bandwidth);
+	int i, idle, was_throttled = 0, throttled = 0;
+
+	spin_lock(&cfs_b->lock);
+	if (cfs_b->quota == RUNTIME_INF) {
+		cfs_b->timer_active = 0;
+		spin_unlock(&cfs_b->lock);
+		return 1;
+	}
+	cfs_b->nr_periods += overrun;
+	cfs_b->runtime = cfs_b->quota;
+	idle = cfs_b->idle;
+	cfs_b->idle = 1;
+	spin_unlock(&cfs_b->lock);
+
+	for_each_online_cpu(i) {
+		struct cfs_rq *cfs_rq = tg->cfs_rq[i];
+		struct rq *rq = rq_of(cfs_rq);
+
+		spin_lock(&rq->lock);
+		if (cfs_rq_throttled(cfs_rq)) {
+			was_throttled = 1;
+			update_rq_clock(rq);
+			assign_cfs_rq_runtime(cfs_rq);
+			if (cfs_rq->runtime_remaining > 0)
+				unthrottle_cfs_rq(cfs_rq);
+			else
+				throttled = 1;
+		}
+		spin_unlock(&rq->lock);
+	}
+
+	spin_lock(&cfs_b->lock);
+	if (was_throttled)
+		cfs_b->nr_throttled++;
+	idle = idle && cfs_b->idle && !throttled;
+	if (idle)
+		cfs_b->timer_active = 0;
+	spin_unlock(&cfs_b->lock);
+
+	return idle;
+}
+
+#ifdef CONFIG_SMP
+/*
+ * Throttled tasks are not picked, so they could not be migrated off a
+ * CPU going down: give their cfs_rqs back runtime to run with.
+ */
+static void rq_offline_fair(struct rq *rq)
+{
+	struct cfs_rq *cfs_rq;
+
+	update_rq_clock(rq);
+	for_each_leaf_cfs_rq(rq, cfs_rq) {
+		if (!cfs_rq_throttled(cfs_rq))
+			continue;
+		cfs_rq->runtime_remaining = 1;
+		unthrottle_cfs_rq(cfs_rq);
+	}
+}
+#endif
+#else /* !CONFIG_CFS_BANDWIDTH */
+static inline void check_cfs_rq_runtime(struct cfs_rq *cfs_rq)
+{
+}
+
+static inline int throttled_hierarchy(struct sched_entity *se)
+{
+	return 0;
+}
+#endif /* CONFIG_CFS_BANDWIDTH */
+
 /*
  * Preempt the current task with a newly woken task if needed:
  */
@@ -828,6 +1088,8 @@ static void put_prev_entity(struct cfs_rq *cfs_rq, struct sched_entity *prev)
 	if (prev->on_rq)
 		update_curr(cfs_rq);
 
+	check_cfs_rq_runtime(cfs_rq);
+
 	check_spread(cfs_rq, prev);
 	if (prev->on_rq) {
 		update_stats_wait_start(cfs_rq, prev);
@@ -941,6 +1203,9 @@ static void enqueue_task_fair(struct rq *rq, struct task_struct *p, int wakeup)
 			break;
 		cfs_rq = cfs_rq_of(se);
 		enqueue_entity(cfs_rq, se, wakeup);
+		/* A throttled cfs_rq stays off its parent until unthrottled */
+		if (cfs_rq_throttled(cfs_rq))
+			break;
 		wakeup = 1;
 	}
 
@@ -961,7 +1226,7 @@ static void dequeue_task_fair(struct rq *rq, struct task_struct *p, int sleep)
 		cfs_rq = cfs_rq_of(se);
 		dequeue_entity(cfs_rq, se, sleep);
 		/* Don't dequeue parent if it has other entities besides us */
-		if (cfs_rq->load.weight)
+		if (cfs_rq->load.weight || cfs_rq_throttled(cfs_rq))
 			break;
 		sleep = 1;
 	}
@@ -1301,6 +1566,20 @@ static unsigned long wakeup_gran(struct sched_entity *se)
 	return gran;
 }
 
+/*
+ * Latency-nice moves an entity forward in the order of wakeup preemption
+ * by up to half of sysctl_sched_latency at -20, and back by as much at 19,
+ * without touching its vruntime and so its share of the CPU.
+ */
+static s64 latency_offset(struct sched_entity *se)
+{
+	if (!sched_feat(LATENCY_NICE))
+		return 0;
+
+	return div_s64((s64)sysctl_sched_latency * se->latency_nice,
+		       LATENCY_NICE_WIDTH);
+}
+
 /*
  * Should 'se' preempt 'curr'.
  *
@@ -1320,6 +1599,7 @@ wakeup_preempt_entity(struct sched_entity *curr, struct sched_entity *se)
 {
 	s64 gran, vdiff = curr->vruntime - se->vruntime;
 
+	vdiff += latency_offset(curr) - latency_offset(se);
 	if (vdiff <= 0)
 		return -1;
 
@@ -1369,6 +1649,10 @@ static void check_preempt_wakeup(struct rq *rq, struct task_struct *p, int sync)
 	if (unlikely(se == pse))
 		return;
 
+	/* A task of a throttled group can't run before the next period */
+	if (unlikely(throttled_hierarchy(pse)))
+		return;
+
 	/*
 	 * Only set the backward buddy when the current task is still on the
 	 * rq. This can happen when a wakeup gets interleaved with schedule on
@@ -1732,6 +2016,9 @@ static const struct sched_class fair_sched_class = {
 
 	.load_balance		= load_balance_fair,
 	.move_one_task		= move_one_task_fair,
+#ifdef CONFIG_CFS_BANDWIDTH
+	.rq_offline		= rq_offline_fair,
+#endif
 #endif
 
 	.set_curr_task          = set_curr_task_fair,
@@ -530,6 +530,7 @@ static void update_curr_rt(struct rq *rq)
 
 	curr->se.exec_start = rq->clock;
 	cpuacct_charge(curr, delta_exec);
+	cpufreq_charge(curr, delta_exec);
 
 	if (!rt_bandwidth_enabled())
 		return;
@@ -23,6 +23,7 @@
 #include <linux/rcupdate.h>
 #include <linux/smp.h>
 #include <linux/tick.h>
+#include <linux/timer_sample.h>
 
 #include <asm/irq.h>
 /*
@@ -272,6 +273,7 @@ void irq_enter(void)
 	if (idle_cpu(cpu) && !in_interrupt()) {
 		__irq_enter();
 		tick_check_idle(cpu);
+		timer_sample_idle_exit(cpu);
 	} else
 		__irq_enter();
 }
@@ -292,6 +294,8 @@ void irq_exit(void)
 	sub_preempt_count(IRQ_EXIT_OFFSET);
 	if (!in_interrupt() && local_softirq_pending())
 		invoke_softirq();
+	if (!in_interrupt())
+		timer_sample_irq_exit();
 
 #ifdef CONFIG_NO_HZ
 	/* Make sure that timer wheel updates are propagated */
@@ -1617,6 +1617,35 @@ SYSCALL_DEFINE1(umask, int, mask)
 	return mask;
 }
 
+/*
+ * Setting the slack of another thread takes the same permission as
+ * renicing it, see set_one_prio().
+ */
+static int prctl_set_timerslack_pid(unsigned long slack, pid_t pid)
+{
+	struct task_struct *p;
+	int error = 0;
+
+	read_lock(&tasklist_lock);
+	p = pid ? find_task_by_vpid(pid) : current;
+	if (!p) {
+		error = -ESRCH;
+		goto out;
+	}
+	if (p->uid != current->euid &&
+		p->euid != current->euid && !capable(CAP_SYS_NICE)) {
+		error = -EPERM;
+		goto out;
+	}
+	if (!slack)
+		p->timer_slack_ns = p->default_timer_slack_ns;
+	else
+		p->timer_slack_ns = slack;
+out:
+	read_unlock(&tasklist_lock);
+	return error;
+}
+
 SYSCALL_DEFINE5(prctl, int, option, unsigned long, arg2, unsigned long, arg3,
 		unsigned long, arg4, unsigned long, arg5)
 {
@@ -1722,6 +1751,9 @@ SYSCALL_DEFINE5(prctl, int, option, unsigned long, arg2, unsigned long, arg3,
 			else
 				current->timer_slack_ns = arg2;
 			break;
+		case PR_SET_TIMERSLACK_PID:
+			error = prctl_set_timerslack_pid(arg2, arg3);
+			break;
 		default:
 			error = -EINVAL;
 			break;
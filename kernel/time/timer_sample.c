@@ -0,0 +1,265 @@
+/*
+ * kernel/time/timer_sample.c
+ *
+ * Record timer expirations and the wakeups from idle they cause.
+ *
+ * Unlike timer_stats this is cheap enough to leave enabled: every CPU
+ * appends a fixed size record per expiring timer to its own ring with
+ * interrupts off and no lock, and a reader drains the rings. A record
+ * holds the callback, the task the timer wakes when it is a sleep or
+ * ITIMER_REAL, and whether it is the first timer run after the CPU left
+ * idle, that is the timer that woke it up. When the reader falls behind,
+ * the oldest records are overwritten and counted as lost.
+ *
+ * Drain the records, one line each:
+ * # cat /sys/kernel/debug/timer_sample/samples
+ *
+ * Per-CPU totals of records, wakeups from idle and lost records:
+ * # cat /sys/kernel/debug/timer_sample/stats
+ *
+ * Only record the timers that woke the CPU:
+ * # echo 1 >/sys/kernel/debug/timer_sample/idle_only
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/init.h>
+#include <linux/debugfs.h>
+#include <linux/fs.h>
+#include <linux/kallsyms.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/timer_sample.h>
+
+#include <asm/uaccess.h>
+
+/* Records per CPU, a power of 2 */
+#define TIMER_SAMPLES		512
+
+/* Longest line of the samples file */
+#define TIMER_SAMPLE_LINE	(64 + TASK_COMM_LEN + KSYM_SYMBOL_LEN)
+
+struct timer_sample_entry {
+	u64		time;		/* cpu_clock() ns */
+	void		*function;
+	pid_t		pid;		/* -1 when no task is woken */
+	u8		type;
+	u8		wakeup;
+	char		comm[TASK_COMM_LEN];
+};
+
+struct timer_sample_buffer {
+	unsigned long	head;		/* written by the CPU only */
+	unsigned long	tail;		/* under timer_sample_mutex */
+	unsigned long	wakeups;
+	unsigned long	lost;		/* under timer_sample_mutex */
+	struct timer_sample_entry samples[TIMER_SAMPLES];
+};
+
+DEFINE_PER_CPU(int, timer_sample_wakeup);
+
+static DEFINE_PER_CPU(struct timer_sample_buffer *, timer_sample_buffers);
+static DEFINE_MUTEX(timer_sample_mutex);
+static u32 timer_sample_idle_only;
+
+/**
+ * timer_sample - record the expiry of a timer on this CPU
+ * @function: the callback of the timer
+ * @task: the task the timer wakes, or NULL
+ * @type: TIMER_SAMPLE_WHEEL or TIMER_SAMPLE_HRTIMER
+ */
+void timer_sample(void *function, struct task_struct *task, int type)
+{
+	struct timer_sample_buffer *buf;
+	struct timer_sample_entry *s;
+	unsigned long flags;
+	int cpu, wakeup;
+
+	local_irq_save(flags);
+	cpu = smp_processor_id();
+	wakeup = per_cpu(timer_sample_wakeup, cpu);
+	per_cpu(timer_sample_wakeup, cpu) = 0;
+
+	buf = per_cpu(timer_sample_buffers, cpu);
+	if (!buf || (timer_sample_idle_only && !wakeup))
+		goto out;
+
+	s = &buf->samples[buf->head & (TIMER_SAMPLES - 1)];
+	s->time = cpu_clock(cpu);
+	s->function = function;
+	s->type = type;
+	s->wakeup = wakeup;
+	if (task) {
+		s->pid = task->pid;
+		memcpy(s->comm, task->comm, TASK_COMM_LEN);
+	} else {
+		s->pid = -1;
+		s->comm[0] = '\0';
+	}
+	/* pairs with the smp_rmb()s in timer_sample_peek() */
+	smp_wmb();
+	buf->head++;
+out:
+	local_irq_restore(flags);
+}
+
+/**
+ * timer_sample_idle_exit - an interrupt ends an idle period
+ * @cpu: the CPU, which is the current one
+ *
+ * The next timer sampled before the interrupt returns is credited with
+ * the wakeup.
+ */
+void timer_sample_idle_exit(int cpu)
+{
+	struct timer_sample_buffer *buf = per_cpu(timer_sample_buffers, cpu);
+
+	per_cpu(timer_sample_wakeup, cpu) = 1;
+	if (buf)
+		buf->wakeups++;
+}
+
+/*
+ * Copy the oldest record of @buf to @s without taking it off the ring.
+ * The CPU may overwrite the record while it is copied, in which case it
+ * is dropped and the next one tried.
+ */
+static int timer_sample_peek(struct timer_sample_buffer *buf,
+			     struct timer_sample_entry *s)
+{
+	unsigned long head;
+
+	for (;;) {
+		head = ACCESS_ONCE(buf->head);
+		smp_rmb();
+		if (head - buf->tail > TIMER_SAMPLES) {
+			buf->lost += head - buf->tail - TIMER_SAMPLES;
+			buf->tail = head - TIMER_SAMPLES;
+		}
+		if (buf->tail == head)
+			return 0;
+
+		*s = buf->samples[buf->tail & (TIMER_SAMPLES - 1)];
+		smp_rmb();
+		if (ACCESS_ONCE(buf->head) - buf->tail < TIMER_SAMPLES)
+			return 1;
+
+		buf->lost++;
+		buf->tail++;
+	}
+}
+
+static ssize_t samples_read(struct file *file, char __user *ubuf,
+			    size_t count, loff_t *ppos)
+{
+	struct timer_sample_entry s;
+	char line[TIMER_SAMPLE_LINE];
+	size_t done = 0;
+	int cpu, len, err = 0;
+
+	mutex_lock(&timer_sample_mutex);
+	for_each_possible_cpu(cpu) {
+		struct timer_sample_buffer *buf;
+
+		buf = per_cpu(timer_sample_buffers, cpu);
+		if (!buf)
+			continue;
+
+		while (timer_sample_peek(buf, &s)) {
+			len = snprintf(line, sizeof(line),
+				       "%d %llu %c %s %d %s %pF\n", cpu,
+				       (unsigned long long)s.time,
+				       s.wakeup ? 'W' : '-',
+				       s.type == TIMER_SAMPLE_HRTIMER ?
+						"hrtimer" : "timer",
+				       s.pid, s.comm[0] ? s.comm : "-",
+				       s.function);
+			if (done + len > count)
+				goto out;
+			if (copy_to_user(ubuf + done, line, len)) {
+				err = -EFAULT;
+				goto out;
+			}
+			done += len;
+			buf->tail++;
+		}
+	}
+out:
+	mutex_unlock(&timer_sample_mutex);
+	if (!done)
+		return err;
+	*ppos += done;
+	return done;
+}
+
+static const struct file_operations samples_fops = {
+	.read		= samples_read,
+};
+
+static int stats_show(struct seq_file *m, void *v)
+{
+	int cpu;
+
+	mutex_lock(&timer_sample_mutex);
+	seq_printf(m, "%-4s %12s %12s %12s\n", "cpu", "samples", "wakeups",
+		   "lost");
+	for_each_possible_cpu(cpu) {
+		struct timer_sample_buffer *buf;
+
+		buf = per_cpu(timer_sample_buffers, cpu);
+		if (!buf)
+			continue;
+		seq_printf(m, "%-4d %12lu %12lu %12lu\n", cpu, buf->head,
+			   buf->wakeups, buf->lost);
+	}
+	mutex_unlock(&timer_sample_mutex);
+	return 0;
+}
+
+static int stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, stats_show, NULL);
+}
+
+static const struct file_operations stats_fops = {
+	.open		= stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init init_timer_sample(void)
+{
+	struct dentry *dir;
+	int cpu;
+
+	dir = debugfs_create_dir("timer_sample", NULL);
+	if (!dir)
+		return -ENOMEM;
+	if (!debugfs_create_file("samples", 0400, dir, NULL, &samples_fops) ||
+	    !debugfs_create_file("stats", 0444, dir, NULL, &stats_fops) ||
+	    !debugfs_create_bool("idle_only", 0644, dir,
+				 &timer_sample_idle_only)) {
+		debugfs_remove_recursive(dir);
+		return -ENOMEM;
+	}
+
+	/* the CPUs start sampling as soon as they see their buffer */
+	for_each_possible_cpu(cpu) {
+		struct timer_sample_buffer *buf;
+
+		buf = kzalloc(sizeof(*buf), GFP_KERNEL);
+		if (!buf)
+			return -ENOMEM;
+		smp_wmb();
+		per_cpu(timer_sample_buffers, cpu) = buf;
+	}
+	return 0;
+}
+__initcall(init_timer_sample);
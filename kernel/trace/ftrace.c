@@ -1348,6 +1348,297 @@ device_initcall(ftrace_nodyn_init);
 # define ftrace_shutdown_sysctl()	do { } while (0)
 #endif /* CONFIG_DYNAMIC_FTRACE */
 
+#ifdef CONFIG_FUNCTION_GRAPH_TRACER
+
+static atomic_t ftrace_graph_active;
+
+int ftrace_graph_entry_stub(struct ftrace_graph_ent *trace)
+{
+	return 0;
+}
+
+/* The callbacks that hook into the function tracing for graph tracing */
+trace_func_graph_ret_t ftrace_graph_return =
+			(trace_func_graph_ret_t)ftrace_stub;
+trace_func_graph_ent_t ftrace_graph_entry = ftrace_graph_entry_stub;
+
+static void ftrace_graph_stop(void)
+{
+	ftrace_graph_return = (trace_func_graph_ret_t)ftrace_stub;
+	ftrace_graph_entry = ftrace_graph_entry_stub;
+}
+
+/* Try to assign a return stack array on FTRACE_RETSTACK_ALLOC_SIZE tasks. */
+static int alloc_retstack_tasklist(struct ftrace_ret_stack **ret_stack_list)
+{
+	int i;
+	int ret = 0;
+	unsigned long flags;
+	int start = 0, end = FTRACE_RETSTACK_ALLOC_SIZE;
+	struct task_struct *g, *t;
+
+	for (i = 0; i < FTRACE_RETSTACK_ALLOC_SIZE; i++) {
+		ret_stack_list[i] = kmalloc(FTRACE_RETFUNC_DEPTH
+					* sizeof(struct ftrace_ret_stack),
+					GFP_KERNEL);
+		if (!ret_stack_list[i]) {
+			start = 0;
+			end = i;
+			ret = -ENOMEM;
+			goto free;
+		}
+	}
+
+	read_lock_irqsave(&tasklist_lock, flags);
+	do_each_thread(g, t) {
+		if (start == end) {
+			ret = -EAGAIN;
+			goto unlock;
+		}
+
+		if (t->ret_stack == NULL) {
+			t->curr_ret_stack = -1;
+			atomic_set(&t->trace_overrun, 0);
+			atomic_set(&t->tracing_graph_pause, 0);
+			/* Make sure IRQs see the -1 first: */
+			barrier();
+			t->ret_stack = ret_stack_list[start++];
+		}
+	} while_each_thread(g, t);
+
+unlock:
+	read_unlock_irqrestore(&tasklist_lock, flags);
+free:
+	for (i = start; i < end; i++)
+		kfree(ret_stack_list[i]);
+	return ret;
+}
+
+/* The idle tasks are not on the task list */
+static int alloc_retstack_idle(void)
+{
+	struct ftrace_ret_stack *ret_stack;
+	struct task_struct *t;
+	int cpu;
+
+	for_each_online_cpu(cpu) {
+		t = idle_task(cpu);
+		if (t->ret_stack)
+			continue;
+
+		ret_stack = kmalloc(FTRACE_RETFUNC_DEPTH
+				* sizeof(struct ftrace_ret_stack),
+				GFP_KERNEL);
+		if (!ret_stack)
+			return -ENOMEM;
+
+		t->curr_ret_stack = -1;
+		atomic_set(&t->trace_overrun, 0);
+		atomic_set(&t->tracing_graph_pause, 0);
+		barrier();
+		t->ret_stack = ret_stack;
+	}
+	return 0;
+}
+
+/* Allocate a return stack for each task */
+static int start_graph_tracing(void)
+{
+	struct ftrace_ret_stack **ret_stack_list;
+	int ret;
+
+	ret = alloc_retstack_idle();
+	if (ret)
+		return ret;
+
+	ret_stack_list = kmalloc(FTRACE_RETSTACK_ALLOC_SIZE *
+				sizeof(struct ftrace_ret_stack *),
+				GFP_KERNEL);
+
+	if (!ret_stack_list)
+		return -ENOMEM;
+
+	do {
+		ret = alloc_retstack_tasklist(ret_stack_list);
+	} while (ret == -EAGAIN);
+
+	kfree(ret_stack_list);
+	return ret;
+}
+
+/**
+ * register_ftrace_graph - trace the entry and return of functions
+ * @retfunc: called when a function returns
+ * @entryfunc: called when a function is entered
+ *
+ * Only one graph tracer can be registered at a time, and it does not
+ * run at the same time as the functions registered with
+ * register_ftrace_function(). Like those, @retfunc and @entryfunc
+ * and all they call must be labeled "notrace", although a recursion
+ * is caught and not traced.
+ */
+int register_ftrace_graph(trace_func_graph_ret_t retfunc,
+			  trace_func_graph_ent_t entryfunc)
+{
+	int ret;
+
+	if (unlikely(ftrace_disabled))
+		return -ENODEV;
+
+	mutex_lock(&ftrace_sysctl_lock);
+
+	if (atomic_read(&ftrace_graph_active)) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	atomic_inc(&ftrace_graph_active);
+	ret = start_graph_tracing();
+	if (ret) {
+		atomic_dec(&ftrace_graph_active);
+		goto out;
+	}
+
+	ftrace_graph_return = retfunc;
+	ftrace_graph_entry = entryfunc;
+
+ out:
+	mutex_unlock(&ftrace_sysctl_lock);
+	return ret;
+}
+
+/**
+ * unregister_ftrace_graph - stop the graph tracer
+ *
+ * The return stacks of the tasks are kept, for the functions still
+ * to return through them, and freed with the tasks.
+ */
+void unregister_ftrace_graph(void)
+{
+	mutex_lock(&ftrace_sysctl_lock);
+
+	atomic_dec(&ftrace_graph_active);
+	ftrace_graph_stop();
+
+	mutex_unlock(&ftrace_sysctl_lock);
+}
+
+/* Allocate a return stack for newly created task */
+void ftrace_graph_init_task(struct task_struct *t)
+{
+	if (atomic_read(&ftrace_graph_active)) {
+		t->ret_stack = kmalloc(FTRACE_RETFUNC_DEPTH
+				* sizeof(struct ftrace_ret_stack),
+				GFP_KERNEL);
+		if (!t->ret_stack)
+			return;
+		t->curr_ret_stack = -1;
+		atomic_set(&t->trace_overrun, 0);
+		atomic_set(&t->tracing_graph_pause, 0);
+	} else
+		t->ret_stack = NULL;
+}
+
+void ftrace_graph_exit_task(struct task_struct *t)
+{
+	struct ftrace_ret_stack	*ret_stack = t->ret_stack;
+
+	t->ret_stack = NULL;
+	/* NULL must become visible to IRQs before we free it: */
+	barrier();
+
+	kfree(ret_stack);
+}
+
+/**
+ * ftrace_push_return_trace - a traced function was entered
+ * @ret: the address it returns to
+ * @func: the function
+ *
+ * Called by the arch code from mcount. Returns 0 when the return
+ * address was saved and is to be replaced by return_to_handler.
+ *
+ * The clock and the tracer's entry callback are called with the
+ * graph tracing of the task paused, so that the functions they call
+ * are not traced in turn.
+ */
+int ftrace_push_return_trace(unsigned long ret, unsigned long func)
+{
+	struct ftrace_graph_ent trace;
+	int index, err = -EBUSY;
+
+	if (!current->ret_stack)
+		return -EBUSY;
+
+	if (atomic_inc_return(&current->tracing_graph_pause) != 1)
+		goto out;
+
+	if (current->curr_ret_stack == FTRACE_RETFUNC_DEPTH - 1) {
+		atomic_inc(&current->trace_overrun);
+		goto out;
+	}
+
+	index = ++current->curr_ret_stack;
+	barrier();
+	current->ret_stack[index].ret = ret;
+	current->ret_stack[index].func = func;
+	current->ret_stack[index].calltime =
+		cpu_clock(raw_smp_processor_id());
+
+	trace.func = func;
+	trace.depth = index;
+
+	/* Only trace the return if the tracer wants to */
+	if (!ftrace_graph_entry(&trace)) {
+		current->curr_ret_stack--;
+		goto out;
+	}
+	err = 0;
+
+ out:
+	atomic_dec(&current->tracing_graph_pause);
+	return err;
+}
+
+/**
+ * ftrace_return_to_handler - a traced function returned
+ *
+ * Called by return_to_handler, returns the original return address.
+ */
+unsigned long ftrace_return_to_handler(void)
+{
+	struct ftrace_graph_ret trace;
+	unsigned long ret;
+	int index;
+
+	atomic_inc(&current->tracing_graph_pause);
+
+	index = current->curr_ret_stack;
+	if (unlikely(index < 0)) {
+		ftrace_graph_stop();
+		atomic_dec(&current->tracing_graph_pause);
+		WARN_ON(1);
+		/* Might as well panic, otherwise we have no where to go */
+		return (unsigned long)panic;
+	}
+
+	ret = current->ret_stack[index].ret;
+	trace.func = current->ret_stack[index].func;
+	trace.calltime = current->ret_stack[index].calltime;
+	trace.overrun = atomic_read(&current->trace_overrun);
+	trace.depth = index;
+	barrier();
+	current->curr_ret_stack--;
+
+	trace.rettime = cpu_clock(raw_smp_processor_id());
+	ftrace_graph_return(&trace);
+
+	atomic_dec(&current->tracing_graph_pause);
+
+	return ret;
+}
+#endif /* CONFIG_FUNCTION_GRAPH_TRACER */
+
 /**
  * ftrace_kill - kill ftrace
  *
@@ -1360,6 +1651,9 @@ void ftrace_kill(void)
 	ftrace_disabled = 1;
 	ftrace_enabled = 0;
 	clear_ftrace_function();
+#ifdef CONFIG_FUNCTION_GRAPH_TRACER
+	ftrace_graph_stop();
+#endif
 }
 
 /**
@@ -1448,4 +1742,3 @@ ftrace_enable_sysctl(struct ctl_table *table, int write,
 	mutex_unlock(&ftrace_sysctl_lock);
 	return ret;
 }
-
@@ -31,6 +31,7 @@
 #include <linux/fs.h>
 #include <linux/kprobes.h>
 #include <linux/writeback.h>
+#include <linux/splice.h>
 
 #include <linux/stacktrace.h>
 #include <linux/ring_buffer.h>
@@ -193,6 +194,78 @@ unsigned long nsecs_to_usecs(unsigned long nsecs)
 	return nsecs / 1000;
 }
 
+/**
+ * trace_hist_add - add a duration to a histogram
+ * @hist: the histogram
+ * @ns: the duration in ns
+ *
+ * Returns 1 if @ns is the longest duration of @hist so far.
+ */
+int trace_hist_add(struct trace_hist *hist, unsigned long long ns)
+{
+	unsigned long long us = ns;
+	int bucket;
+
+	do_div(us, 1000);
+	bucket = us ? fls64(us) : 0;
+	if (bucket >= TRACE_HIST_BUCKETS)
+		bucket = TRACE_HIST_BUCKETS - 1;
+
+	hist->count++;
+	hist->total += ns;
+	hist->bucket[bucket]++;
+	if (ns <= hist->max)
+		return 0;
+	hist->max = ns;
+	return 1;
+}
+
+/**
+ * trace_hist_sum - add a histogram to another one
+ * @sum: the histogram to add to
+ * @hist: the histogram to add
+ *
+ * Returns 1 if the longest duration of @sum is now that of @hist.
+ */
+int trace_hist_sum(struct trace_hist *sum, struct trace_hist *hist)
+{
+	int b;
+
+	sum->count += hist->count;
+	sum->total += hist->total;
+	for (b = 0; b < TRACE_HIST_BUCKETS; b++)
+		sum->bucket[b] += hist->bucket[b];
+	if (hist->max <= sum->max)
+		return 0;
+	sum->max = hist->max;
+	return 1;
+}
+
+static int trace_hist_open(struct inode *inode, struct file *file)
+{
+	struct trace_hist_file *hf = inode->i_private;
+
+	return single_open(file, hf->show, NULL);
+}
+
+/* Any write clears the histograms */
+static ssize_t trace_hist_write(struct file *file, const char __user *ubuf,
+				size_t cnt, loff_t *ppos)
+{
+	struct trace_hist_file *hf = file->f_path.dentry->d_inode->i_private;
+
+	hf->clear();
+	return cnt;
+}
+
+const struct file_operations trace_hist_fops = {
+	.open		= trace_hist_open,
+	.read		= seq_read,
+	.write		= trace_hist_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 /*
  * TRACE_ITER_SYM_MASK masks the options in trace_flags that
  * control the output of kernel symbols.
@@ -691,6 +764,56 @@ trace_function(struct trace_array *tr, struct trace_array_cpu *data,
 	ring_buffer_unlock_commit(tr->buffer, event, irq_flags);
 }
 
+#ifdef CONFIG_FUNCTION_GRAPH_TRACER
+static void __trace_graph_entry(struct trace_array *tr,
+				struct trace_array_cpu *data,
+				struct ftrace_graph_ent *trace,
+				unsigned long flags,
+				int pc)
+{
+	struct ring_buffer_event *event;
+	struct ftrace_graph_ent_entry *entry;
+	unsigned long irq_flags;
+
+	if (unlikely(local_read(&__get_cpu_var(ftrace_cpu_disabled))))
+		return;
+
+	event = ring_buffer_lock_reserve(global_trace.buffer, sizeof(*entry),
+					 &irq_flags);
+	if (!event)
+		return;
+	entry	= ring_buffer_event_data(event);
+	tracing_generic_entry_update(&entry->ent, flags, pc);
+	entry->ent.type			= TRACE_GRAPH_ENT;
+	entry->graph_ent			= *trace;
+	ring_buffer_unlock_commit(global_trace.buffer, event, irq_flags);
+}
+
+static void __trace_graph_return(struct trace_array *tr,
+				struct trace_array_cpu *data,
+				struct ftrace_graph_ret *trace,
+				unsigned long flags,
+				int pc)
+{
+	struct ring_buffer_event *event;
+	struct ftrace_graph_ret_entry *entry;
+	unsigned long irq_flags;
+
+	if (unlikely(local_read(&__get_cpu_var(ftrace_cpu_disabled))))
+		return;
+
+	event = ring_buffer_lock_reserve(global_trace.buffer, sizeof(*entry),
+					 &irq_flags);
+	if (!event)
+		return;
+	entry	= ring_buffer_event_data(event);
+	tracing_generic_entry_update(&entry->ent, flags, pc);
+	entry->ent.type			= TRACE_GRAPH_RET;
+	entry->ret				= *trace;
+	ring_buffer_unlock_commit(global_trace.buffer, event, irq_flags);
+}
+#endif
+
 void
 ftrace(struct trace_array *tr, struct trace_array_cpu *data,
        unsigned long ip, unsigned long parent_ip, unsigned long flags,
@@ -895,6 +1018,56 @@ static struct ftrace_ops trace_ops __read_mostly =
 	.func = function_trace_call,
 };
 
+#ifdef CONFIG_FUNCTION_GRAPH_TRACER
+int trace_graph_entry(struct ftrace_graph_ent *trace)
+{
+	struct trace_array *tr = &global_trace;
+	struct trace_array_cpu *data;
+	unsigned long flags;
+	long disabled;
+	int cpu;
+	int pc;
+
+	if (!tracer_enabled)
+		return 0;
+
+	local_irq_save(flags);
+	cpu = raw_smp_processor_id();
+	data = tr->data[cpu];
+	disabled = atomic_inc_return(&data->disabled);
+	if (likely(disabled == 1)) {
+		pc = preempt_count();
+		__trace_graph_entry(tr, data, trace, flags, pc);
+	}
+	atomic_dec(&data->disabled);
+	local_irq_restore(flags);
+
+	/* only trace the return of the functions whose entry was logged */
+	return disabled == 1;
+}
+
+void trace_graph_return(struct ftrace_graph_ret *trace)
+{
+	struct trace_array *tr = &global_trace;
+	struct trace_array_cpu *data;
+	unsigned long flags;
+	long disabled;
+	int cpu;
+	int pc;
+
+	local_irq_save(flags);
+	cpu = raw_smp_processor_id();
+	data = tr->data[cpu];
+	disabled = atomic_inc_return(&data->disabled);
+	if (likely(disabled == 1)) {
+		pc = preempt_count();
+		__trace_graph_return(tr, data, trace, flags, pc);
+	}
+	atomic_dec(&data->disabled);
+	local_irq_restore(flags);
+}
+#endif /* CONFIG_FUNCTION_GRAPH_TRACER */
+
 void tracing_start_function_trace(void)
 {
 	ftrace_function_enabled = 0;
@@ -1143,7 +1316,7 @@ seq_print_sym_offset(struct trace_seq *s, const char *fmt,
 # define IP_FMT "%016lx"
 #endif
 
-static int
+int
 seq_print_ip_sym(struct trace_seq *s, unsigned long ip, unsigned long sym_flags)
 {
 	int ret;
@@ -2839,6 +3012,224 @@ static struct file_operations tracing_mark_fops = {
 	.write		= tracing_mark_write,
 };
 
+struct ftrace_buffer_info {
+	int		cpu;
+	void		*spare;		/* page being read */
+	unsigned int	read;		/* offset into spare */
+	unsigned int	size;		/* bytes in spare */
+};
+
+static int tracing_buffers_open(struct inode *inode, struct file *filp)
+{
+	struct ftrace_buffer_info *info;
+
+	if (tracing_disabled)
+		return -ENODEV;
+
+	info = kzalloc(sizeof(*info), GFP_KERNEL);
+	if (!info)
+		return -ENOMEM;
+
+	info->cpu = (long)inode->i_private;
+
+	filp->private_data = info;
+
+	return nonseekable_open(inode, filp);
+}
+
+static int tracing_buffers_release(struct inode *inode, struct file *filp)
+{
+	struct ftrace_buffer_info *info = filp->private_data;
+
+	if (info->spare)
+		ring_buffer_free_read_page(global_trace.buffer, info->spare);
+	kfree(info);
+
+	return 0;
+}
+
+/*
+ * Take the next page of the CPU buffer into *page. While tracing is
+ * enabled only pages the writer is done with are taken, waiting for
+ * one unless @nonblock is set; once it is disabled, what is left.
+ */
+static int tracing_buffers_get_page(struct ftrace_buffer_info *info,
+				    void **page, int nonblock)
+{
+	int size;
+
+	for (;;) {
+		size = ring_buffer_read_page(global_trace.buffer, page,
+					     info->cpu, tracer_enabled);
+		if (size || !tracer_enabled)
+			return size;
+
+		if (nonblock)
+			return -EAGAIN;
+
+		/* same make-shift wait as trace_pipe */
+		schedule_timeout_interruptible(HZ / 10);
+
+		if (signal_pending(current))
+			return -EINTR;
+	}
+}
+
+static ssize_t
+tracing_buffers_read(struct file *filp, char __user *ubuf,
+		     size_t count, loff_t *ppos)
+{
+	struct ftrace_buffer_info *info = filp->private_data;
+	unsigned int size;
+	int ret;
+
+	if (!count)
+		return 0;
+
+	if (!info->spare) {
+		info->spare = ring_buffer_alloc_read_page(global_trace.buffer);
+		if (!info->spare)
+			return -ENOMEM;
+	}
+
+	/* the page is returned whole, header and all */
+	if (info->read >= info->size) {
+		ret = tracing_buffers_get_page(info, &info->spare,
+					       filp->f_flags & O_NONBLOCK);
+		if (ret <= 0)
+			return ret;
+		info->read = 0;
+		info->size = PAGE_SIZE;
+	}
+
+	size = min_t(unsigned int, info->size - info->read, count);
+	if (copy_to_user(ubuf, info->spare + info->read, size))
+		return -EFAULT;
+
+	info->read += size;
+	*ppos += size;
+
+	return size;
+}
+
+static void buffer_pipe_buf_release(struct pipe_inode_info *pipe,
+				    struct pipe_buffer *buf)
+{
+	page_cache_release(buf->page);
+	buf->private = 0;
+}
+
+static int buffer_pipe_buf_steal(struct pipe_inode_info *pipe,
+				 struct pipe_buffer *buf)
+{
+	return 1;
+}
+
+/* the pages came from the page allocator, the last reference frees them */
+static struct pipe_buf_operations buffer_pipe_buf_ops = {
+	.can_merge		= 0,
+	.map			= generic_pipe_buf_map,
+	.unmap			= generic_pipe_buf_unmap,
+	.confirm		= generic_pipe_buf_confirm,
+	.release		= buffer_pipe_buf_release,
+	.steal			= buffer_pipe_buf_steal,
+	.get			= generic_pipe_buf_get,
+};
+
+static void buffer_spd_release(struct splice_pipe_desc *spd, unsigned int i)
+{
+	page_cache_release(spd->pages[i]);
+}
+
+static ssize_t
+tracing_buffers_splice_read(struct file *file, loff_t *ppos,
+			    struct pipe_inode_info *pipe, size_t len,
+			    unsigned int flags)
+{
+	struct ftrace_buffer_info *info = file->private_data;
+	struct partial_page partial[PIPE_BUFFERS];
+	struct page *pages[PIPE_BUFFERS];
+	struct splice_pipe_desc spd = {
+		.pages		= pages,
+		.partial	= partial,
+		.flags		= flags,
+		.ops		= &buffer_pipe_buf_ops,
+		.spd_release	= buffer_spd_release,
+	};
+	int nonblock = (flags & SPLICE_F_NONBLOCK) ||
+		       (file->f_flags & O_NONBLOCK);
+	void *page;
+	int i, ret = 0;
+
+	/* whole pages only, a page is never split over two reads */
+	if (len < PAGE_SIZE)
+		return -EINVAL;
+
+	for (i = 0; i < PIPE_BUFFERS && len >= PAGE_SIZE;
+	     i++, len -= PAGE_SIZE) {
+		page = ring_buffer_alloc_read_page(global_trace.buffer);
+		if (!page) {
+			ret = -ENOMEM;
+			break;
+		}
+
+		/* only wait for the first page */
+		ret = tracing_buffers_get_page(info, &page, nonblock || i);
+		if (ret <= 0) {
+			ring_buffer_free_read_page(global_trace.buffer, page);
+			break;
+		}
+
+		pages[i] = virt_to_page(page);
+		partial[i].offset = 0;
+		partial[i].len = PAGE_SIZE;
+		partial[i].private = 0;
+	}
+
+	spd.nr_pages = i;
+	if (!i)
+		return ret;
+
+	return splice_to_pipe(pipe, &spd);
+}
+
+static struct file_operations tracing_buffers_fops = {
+	.open		= tracing_buffers_open,
+	.read		= tracing_buffers_read,
+	.release	= tracing_buffers_release,
+	.splice_read	= tracing_buffers_splice_read,
+	.llseek		= no_llseek,
+};
+
+static __init void tracing_init_per_cpu(struct dentry *d_tracer)
+{
+	struct dentry *d_percpu, *d_cpu, *entry;
+	char cpu_dir[16];
+	long cpu;
+
+	d_percpu = debugfs_create_dir("per_cpu", d_tracer);
+	if (!d_percpu) {
+		pr_warning("Could not create debugfs 'per_cpu' directory\n");
+		return;
+	}
+
+	for_each_tracing_cpu(cpu) {
+		sprintf(cpu_dir, "cpu%ld", cpu);
+		d_cpu = debugfs_create_dir(cpu_dir, d_percpu);
+		if (!d_cpu) {
+			pr_warning("Could not create debugfs '%s' entry\n",
+				   cpu_dir);
+			continue;
+		}
+
+		entry = debugfs_create_file("trace_pipe_raw", 0444, d_cpu,
+					    (void *)cpu, &tracing_buffers_fops);
+		if (!entry)
+			pr_warning("Could not create debugfs "
+				   "'trace_pipe_raw' entry\n");
+	}
+}
+
 #ifdef CONFIG_DYNAMIC_FTRACE
 
 static ssize_t
@@ -2962,6 +3353,8 @@ static __init int tracer_init_debugfs(void)
 		pr_warning("Could not create debugfs "
 			   "'trace_marker' entry\n");
 
+	tracing_init_per_cpu(d_tracer);
+
 #ifdef CONFIG_DYNAMIC_FTRACE
 	entry = debugfs_create_file("dyn_ftrace_total_info", 0444, d_tracer,
 				    &ftrace_update_tot_cnt,
@@ -22,6 +22,8 @@ enum trace_type {
 	TRACE_MMIO_RW,
 	TRACE_MMIO_MAP,
 	TRACE_BOOT,
+	TRACE_GRAPH_RET,
+	TRACE_GRAPH_ENT,
 
 	__TRACE_LAST_TYPE
 };
@@ -50,6 +52,18 @@ struct ftrace_entry {
 };
 extern struct tracer boot_tracer;
 
+/* Function call entry */
+struct ftrace_graph_ent_entry {
+	struct trace_entry		ent;
+	struct ftrace_graph_ent		graph_ent;
+};
+
+/* Function return entry */
+struct ftrace_graph_ret_entry {
+	struct trace_entry		ent;
+	struct ftrace_graph_ret		ret;
+};
+
 /*
  * Context switch trace entry - which task (and prio) we switched from/to:
  */
@@ -219,6 +233,10 @@ extern void __ftrace_bad_type(void);
 		IF_ASSIGN(var, ent, struct trace_mmiotrace_map,		\
 			  TRACE_MMIO_MAP);				\
 		IF_ASSIGN(var, ent, struct trace_boot, TRACE_BOOT);	\
+		IF_ASSIGN(var, ent, struct ftrace_graph_ent_entry,	\
+			  TRACE_GRAPH_ENT);				\
+		IF_ASSIGN(var, ent, struct ftrace_graph_ret_entry,	\
+			  TRACE_GRAPH_RET);				\
 		__ftrace_bad_type();					\
 	} while (0)
 
@@ -321,6 +339,11 @@ void trace_function(struct trace_array *tr,
 		    unsigned long parent_ip,
 		    unsigned long flags, int pc);
 
+#ifdef CONFIG_FUNCTION_GRAPH_TRACER
+int trace_graph_entry(struct ftrace_graph_ent *trace);
+void trace_graph_return(struct ftrace_graph_ret *trace);
+#endif
+
 void tracing_start_cmdline_record(void);
 void tracing_stop_cmdline_record(void);
 int register_tracer(struct tracer *type);
@@ -328,6 +351,32 @@ void unregister_tracer(struct tracer *type);
 
 extern unsigned long nsecs_to_usecs(unsigned long nsecs);
 
+/*
+ * Duration histograms of the *_hist tracers: bucket 0 counts the
+ * durations under 1 us, bucket n those under 2^n us, and the last
+ * bucket all longer ones.
+ */
+#define TRACE_HIST_BUCKETS	24
+
+struct trace_hist {
+	unsigned long		count;
+	unsigned long long	total;		/* ns */
+	unsigned long long	max;		/* ns */
+	unsigned long		bucket[TRACE_HIST_BUCKETS];
+};
+
+struct seq_file;
+
+/* The i_private of a debugfs file with trace_hist_fops */
+struct trace_hist_file {
+	int			(*show)(struct seq_file *m, void *v);
+	void			(*clear)(void);
+};
+
+int trace_hist_add(struct trace_hist *hist, unsigned long long ns);
+int trace_hist_sum(struct trace_hist *sum, struct trace_hist *hist);
+extern const struct file_operations trace_hist_fops;
+
 extern unsigned long tracing_max_latency;
 extern unsigned long tracing_thresh;
 
@@ -387,6 +436,9 @@ extern int trace_selftest_startup_sysprof(struct tracer *trace,
 
 extern void *head_page(struct trace_array_cpu *data);
 extern int trace_seq_printf(struct trace_seq *s, const char *fmt, ...);
+extern int
+seq_print_ip_sym(struct trace_seq *s, unsigned long ip,
+		 unsigned long sym_flags);
 extern void trace_seq_print_cont(struct trace_seq *s,
 				 struct trace_iterator *iter);
 extern ssize_t trace_seq_to_user(struct trace_seq *s, char __user *ubuf,
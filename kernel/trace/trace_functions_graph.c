@@ -0,0 +1,455 @@
+/*
+ * Function graph tracer and function duration histograms.
+ *
+ * "function_graph" logs the entry and the return of each function, with
+ * the time spent in it. "function_hist" logs nothing: it keeps, for the
+ * functions written to tracing/function_hist_functions, a histogram of
+ * their durations, read from tracing/function_hist.
+ *
+ * The durations are wall time from entry to return, so they include the
+ * time spent in interrupts and, for functions that sleep, asleep.
+ */
+#include <linux/debugfs.h>
+#include <linux/uaccess.h>
+#include <linux/ftrace.h>
+#include <linux/kallsyms.h>
+#include <linux/seq_file.h>
+#include <linux/math64.h>
+#include <linux/ctype.h>
+#include <linux/fs.h>
+
+#include "trace.h"
+
+static void graph_trace_reset_buffers(struct trace_array *tr)
+{
+	int cpu;
+
+	tr->time_start = ftrace_now(tr->cpu);
+
+	for_each_online_cpu(cpu)
+		tracing_reset(tr, cpu);
+}
+
+static int graph_trace_active;
+
+static void start_graph_trace(struct trace_array *tr)
+{
+	int ret;
+
+	tr->cpu = get_cpu();
+	graph_trace_reset_buffers(tr);
+	put_cpu();
+
+	ret = register_ftrace_graph(&trace_graph_return, &trace_graph_entry);
+	if (ret)
+		printk(KERN_WARNING "function_graph: can't start tracing (%d)\n",
+		       ret);
+	else
+		graph_trace_active = 1;
+}
+
+static void stop_graph_trace(struct trace_array *tr)
+{
+	if (graph_trace_active) {
+		unregister_ftrace_graph();
+		graph_trace_active = 0;
+	}
+}
+
+static void graph_trace_init(struct trace_array *tr)
+{
+	if (tr->ctrl)
+		start_graph_trace(tr);
+}
+
+static void graph_trace_reset(struct trace_array *tr)
+{
+	if (tr->ctrl)
+		stop_graph_trace(tr);
+}
+
+static void graph_trace_ctrl_update(struct trace_array *tr)
+{
+	if (tr->ctrl)
+		start_graph_trace(tr);
+	else
+		stop_graph_trace(tr);
+}
+
+/*
+ *  CPU)   PID  |   DURATION    |  FUNCTION CALLS
+ *   0)    742  |               |  binder_transaction() {
+ *   0)    742  |               |    binder_alloc_buf() {
+ *   0)    742  |     3.051 us  |    }
+ *   0)    742  |   104.003 us  |  }
+ */
+static enum print_line_t
+print_graph_entry(struct ftrace_graph_ent *call, struct trace_seq *s,
+		  struct trace_entry *ent, int cpu)
+{
+	int ret;
+
+	ret = trace_seq_printf(s, "%3d) %6d  |               |  %*s",
+			       cpu, ent->pid, call->depth * 2, "");
+	if (!ret)
+		return TRACE_TYPE_PARTIAL_LINE;
+
+	ret = seq_print_ip_sym(s, call->func, 0);
+	if (!ret)
+		return TRACE_TYPE_PARTIAL_LINE;
+
+	ret = trace_seq_printf(s, "() {\n");
+	if (!ret)
+		return TRACE_TYPE_PARTIAL_LINE;
+
+	return TRACE_TYPE_HANDLED;
+}
+
+static enum print_line_t
+print_graph_return(struct ftrace_graph_ret *trace, struct trace_seq *s,
+		   struct trace_entry *ent, int cpu)
+{
+	unsigned long long duration = trace->rettime - trace->calltime;
+	unsigned long nsecs_rem = do_div(duration, 1000);
+	int ret;
+
+	ret = trace_seq_printf(s, "%3d) %6d  | %7llu.%03lu us  |  %*s}",
+			       cpu, ent->pid, duration, nsecs_rem,
+			       trace->depth * 2, "");
+	if (!ret)
+		return TRACE_TYPE_PARTIAL_LINE;
+
+	if (trace->overrun) {
+		ret = trace_seq_printf(s, " (Overruns: %lu)", trace->overrun);
+		if (!ret)
+			return TRACE_TYPE_PARTIAL_LINE;
+	}
+
+	ret = trace_seq_printf(s, "\n");
+	if (!ret)
+		return TRACE_TYPE_PARTIAL_LINE;
+
+	return TRACE_TYPE_HANDLED;
+}
+
+static enum print_line_t print_graph_function(struct trace_iterator *iter)
+{
+	struct trace_seq *s = &iter->seq;
+	struct trace_entry *entry = iter->ent;
+
+	switch (entry->type) {
+	case TRACE_GRAPH_ENT: {
+		struct ftrace_graph_ent_entry *field;
+
+		trace_assign_type(field, entry);
+		return print_graph_entry(&field->graph_ent, s, entry,
+					 iter->cpu);
+	}
+	case TRACE_GRAPH_RET: {
+		struct ftrace_graph_ret_entry *field;
+
+		trace_assign_type(field, entry);
+		return print_graph_return(&field->ret, s, entry, iter->cpu);
+	}
+	default:
+		return TRACE_TYPE_UNHANDLED;
+	}
+}
+
+static struct tracer graph_trace __read_mostly = {
+	.name		= "function_graph",
+	.init		= graph_trace_init,
+	.reset		= graph_trace_reset,
+	.ctrl_update	= graph_trace_ctrl_update,
+	.print_line	= print_graph_function,
+};
+
+/* Functions with a histogram */
+#define FUNCTION_HIST_MAX	16
+
+struct function_hist {
+	unsigned long		start;
+	unsigned long		size;
+	char			name[KSYM_NAME_LEN];
+};
+
+struct function_hist_cpu {
+	struct trace_hist	stat[FUNCTION_HIST_MAX];
+};
+
+static struct function_hist function_hist[FUNCTION_HIST_MAX];
+static int function_hist_nr;
+static int function_hist_active;
+static DEFINE_PER_CPU(struct function_hist_cpu, function_hist_cpu);
+static DEFINE_MUTEX(function_hist_lock);
+
+static int function_hist_find(unsigned long func)
+{
+	int i;
+
+	for (i = 0; i < function_hist_nr; i++)
+		if (func - function_hist[i].start < function_hist[i].size)
+			return i;
+	return -1;
+}
+
+/* Hook the return of the functions with a histogram only */
+static int function_hist_entry(struct ftrace_graph_ent *trace)
+{
+	return function_hist_find(trace->func) >= 0;
+}
+
+static void function_hist_return(struct ftrace_graph_ret *trace)
+{
+	unsigned long long duration;
+	unsigned long flags;
+	int i;
+
+	/* cpu_clock() of another CPU if the task migrated */
+	if (trace->rettime < trace->calltime)
+		return;
+	duration = trace->rettime - trace->calltime;
+
+	local_irq_save(flags);
+	i = function_hist_find(trace->func);
+	if (i < 0)
+		goto out;
+
+	trace_hist_add(&__get_cpu_var(function_hist_cpu).stat[i], duration);
+ out:
+	local_irq_restore(flags);
+}
+
+static void function_hist_reset(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(&per_cpu(function_hist_cpu, cpu), 0,
+		       sizeof(struct function_hist_cpu));
+}
+
+static void start_function_hist(struct trace_array *tr)
+{
+	int ret;
+
+	mutex_lock(&function_hist_lock);
+	function_hist_reset();
+	ret = register_ftrace_graph(&function_hist_return,
+				    &function_hist_entry);
+	if (ret)
+		printk(KERN_WARNING "function_hist: can't start tracing (%d)\n",
+		       ret);
+	else
+		function_hist_active = 1;
+	mutex_unlock(&function_hist_lock);
+}
+
+static void stop_function_hist(struct trace_array *tr)
+{
+	mutex_lock(&function_hist_lock);
+	if (function_hist_active) {
+		unregister_ftrace_graph();
+		/* the return hooks run with interrupts off */
+		synchronize_sched();
+		function_hist_active = 0;
+	}
+	mutex_unlock(&function_hist_lock);
+}
+
+static void function_hist_init(struct trace_array *tr)
+{
+	if (tr->ctrl)
+		start_function_hist(tr);
+}
+
+static void function_hist_trace_reset(struct trace_array *tr)
+{
+	if (tr->ctrl)
+		stop_function_hist(tr);
+}
+
+static void function_hist_ctrl_update(struct trace_array *tr)
+{
+	if (tr->ctrl)
+		start_function_hist(tr);
+	else
+		stop_function_hist(tr);
+}
+
+static struct tracer function_hist_trace __read_mostly = {
+	.name		= "function_hist",
+	.init		= function_hist_init,
+	.reset		= function_hist_trace_reset,
+	.ctrl_update	= function_hist_ctrl_update,
+};
+
+static int function_hist_show(struct seq_file *m, void *v)
+{
+	struct trace_hist sum;
+	unsigned long long avg;
+	int i, b, cpu;
+
+	mutex_lock(&function_hist_lock);
+	for (i = 0; i < function_hist_nr; i++) {
+		memset(&sum, 0, sizeof(sum));
+		for_each_possible_cpu(cpu)
+			trace_hist_sum(&sum,
+				       &per_cpu(function_hist_cpu, cpu).stat[i]);
+
+		avg = sum.count ? div_u64(sum.total, sum.count) : 0;
+		seq_printf(m, "%s: %lu calls, avg %llu us, max %llu us\n",
+			   function_hist[i].name, sum.count,
+			   div_u64(avg, 1000), div_u64(sum.max, 1000));
+		seq_printf(m, "%10s %10s : %s\n", ">= us", "< us", "count");
+		for (b = 0; b < TRACE_HIST_BUCKETS; b++) {
+			if (!sum.bucket[b])
+				continue;
+			seq_printf(m, "%10lu ", b ? 1UL << (b - 1) : 0);
+			if (b < TRACE_HIST_BUCKETS - 1)
+				seq_printf(m, "%10lu", 1UL << b);
+			else
+				seq_printf(m, "%10s", "");
+			seq_printf(m, " : %lu\n", sum.bucket[b]);
+		}
+		seq_putc(m, '\n');
+	}
+	mutex_unlock(&function_hist_lock);
+
+	return 0;
+}
+
+static void function_hist_clear(void)
+{
+	mutex_lock(&function_hist_lock);
+	function_hist_reset();
+	mutex_unlock(&function_hist_lock);
+}
+
+static struct trace_hist_file function_hist_file = {
+	.show		= function_hist_show,
+	.clear		= function_hist_clear,
+};
+
+static int function_hist_functions_show(struct seq_file *m, void *v)
+{
+	int i;
+
+	mutex_lock(&function_hist_lock);
+	for (i = 0; i < function_hist_nr; i++)
+		seq_printf(m, "%s\n", function_hist[i].name);
+	mutex_unlock(&function_hist_lock);
+
+	return 0;
+}
+
+static int function_hist_functions_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, function_hist_functions_show, NULL);
+}
+
+/*
+ * Replace the functions with a histogram by the names written,
+ * separated by white space. The histograms are cleared.
+ */
+static ssize_t
+function_hist_functions_write(struct file *file, const char __user *ubuf,
+			      size_t cnt, loff_t *ppos)
+{
+	struct function_hist *hist;
+	unsigned long size, offset;
+	char *buf, *p, *name;
+	int nr = 0, ret;
+
+	if (cnt >= PAGE_SIZE)
+		return -EINVAL;
+
+	buf = kmalloc(cnt + 1, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+	if (copy_from_user(buf, ubuf, cnt)) {
+		kfree(buf);
+		return -EFAULT;
+	}
+	buf[cnt] = '\0';
+
+	hist = kcalloc(FUNCTION_HIST_MAX, sizeof(*hist), GFP_KERNEL);
+	if (!hist) {
+		kfree(buf);
+		return -ENOMEM;
+	}
+
+	p = buf;
+	while ((name = strsep(&p, " \t\n")) != NULL) {
+		if (!*name)
+			continue;
+		if (nr == FUNCTION_HIST_MAX) {
+			ret = -ENOSPC;
+			goto out;
+		}
+
+		hist[nr].start = kallsyms_lookup_name(name);
+		if (!hist[nr].start ||
+		    !kallsyms_lookup_size_offset(hist[nr].start, &size,
+						 &offset)) {
+			ret = -EINVAL;
+			goto out;
+		}
+		hist[nr].size = size;
+		strlcpy(hist[nr].name, name, KSYM_NAME_LEN);
+		nr++;
+	}
+
+	mutex_lock(&function_hist_lock);
+	if (function_hist_active) {
+		ret = -EBUSY;
+	} else {
+		memcpy(function_hist, hist, sizeof(function_hist));
+		function_hist_nr = nr;
+		function_hist_reset();
+		ret = cnt;
+	}
+	mutex_unlock(&function_hist_lock);
+
+ out:
+	kfree(hist);
+	kfree(buf);
+	return ret;
+}
+
+static const struct file_operations function_hist_functions_fops = {
+	.open		= function_hist_functions_open,
+	.read		= seq_read,
+	.write		= function_hist_functions_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static __init int init_graph_trace(void)
+{
+	struct dentry *d_tracer;
+	struct dentry *entry;
+	int ret;
+
+	d_tracer = tracing_init_dentry();
+
+	entry = debugfs_create_file("function_hist", 0644, d_tracer,
+				    &function_hist_file, &trace_hist_fops);
+	if (!entry)
+		pr_warning("Could not create debugfs "
+			   "'function_hist' entry\n");
+
+	entry = debugfs_create_file("function_hist_functions", 0644, d_tracer,
+				    NULL, &function_hist_functions_fops);
+	if (!entry)
+		pr_warning("Could not create debugfs "
+			   "'function_hist_functions' entry\n");
+
+	ret = register_tracer(&graph_trace);
+	if (ret)
+		return ret;
+
+	return register_tracer(&function_hist_trace);
+}
+
+device_initcall(init_graph_trace);
@@ -12,8 +12,12 @@
 #include <linux/kallsyms.h>
 #include <linux/debugfs.h>
 #include <linux/uaccess.h>
+#include <linux/seq_file.h>
+#include <linux/vmalloc.h>
 #include <linux/module.h>
 #include <linux/ftrace.h>
+#include <linux/hash.h>
+#include <linux/sort.h>
 #include <linux/fs.h>
 
 #include "trace.h"
@@ -250,11 +254,174 @@ stop_critical_timing(unsigned long ip, unsigned long parent_ip)
 	atomic_dec(&data->disabled);
 }
 
+/*
+ * Histogram mode: instead of keeping the trace of the longest section,
+ * the *_hist tracers time every irqs-off and preempt-off section and add
+ * it to the histogram of the site that started it. The two kinds of
+ * sections are timed separately, also by preemptirqsoff_hist. Every CPU
+ * updates its own tables, with interrupts or preemption off as the
+ * section being closed left them, so nothing is locked and the tables
+ * can be read while the sections are being recorded.
+ */
+enum {
+	LATENCY_HIST_IRQSOFF,
+	LATENCY_HIST_PREEMPTOFF,
+	LATENCY_HIST_TYPES,
+};
+
+/* Sites with a histogram per CPU and type */
+#define LATENCY_HIST_SITES_BITS	7
+#define LATENCY_HIST_SITES	(1 << LATENCY_HIST_SITES_BITS)
+
+struct latency_hist_site {
+	unsigned long		site;		/* 0 while the slot is free */
+	unsigned long		max_end;	/* where the longest one ended */
+	struct trace_hist	hist;
+};
+
+struct latency_hist_cpu {
+	unsigned long long	start;		/* of the open section, ns */
+	unsigned long		start_site;	/* 0 if no section is open */
+	unsigned long		seq;		/* latency_hist_seq of sites[] */
+	unsigned long		dropped;	/* sections of no free site */
+	int			idle;		/* next section is idle's */
+	struct latency_hist_site sites[LATENCY_HIST_SITES];
+};
+
+static const char *latency_hist_names[LATENCY_HIST_TYPES] = {
+	[LATENCY_HIST_IRQSOFF]		= "irqsoff",
+	[LATENCY_HIST_PREEMPTOFF]	= "preemptoff",
+};
+
+static int hist_type;
+static int latency_hist_type __read_mostly;
+static unsigned long latency_hist_seq;
+static DEFINE_PER_CPU(struct latency_hist_cpu *,
+		      latency_hist[LATENCY_HIST_TYPES]);
+static DEFINE_MUTEX(latency_hist_lock);
+
+static inline int latency_hist_enabled(int type)
+{
+	return latency_hist_type & (1 << type);
+}
+
+static inline int latency_hist_in_section(int type)
+{
+	struct latency_hist_cpu *h;
+
+	h = per_cpu(latency_hist, raw_smp_processor_id())[type];
+	return h && h->start_site;
+}
+
+/* cpu_clock() would trace the irqs it disables */
+static unsigned long long latency_hist_clock(int cpu)
+{
+	unsigned long long clock;
+	unsigned long flags;
+
+	raw_local_irq_save(flags);
+	clock = sched_clock_cpu(cpu);
+	raw_local_irq_restore(flags);
+
+	return clock;
+}
+
+/* The lock functions are out of line on SMP, count their caller */
+static inline unsigned long
+latency_hist_site(unsigned long ip, unsigned long parent_ip)
+{
+	if (parent_ip && in_lock_functions(ip))
+		return parent_ip;
+	return ip;
+}
+
+static void
+latency_hist_start(int type, unsigned long ip, unsigned long parent_ip)
+{
+	int cpu = raw_smp_processor_id();
+	struct latency_hist_cpu *h = per_cpu(latency_hist, cpu)[type];
+
+	if (h->start_site)
+		return;
+
+	/* the idle routine disabling interrupts to sleep is no section */
+	if (unlikely(h->idle)) {
+		h->idle = 0;
+		return;
+	}
+
+	h->start = latency_hist_clock(cpu);
+	h->start_site = latency_hist_site(ip, parent_ip);
+}
+
+static void
+latency_hist_stop(int type, unsigned long ip, unsigned long parent_ip)
+{
+	int cpu = raw_smp_processor_id();
+	struct latency_hist_cpu *h = per_cpu(latency_hist, cpu)[type];
+	struct latency_hist_site *s;
+	unsigned long long delta;
+	unsigned long site, seq;
+	int i, n;
+
+	site = h->start_site;
+	h->start_site = 0;
+	if (!latency_hist_enabled(type))
+		return;
+
+	delta = latency_hist_clock(cpu) - h->start;
+
+	/* the tables were cleared: only this CPU may write to its own */
+	seq = ACCESS_ONCE(latency_hist_seq);
+	if (unlikely(h->seq != seq)) {
+		memset(h->sites, 0, sizeof(h->sites));
+		h->dropped = 0;
+		h->seq = seq;
+	}
+
+	i = hash_long(site, LATENCY_HIST_SITES_BITS);
+	for (n = 0; n < LATENCY_HIST_SITES; n++) {
+		s = &h->sites[(i + n) & (LATENCY_HIST_SITES - 1)];
+		if (s->site == site)
+			goto found;
+		if (!s->site) {
+			s->site = site;
+			goto found;
+		}
+	}
+	h->dropped++;
+	return;
+
+found:
+	if (trace_hist_add(&s->hist, delta))
+		s->max_end = latency_hist_site(ip, parent_ip);
+}
+
+/*
+ * Between stop_critical_timings() and start_critical_timings() the next
+ * irqs-off section is not timed: it is the one the idle routine opens to
+ * go to sleep. The interrupts that wake the CPU up are timed as usual.
+ */
+static inline void latency_hist_set_idle(int idle)
+{
+	struct latency_hist_cpu *h;
+
+	h = per_cpu(latency_hist, raw_smp_processor_id())[LATENCY_HIST_IRQSOFF];
+	if (h)
+		h->idle = idle;
+}
+
 /* start and stop critical timings used to for stoppage (in idle) */
 void start_critical_timings(void)
 {
 	if (preempt_trace() || irq_trace())
 		start_critical_timing(CALLER_ADDR0, CALLER_ADDR1);
+
+	latency_hist_set_idle(0);
+	if (latency_hist_enabled(LATENCY_HIST_IRQSOFF) && irqs_disabled())
+		latency_hist_start(LATENCY_HIST_IRQSOFF, CALLER_ADDR0, 0);
+	if (latency_hist_enabled(LATENCY_HIST_PREEMPTOFF) && preempt_count())
+		latency_hist_start(LATENCY_HIST_PREEMPTOFF, CALLER_ADDR0, 0);
 }
 EXPORT_SYMBOL_GPL(start_critical_timings);
 
@@ -262,6 +429,12 @@ void stop_critical_timings(void)
 {
 	if (preempt_trace() || irq_trace())
 		stop_critical_timing(CALLER_ADDR0, CALLER_ADDR1);
+
+	if (latency_hist_in_section(LATENCY_HIST_IRQSOFF))
+		latency_hist_stop(LATENCY_HIST_IRQSOFF, CALLER_ADDR0, 0);
+	if (latency_hist_in_section(LATENCY_HIST_PREEMPTOFF))
+		latency_hist_stop(LATENCY_HIST_PREEMPTOFF, CALLER_ADDR0, 0);
+	latency_hist_set_idle(1);
 }
 EXPORT_SYMBOL_GPL(stop_critical_timings);
 
@@ -271,12 +444,16 @@ void time_hardirqs_on(unsigned long a0, unsigned long a1)
 {
 	if (!preempt_trace() && irq_trace())
 		stop_critical_timing(a0, a1);
+	if (latency_hist_in_section(LATENCY_HIST_IRQSOFF))
+		latency_hist_stop(LATENCY_HIST_IRQSOFF, a1, 0);
 }
 
 void time_hardirqs_off(unsigned long a0, unsigned long a1)
 {
 	if (!preempt_trace() && irq_trace())
 		start_critical_timing(a0, a1);
+	if (latency_hist_enabled(LATENCY_HIST_IRQSOFF))
+		latency_hist_start(LATENCY_HIST_IRQSOFF, a1, 0);
 }
 
 #else /* !CONFIG_PROVE_LOCKING */
@@ -312,6 +489,8 @@ void trace_hardirqs_on(void)
 {
 	if (!preempt_trace() && irq_trace())
 		stop_critical_timing(CALLER_ADDR0, CALLER_ADDR1);
+	if (latency_hist_in_section(LATENCY_HIST_IRQSOFF))
+		latency_hist_stop(LATENCY_HIST_IRQSOFF, CALLER_ADDR0, CALLER_ADDR1);
 }
 EXPORT_SYMBOL(trace_hardirqs_on);
 
@@ -319,6 +498,8 @@ void trace_hardirqs_off(void)
 {
 	if (!preempt_trace() && irq_trace())
 		start_critical_timing(CALLER_ADDR0, CALLER_ADDR1);
+	if (latency_hist_enabled(LATENCY_HIST_IRQSOFF))
+		latency_hist_start(LATENCY_HIST_IRQSOFF, CALLER_ADDR0, CALLER_ADDR1);
 }
 EXPORT_SYMBOL(trace_hardirqs_off);
 
@@ -326,6 +507,8 @@ void trace_hardirqs_on_caller(unsigned long caller_addr)
 {
 	if (!preempt_trace() && irq_trace())
 		stop_critical_timing(CALLER_ADDR0, caller_addr);
+	if (latency_hist_in_section(LATENCY_HIST_IRQSOFF))
+		latency_hist_stop(LATENCY_HIST_IRQSOFF, caller_addr, 0);
 }
 EXPORT_SYMBOL(trace_hardirqs_on_caller);
 
@@ -333,6 +516,8 @@ void trace_hardirqs_off_caller(unsigned long caller_addr)
 {
 	if (!preempt_trace() && irq_trace())
 		start_critical_timing(CALLER_ADDR0, caller_addr);
+	if (latency_hist_enabled(LATENCY_HIST_IRQSOFF))
+		latency_hist_start(LATENCY_HIST_IRQSOFF, caller_addr, 0);
 }
 EXPORT_SYMBOL(trace_hardirqs_off_caller);
 
@@ -344,24 +529,44 @@ void trace_preempt_on(unsigned long a0, unsigned long a1)
 {
 	if (preempt_trace())
 		stop_critical_timing(a0, a1);
+	if (latency_hist_in_section(LATENCY_HIST_PREEMPTOFF))
+		latency_hist_stop(LATENCY_HIST_PREEMPTOFF, a0, a1);
 }
 
 void trace_preempt_off(unsigned long a0, unsigned long a1)
 {
 	if (preempt_trace())
 		start_critical_timing(a0, a1);
+	if (latency_hist_enabled(LATENCY_HIST_PREEMPTOFF))
+		latency_hist_start(LATENCY_HIST_PREEMPTOFF, a0, a1);
 }
 #endif /* CONFIG_PREEMPT_TRACER */
 
+#ifdef CONFIG_PREEMPT_TRACER
+/* add_preempt_count() and sub_preempt_count() only look up the parent if set */
+int trace_preempt_active __read_mostly;
+
+static void update_preempt_active(void)
+{
+	trace_preempt_active =
+		(tracer_enabled && (trace_type & TRACER_PREEMPT_OFF)) ||
+		latency_hist_enabled(LATENCY_HIST_PREEMPTOFF);
+}
+#else
+static inline void update_preempt_active(void) { }
+#endif
+
 static void start_irqsoff_tracer(struct trace_array *tr)
 {
 	register_ftrace_function(&trace_ops);
 	tracer_enabled = 1;
+	update_preempt_active();
 }
 
 static void stop_irqsoff_tracer(struct trace_array *tr)
 {
 	tracer_enabled = 0;
+	update_preempt_active();
 	unregister_ftrace_function(&trace_ops);
 }
 
@@ -482,11 +687,253 @@ static struct tracer preemptirqsoff_tracer __read_mostly =
 # define register_preemptirqsoff(trace) do { } while (0)
 #endif
 
+/* The tables are kept once allocated, the readers never wait for them */
+static int latency_hist_alloc(int types)
+{
+	struct latency_hist_cpu *h;
+	int cpu, type;
+
+	for_each_possible_cpu(cpu) {
+		for (type = 0; type < LATENCY_HIST_TYPES; type++) {
+			if (!(types & (1 << type)) ||
+			    per_cpu(latency_hist, cpu)[type])
+				continue;
+
+			h = kzalloc(sizeof(*h), GFP_KERNEL);
+			if (!h)
+				return -ENOMEM;
+			h->seq = latency_hist_seq;
+			smp_wmb();
+			per_cpu(latency_hist, cpu)[type] = h;
+		}
+	}
+	return 0;
+}
+
+static void start_latency_hist(struct trace_array *tr)
+{
+	mutex_lock(&latency_hist_lock);
+	if (latency_hist_alloc(hist_type)) {
+		printk(KERN_WARNING "latency_hist: can't allocate the "
+		       "histograms\n");
+	} else {
+		latency_hist_seq++;
+		smp_wmb();
+		latency_hist_type = hist_type;
+		update_preempt_active();
+	}
+	mutex_unlock(&latency_hist_lock);
+}
+
+static void stop_latency_hist(struct trace_array *tr)
+{
+	latency_hist_type = 0;
+	update_preempt_active();
+}
+
+static void __latency_hist_init(struct trace_array *tr)
+{
+	/* nothing goes to the buffers */
+	trace_type = 0;
+
+	if (tr->ctrl)
+		start_latency_hist(tr);
+}
+
+static void latency_hist_reset(struct trace_array *tr)
+{
+	if (tr->ctrl)
+		stop_latency_hist(tr);
+}
+
+static void latency_hist_ctrl_update(struct trace_array *tr)
+{
+	if (tr->ctrl)
+		start_latency_hist(tr);
+	else
+		stop_latency_hist(tr);
+}
+
+#ifdef CONFIG_IRQSOFF_TRACER
+static void irqsoff_hist_init(struct trace_array *tr)
+{
+	hist_type = 1 << LATENCY_HIST_IRQSOFF;
+
+	__latency_hist_init(tr);
+}
+
+static struct tracer irqsoff_hist_tracer __read_mostly =
+{
+	.name		= "irqsoff_hist",
+	.init		= irqsoff_hist_init,
+	.reset		= latency_hist_reset,
+	.ctrl_update	= latency_hist_ctrl_update,
+};
+#endif
+
+#ifdef CONFIG_PREEMPT_TRACER
+static void preemptoff_hist_init(struct trace_array *tr)
+{
+	hist_type = 1 << LATENCY_HIST_PREEMPTOFF;
+
+	__latency_hist_init(tr);
+}
+
+static struct tracer preemptoff_hist_tracer __read_mostly =
+{
+	.name		= "preemptoff_hist",
+	.init		= preemptoff_hist_init,
+	.reset		= latency_hist_reset,
+	.ctrl_update	= latency_hist_ctrl_update,
+};
+#endif
+
+#if defined(CONFIG_IRQSOFF_TRACER) && \
+	defined(CONFIG_PREEMPT_TRACER)
+static void preemptirqsoff_hist_init(struct trace_array *tr)
+{
+	hist_type = (1 << LATENCY_HIST_IRQSOFF) |
+		    (1 << LATENCY_HIST_PREEMPTOFF);
+
+	__latency_hist_init(tr);
+}
+
+static struct tracer preemptirqsoff_hist_tracer __read_mostly =
+{
+	.name		= "preemptirqsoff_hist",
+	.init		= preemptirqsoff_hist_init,
+	.reset		= latency_hist_reset,
+	.ctrl_update	= latency_hist_ctrl_update,
+};
+#endif
+
+/* Longest sections first */
+static int latency_hist_cmp(const void *a, const void *b)
+{
+	const struct latency_hist_site *sa = a, *sb = b;
+
+	if (sa->hist.max > sb->hist.max)
+		return -1;
+	return sa->hist.max < sb->hist.max;
+}
+
+/* Sum the tables of all CPUs into @sum, sorted, return the sites */
+static int latency_hist_sum(int type, struct latency_hist_site *sum,
+			    unsigned long *dropped)
+{
+	struct latency_hist_cpu *h;
+	struct latency_hist_site *s;
+	int cpu, i, j, nr = 0;
+
+	*dropped = 0;
+	for_each_possible_cpu(cpu) {
+		h = per_cpu(latency_hist, cpu)[type];
+		/* a CPU clears its tables the next time it writes */
+		if (!h || h->seq != latency_hist_seq)
+			continue;
+
+		*dropped += h->dropped;
+		for (i = 0; i < LATENCY_HIST_SITES; i++) {
+			s = &h->sites[i];
+			if (!s->site || !s->hist.count)
+				continue;
+
+			for (j = 0; j < nr; j++)
+				if (sum[j].site == s->site)
+					break;
+			if (j == nr) {
+				memset(&sum[nr], 0, sizeof(*sum));
+				sum[nr++].site = s->site;
+			}
+
+			if (trace_hist_sum(&sum[j].hist, &s->hist))
+				sum[j].max_end = s->max_end;
+		}
+	}
+
+	sort(sum, nr, sizeof(*sum), latency_hist_cmp, NULL);
+	return nr;
+}
+
+static int latency_hist_show(struct seq_file *m, void *v)
+{
+	struct latency_hist_site *sum, *s;
+	unsigned long dropped;
+	int type, nr, i, b;
+
+	sum = vmalloc(sizeof(*sum) * LATENCY_HIST_SITES * num_possible_cpus());
+	if (!sum)
+		return -ENOMEM;
+
+	mutex_lock(&latency_hist_lock);
+	for (type = 0; type < LATENCY_HIST_TYPES; type++) {
+		nr = latency_hist_sum(type, sum, &dropped);
+		if (!nr)
+			continue;
+
+		seq_printf(m, "%s: %d sites, %lu sections dropped\n",
+			   latency_hist_names[type], nr, dropped);
+		for (i = 0; i < nr; i++) {
+			s = &sum[i];
+			seq_printf(m, "%pS: %lu sections, avg %llu us, "
+				   "max %llu us ending at %pS\n",
+				   (void *)s->site, s->hist.count,
+				   div_u64(div_u64(s->hist.total, s->hist.count),
+					   1000),
+				   div_u64(s->hist.max, 1000), (void *)s->max_end);
+			seq_printf(m, "\tus");
+			for (b = 0; b < TRACE_HIST_BUCKETS; b++) {
+				if (!s->hist.bucket[b])
+					continue;
+				if (b < TRACE_HIST_BUCKETS - 1)
+					seq_printf(m, " <%lu:%lu", 1UL << b,
+						   s->hist.bucket[b]);
+				else
+					seq_printf(m, " >=%lu:%lu",
+						   1UL << (b - 1),
+						   s->hist.bucket[b]);
+			}
+			seq_putc(m, '\n');
+		}
+		seq_putc(m, '\n');
+	}
+	mutex_unlock(&latency_hist_lock);
+
+	vfree(sum);
+	return 0;
+}
+
+static void latency_hist_clear(void)
+{
+	mutex_lock(&latency_hist_lock);
+	latency_hist_seq++;
+	mutex_unlock(&latency_hist_lock);
+}
+
+static struct trace_hist_file latency_hist_file = {
+	.show		= latency_hist_show,
+	.clear		= latency_hist_clear,
+};
+
 __init static int init_irqsoff_tracer(void)
 {
+	struct dentry *d_tracer;
+	struct dentry *entry;
+
+	d_tracer = tracing_init_dentry();
+
+	entry = debugfs_create_file("latency_hist", 0644, d_tracer,
+				    &latency_hist_file, &trace_hist_fops);
+	if (!entry)
+		pr_warning("Could not create debugfs "
+			   "'latency_hist' entry\n");
+
 	register_irqsoff(irqsoff_tracer);
 	register_preemptoff(preemptoff_tracer);
 	register_preemptirqsoff(preemptirqsoff_tracer);
+	register_irqsoff(irqsoff_hist_tracer);
+	register_preemptoff(preemptoff_hist_tracer);
+	register_preemptirqsoff(preemptirqsoff_hist_tracer);
 
 	return 0;
 }
@@ -105,6 +105,20 @@ SYSCALL_DEFINE(fadvise64_64)(int fd, loff_t offset, loff_t len, int advice)
 		if (ret > 0)
 			ret = 0;
 		break;
+	case POSIX_FADV_WILLNEED_TRACE:
+		ret = ra_trace_replay(file, offset >> PAGE_CACHE_SHIFT,
+				      endbyte >> PAGE_CACHE_SHIFT);
+		if (ret > 0)
+			ret = 0;
+		break;
+	case POSIX_FADV_PIN:
+		ret = pagecache_pin(file, offset >> PAGE_CACHE_SHIFT,
+				    endbyte >> PAGE_CACHE_SHIFT);
+		break;
+	case POSIX_FADV_UNPIN:
+		ret = pagecache_unpin(file, offset >> PAGE_CACHE_SHIFT,
+				      endbyte >> PAGE_CACHE_SHIFT);
+		break;
 	case POSIX_FADV_NOREUSE:
 		break;
 	case POSIX_FADV_DONTNEED:
@@ -1191,6 +1191,7 @@ no_cached_page:
 			desc->error = error;
 			goto out;
 		}
+		ra_trace_record(mapping, index, 1);
 		goto readpage;
 	}
 
@@ -1415,8 +1416,10 @@ static int page_cache_read(struct file *file, pgoff_t offset)
 			return -ENOMEM;
 
 		ret = add_to_page_cache_lru(page, mapping, offset, GFP_KERNEL);
-		if (ret == 0)
+		if (ret == 0) {
+			ra_trace_record(mapping, offset, 1);
 			ret = mapping->a_ops->readpage(file, page);
+		}
 		else if (ret == -EEXIST)
 			ret = 0; /* losing race to add is OK */
 
@@ -1598,8 +1601,75 @@ page_not_uptodate:
 }
 EXPORT_SYMBOL(filemap_fault);
 
+/**
+ * filemap_map_pages - map the cached pages around a read fault
+ * @vma:	vma in which the fault was taken
+ * @vmf:	struct vm_fault with the range of pages to map
+ *
+ * Maps the pages from @vmf->pgoff to @vmf->max_pgoff which are uptodate in
+ * the page cache and have no pte yet, at the corresponding ptes from
+ * @vmf->pte on. Pages which are locked, under readahead or not uptodate are
+ * left for filemap_fault(). Called with the page table lock held, so it
+ * must not sleep.
+ */
+void filemap_map_pages(struct vm_area_struct *vma, struct vm_fault *vmf)
+{
+	struct file *file = vma->vm_file;
+	struct address_space *mapping = file->f_mapping;
+	struct file_ra_state *ra = &file->f_ra;
+	struct page *pages[PAGEVEC_SIZE];
+	pgoff_t index = vmf->pgoff;
+	unsigned int i, nr;
+
+	while (index <= vmf->max_pgoff) {
+		nr = min_t(pgoff_t, PAGEVEC_SIZE, vmf->max_pgoff - index + 1);
+		nr = find_get_pages(mapping, index, nr, pages);
+		if (!nr)
+			break;
+		index = pages[nr - 1]->index + 1;
+
+		for (i = 0; i < nr; i++) {
+			struct page *page = pages[i];
+			unsigned long address;
+			loff_t size;
+			pte_t *pte;
+
+			if (page->index > vmf->max_pgoff)
+				goto skip;
+			if (!PageUptodate(page) || PageReadahead(page))
+				goto skip;
+			if (!trylock_page(page))
+				goto skip;
+			if (page->mapping != mapping || !PageUptodate(page))
+				goto unlock;
+			/* Must check i_size under page lock */
+			size = i_size_read(mapping->host) + PAGE_CACHE_SIZE - 1;
+			if (page->index >= size >> PAGE_CACHE_SHIFT)
+				goto unlock;
+
+			pte = vmf->pte + page->index - vmf->pgoff;
+			if (!pte_none(*pte))
+				goto unlock;
+
+			address = (unsigned long)vmf->virtual_address +
+				((page->index - vmf->pgoff) << PAGE_SHIFT);
+			if (ra->mmap_miss > 0)
+				ra->mmap_miss--;
+			do_set_pte(vma, address, page, pte);
+			unlock_page(page);
+			continue;
+unlock:
+			unlock_page(page);
+skip:
+			page_cache_release(page);
+		}
+	}
+}
+EXPORT_SYMBOL(filemap_map_pages);
+
 struct vm_operations_struct generic_file_vm_ops = {
 	.fault		= filemap_fault,
+	.map_pages	= filemap_map_pages,
 };
 
 /* This is used for a general mmap of a disk file */
@@ -0,0 +1,941 @@
+/*
+ * Memory merging support.
+ *
+ * This code enables dynamic sharing of identical pages found in different
+ * memory areas, even if they are not shared by fork(). Processes opt in with
+ * madvise(MADV_MERGEABLE), which marks their anonymous vmas VM_MERGEABLE.
+ * The ksmd kernel thread then scans those vmas, 'pages_to_scan' pages every
+ * 'sleep_millisecs', and merges pages with identical content into a single
+ * write-protected KSM page. A write to a KSM page breaks the sharing through
+ * the usual copy-on-write fault.
+ *
+ * Two hash tables keyed by a checksum of the page content are used:
+ *
+ * o the stable table holds the KSM pages. Their content cannot change, so
+ *   a scanned page which matches one is simply mapped to it instead;
+ * o the unstable table holds the pages scanned in the current pass which
+ *   matched nothing yet. Their content may change at any time, so the table
+ *   is only a hint: a match is compared again after write-protecting both
+ *   pages, and the table is emptied at the start of every pass.
+ *
+ * When a page matches an unstable entry, both are replaced by a newly
+ * allocated KSM page, which goes to the stable table. KSM pages are not on
+ * the LRU and never reclaimed; once nothing maps a KSM page any more, it is
+ * freed at the start of the next pass.
+ *
+ * Statistics and tunables are in /sys/kernel/mm/ksm.
+ * See Documentation/vm/ksm.txt.
+ */
+
+#include <linux/errno.h>
+#include <linux/mm.h>
+#include <linux/fs.h>
+#include <linux/mman.h>
+#include <linux/sched.h>
+#include <linux/rwsem.h>
+#include <linux/pagemap.h>
+#include <linux/rmap.h>
+#include <linux/spinlock.h>
+#include <linux/jhash.h>
+#include <linux/delay.h>
+#include <linux/kthread.h>
+#include <linux/wait.h>
+#include <linux/slab.h>
+#include <linux/highmem.h>
+#include <linux/freezer.h>
+#include <linux/mmu_notifier.h>
+#include <linux/ksm.h>
+
+#include <asm/tlbflush.h>
+
+#define KSM_HASH_BITS	10
+#define KSM_HASH_SIZE	(1 << KSM_HASH_BITS)
+
+/**
+ * struct ksm_mm_slot - a mm registered for merging.
+ * @list: link in the list of registered mms, @ksm_mm_head
+ * @mm: the mm, whose mm_count is held by the slot
+ *
+ * When the mm exits, '__ksm_exit()' releases the slot right away if ksmd has
+ * not reached it in the current pass yet, so that no unstable table entry can
+ * refer to the mm. A slot ksmd has already scanned is moved to
+ * @ksm_dead_slots and released at the start of the next pass, when the
+ * unstable table is emptied. The slot ksmd is on is left for ksmd, which
+ * finds that the mm has exited and moves it to @ksm_dead_slots itself.
+ */
+struct ksm_mm_slot {
+	struct list_head list;
+	struct mm_struct *mm;
+};
+
+/**
+ * struct ksm_stable_item - a KSM page in the stable table.
+ * @hash: link in the stable table
+ * @kpage: the KSM page, one reference of which is held by the item
+ * @checksum: checksum of the content of @kpage
+ */
+struct ksm_stable_item {
+	struct hlist_node hash;
+	struct page *kpage;
+	u32 checksum;
+};
+
+/**
+ * struct ksm_unstable_item - a page scanned in the current pass.
+ * @hash: link in the unstable table
+ * @mm: the mm the page was found in
+ * @address: the virtual address the page was found at
+ * @checksum: checksum of the content of the page when it was scanned
+ */
+struct ksm_unstable_item {
+	struct hlist_node hash;
+	struct mm_struct *mm;
+	unsigned long address;
+	u32 checksum;
+};
+
+/*
+ * The registered and the exited mms, protected by @ksm_mmlist_lock. ksmd
+ * only changes @ksm_scan_slot with it held, so that '__ksm_exit()' can tell
+ * where ksmd is.
+ */
+static LIST_HEAD(ksm_mm_head);
+static LIST_HEAD(ksm_dead_slots);
+static struct ksm_mm_slot *ksm_scan_slot;
+static DEFINE_SPINLOCK(ksm_mmlist_lock);
+
+/* These are only used by ksmd, with @ksm_thread_mutex held */
+static struct hlist_head ksm_stable_hash[KSM_HASH_SIZE];
+static struct hlist_head ksm_unstable_hash[KSM_HASH_SIZE];
+static unsigned long ksm_scan_address;
+
+static struct kmem_cache *ksm_unstable_cache;
+
+/* Statistics */
+static unsigned long ksm_pages_shared;
+static unsigned long ksm_pages_unshared;
+static unsigned long ksm_full_scans;
+
+/* Tunables */
+static unsigned int ksm_thread_pages_to_scan = 100;
+static unsigned int ksm_thread_sleep_millisecs = 20;
+static unsigned int ksm_run;
+
+static DECLARE_WAIT_QUEUE_HEAD(ksm_thread_wait);
+static DEFINE_MUTEX(ksm_thread_mutex);
+
+static struct hlist_head *ksm_bucket(struct hlist_head *table, u32 checksum)
+{
+	return &table[checksum & (KSM_HASH_SIZE - 1)];
+}
+
+static u32 calc_checksum(struct page *page)
+{
+	void *addr = kmap_atomic(page, KM_USER0);
+	u32 checksum = jhash2(addr, PAGE_SIZE / 4, 17);
+
+	kunmap_atomic(addr, KM_USER0);
+	return checksum;
+}
+
+static int pages_identical(struct page *page1, struct page *page2)
+{
+	char *addr1, *addr2;
+	int ret;
+
+	addr1 = kmap_atomic(page1, KM_USER0);
+	addr2 = kmap_atomic(page2, KM_USER1);
+	ret = !memcmp(addr1, addr2, PAGE_SIZE);
+	kunmap_atomic(addr2, KM_USER1);
+	kunmap_atomic(addr1, KM_USER0);
+	return ret;
+}
+
+/*
+ * Write-protects the pte of @page in @vma, so that its content cannot change
+ * behind our back, and returns it in @orig_pte. Fails if anybody but the page
+ * tables and us holds a reference to the page, eg. for O_DIRECT I/O.
+ */
+static int write_protect_page(struct vm_area_struct *vma, struct page *page,
+			      pte_t *orig_pte)
+{
+	struct mm_struct *mm = vma->vm_mm;
+	unsigned long addr;
+	pte_t *ptep;
+	spinlock_t *ptl;
+	int err = -EFAULT;
+
+	addr = page_address_in_vma(page, vma);
+	if (addr == -EFAULT)
+		goto out;
+
+	ptep = page_check_address(page, mm, addr, &ptl, 0);
+	if (!ptep)
+		goto out;
+
+	if (pte_write(*ptep) || pte_dirty(*ptep)) {
+		int swapped = PageSwapCache(page);
+		pte_t entry;
+
+		flush_cache_page(vma, addr, page_to_pfn(page));
+		/*
+		 * Clear the pte and flush the TLB first, so that nobody can
+		 * start a get_user_pages() on the page while we check its
+		 * reference count.
+		 */
+		entry = ptep_clear_flush_notify(vma, addr, ptep);
+		if (page_mapcount(page) + 1 + swapped != page_count(page)) {
+			set_pte_at(mm, addr, ptep, entry);
+			goto out_unlock;
+		}
+		if (pte_dirty(entry))
+			set_page_dirty(page);
+		entry = pte_mkclean(pte_wrprotect(entry));
+		set_pte_at(mm, addr, ptep, entry);
+	}
+	*orig_pte = *ptep;
+	err = 0;
+
+out_unlock:
+	pte_unmap_unlock(ptep, ptl);
+out:
+	return err;
+}
+
+/*
+ * Maps @kpage instead of @page in @vma, if the pte is still @orig_pte, ie. the
+ * write-protected one which @page was compared with.
+ */
+static int replace_page(struct vm_area_struct *vma, struct page *page,
+			struct page *kpage, pte_t orig_pte)
+{
+	struct mm_struct *mm = vma->vm_mm;
+	pgd_t *pgd;
+	pud_t *pud;
+	pmd_t *pmd;
+	pte_t *ptep;
+	spinlock_t *ptl;
+	unsigned long addr;
+
+	addr = page_address_in_vma(page, vma);
+	if (addr == -EFAULT)
+		return -EFAULT;
+
+	pgd = pgd_offset(mm, addr);
+	if (!pgd_present(*pgd))
+		return -EFAULT;
+	pud = pud_offset(pgd, addr);
+	if (!pud_present(*pud))
+		return -EFAULT;
+	pmd = pmd_offset(pud, addr);
+	if (!pmd_present(*pmd))
+		return -EFAULT;
+
+	ptep = pte_offset_map_lock(mm, pmd, addr, &ptl);
+	if (!pte_same(*ptep, orig_pte)) {
+		pte_unmap_unlock(ptep, ptl);
+		return -EFAULT;
+	}
+
+	get_page(kpage);
+	page_add_ksm_rmap(kpage);
+
+	flush_cache_page(vma, addr, pte_pfn(*ptep));
+	ptep_clear_flush_notify(vma, addr, ptep);
+	set_pte_at(mm, addr, ptep,
+		   pte_wrprotect(mk_pte(kpage, vma->vm_page_prot)));
+
+	page_remove_rmap(page, vma);
+	put_page(page);
+
+	pte_unmap_unlock(ptep, ptl);
+	return 0;
+}
+
+/*
+ * Replaces @page, mapped in @vma, by @kpage if their content is the same.
+ * The caller holds a reference to @page and mmap_sem of the mm for reading.
+ */
+static int try_to_merge_one_page(struct vm_area_struct *vma,
+				 struct page *page, struct page *kpage)
+{
+	pte_t orig_pte = __pte(0);
+	int err = -EFAULT;
+
+	if (page == kpage || !PageAnon(page) || PageKsm(page))
+		return -EFAULT;
+
+	/*
+	 * The page lock keeps the page from being added to the swap cache
+	 * while we work on it.
+	 */
+	if (!trylock_page(page))
+		return -EBUSY;
+
+	if (write_protect_page(vma, page, &orig_pte) == 0 &&
+	    pages_identical(page, kpage))
+		err = replace_page(vma, page, kpage, orig_pte);
+
+	unlock_page(page);
+	return err;
+}
+
+/*
+ * Looks up the page currently mapped at @addr in @mm, which is not the mm
+ * ksmd is scanning. Returns with mm_users and mmap_sem of @mm held, which the
+ * caller releases with 'put_foreign_page()'.
+ */
+static struct page *get_foreign_page(struct mm_struct *mm, unsigned long addr,
+				     struct vm_area_struct **vmap)
+{
+	struct vm_area_struct *vma;
+	struct page *page;
+
+	if (!atomic_inc_not_zero(&mm->mm_users))
+		return NULL;
+	/* Never wait for it, ksmd already holds mmap_sem of another mm */
+	if (!down_read_trylock(&mm->mmap_sem)) {
+		mmput(mm);
+		return NULL;
+	}
+
+	vma = find_vma(mm, addr);
+	if (vma && vma->vm_start <= addr && (vma->vm_flags & VM_MERGEABLE) &&
+	    vma->anon_vma) {
+		page = follow_page(vma, addr, FOLL_GET);
+		if (page) {
+			*vmap = vma;
+			return page;
+		}
+	}
+
+	up_read(&mm->mmap_sem);
+	mmput(mm);
+	return NULL;
+}
+
+static void put_foreign_page(struct mm_struct *mm, struct page *page)
+{
+	put_page(page);
+	up_read(&mm->mmap_sem);
+	mmput(mm);
+}
+
+static void remove_unstable_item(struct ksm_unstable_item *item)
+{
+	hlist_del(&item->hash);
+	kmem_cache_free(ksm_unstable_cache, item);
+	ksm_pages_unshared -= 1;
+}
+
+/*
+ * Merges @page with an identical page from the unstable table, if there is
+ * one, into a new KSM page. Returns 0 if the page was merged.
+ */
+static int merge_with_unstable(struct vm_area_struct *vma, unsigned long addr,
+			       struct page *page, u32 checksum)
+{
+	struct hlist_head *head = ksm_bucket(ksm_unstable_hash, checksum);
+	struct ksm_unstable_item *item;
+	struct hlist_node *node, *tmp;
+	struct ksm_stable_item *stable;
+
+	hlist_for_each_entry_safe(item, node, tmp, head, hash) {
+		struct vm_area_struct *tree_vma;
+		struct page *tree_page, *kpage;
+		int foreign = item->mm != vma->vm_mm;
+		int err;
+
+		if (item->checksum != checksum)
+			continue;
+		if (!foreign && item->address == addr)
+			continue;
+
+		if (foreign)
+			tree_page = get_foreign_page(item->mm, item->address,
+						     &tree_vma);
+		else {
+			tree_vma = find_vma(vma->vm_mm, item->address);
+			tree_page = NULL;
+			if (tree_vma && tree_vma->vm_start <= item->address &&
+			    (tree_vma->vm_flags & VM_MERGEABLE) &&
+			    tree_vma->anon_vma)
+				tree_page = follow_page(tree_vma, item->address,
+							FOLL_GET);
+		}
+		if (!tree_page) {
+			remove_unstable_item(item);
+			continue;
+		}
+		if (!PageAnon(tree_page) || PageKsm(tree_page) ||
+		    tree_page == page || !pages_identical(page, tree_page)) {
+			if (foreign)
+				put_foreign_page(item->mm, tree_page);
+			else
+				put_page(tree_page);
+			continue;
+		}
+
+		err = -ENOMEM;
+		stable = kmalloc(sizeof(struct ksm_stable_item), GFP_KERNEL);
+		kpage = alloc_page_vma(GFP_HIGHUSER, vma, addr);
+		if (stable && kpage) {
+			copy_user_highpage(kpage, page, addr, vma);
+			__SetPageUptodate(kpage);
+			kpage->mapping = (void *)PAGE_MAPPING_ANON;
+			err = try_to_merge_one_page(vma, page, kpage);
+		}
+		if (!err)
+			try_to_merge_one_page(tree_vma, tree_page, kpage);
+
+		if (foreign)
+			put_foreign_page(item->mm, tree_page);
+		else
+			put_page(tree_page);
+
+		if (err) {
+			kfree(stable);
+			if (kpage)
+				put_page(kpage);
+			return err;
+		}
+
+		remove_unstable_item(item);
+		stable->kpage = kpage;
+		stable->checksum = checksum;
+		hlist_add_head(&stable->hash,
+			       ksm_bucket(ksm_stable_hash, checksum));
+		ksm_pages_shared += 1;
+		return 0;
+	}
+	return -EFAULT;
+}
+
+/*
+ * Tries to merge @page, mapped at @addr in @vma, with a KSM page or with
+ * another page scanned in this pass. If that fails, remembers it in the
+ * unstable table.
+ */
+static void cmp_and_merge_page(struct vm_area_struct *vma, unsigned long addr,
+			       struct page *page)
+{
+	struct ksm_stable_item *stable;
+	struct ksm_unstable_item *item;
+	struct hlist_node *node;
+	u32 checksum;
+
+	if (!PageAnon(page) || PageKsm(page))
+		return;
+
+	checksum = calc_checksum(page);
+
+	hlist_for_each_entry(stable, node,
+			     ksm_bucket(ksm_stable_hash, checksum), hash) {
+		if (stable->checksum == checksum &&
+		    pages_identical(page, stable->kpage)) {
+			try_to_merge_one_page(vma, page, stable->kpage);
+			return;
+		}
+	}
+
+	if (merge_with_unstable(vma, addr, page, checksum) == 0)
+		return;
+
+	item = kmem_cache_alloc(ksm_unstable_cache, GFP_KERNEL);
+	if (!item)
+		return;
+	item->mm = vma->vm_mm;
+	item->address = addr;
+	item->checksum = checksum;
+	hlist_add_head(&item->hash, ksm_bucket(ksm_unstable_hash, checksum));
+	ksm_pages_unshared += 1;
+}
+
+/*
+ * Called at the start of every pass: empties the unstable table, frees the KSM
+ * pages which are not mapped any more and releases the slots of exited mms.
+ */
+static void ksm_new_pass(void)
+{
+	struct ksm_unstable_item *item;
+	struct ksm_stable_item *stable;
+	struct ksm_mm_slot *slot, *tmp;
+	struct hlist_node *node, *next;
+	LIST_HEAD(dead);
+	int i;
+
+	for (i = 0; i < KSM_HASH_SIZE; i++) {
+		hlist_for_each_entry_safe(item, node, next,
+					  &ksm_unstable_hash[i], hash)
+			remove_unstable_item(item);
+
+		hlist_for_each_entry_safe(stable, node, next,
+					  &ksm_stable_hash[i], hash) {
+			if (page_mapped(stable->kpage))
+				continue;
+			hlist_del(&stable->hash);
+			put_page(stable->kpage);
+			kfree(stable);
+			ksm_pages_shared -= 1;
+		}
+		cond_resched();
+	}
+
+	spin_lock(&ksm_mmlist_lock);
+	list_splice_init(&ksm_dead_slots, &dead);
+	spin_unlock(&ksm_mmlist_lock);
+
+	list_for_each_entry_safe(slot, tmp, &dead, list) {
+		list_del(&slot->list);
+		mmdrop(slot->mm);
+		kfree(slot);
+	}
+
+	ksm_full_scans += 1;
+}
+
+/*
+ * Moves ksmd on to the slot after @slot, or to the first one if @slot is
+ * NULL, and returns it. If @dead is set, @slot goes to @ksm_dead_slots.
+ * Returns NULL at the end of the list.
+ */
+static struct ksm_mm_slot *ksm_next_slot(struct ksm_mm_slot *slot, int dead)
+{
+	struct ksm_mm_slot *next = NULL;
+
+	spin_lock(&ksm_mmlist_lock);
+	if (!slot) {
+		if (!list_empty(&ksm_mm_head))
+			next = list_first_entry(&ksm_mm_head,
+						struct ksm_mm_slot, list);
+	} else if (slot->list.next != &ksm_mm_head)
+		next = list_entry(slot->list.next, struct ksm_mm_slot, list);
+	if (dead)
+		list_move(&slot->list, &ksm_dead_slots);
+	ksm_scan_slot = next;
+	spin_unlock(&ksm_mmlist_lock);
+
+	ksm_scan_address = 0;
+	return next;
+}
+
+/*
+ * Scans up to @nr_pages pages, continuing where the previous call stopped,
+ * but stops at the end of a pass.
+ */
+static void ksm_do_scan(unsigned int nr_pages)
+{
+	while (nr_pages) {
+		struct ksm_mm_slot *slot = ksm_scan_slot;
+		struct vm_area_struct *vma;
+		struct mm_struct *mm;
+
+		if (!slot) {
+			/*
+			 * Empty the unstable table before '__ksm_exit()' can
+			 * see that the new pass has not reached a slot yet.
+			 */
+			if (list_empty(&ksm_mm_head))
+				return;
+			ksm_new_pass();
+			slot = ksm_next_slot(NULL, 0);
+			if (!slot)
+				return;
+		}
+		mm = slot->mm;
+
+		if (!atomic_inc_not_zero(&mm->mm_users)) {
+			/* The mm has exited, drop it */
+			if (!ksm_next_slot(slot, 1))
+				return;
+			continue;
+		}
+
+		down_read(&mm->mmap_sem);
+		for (vma = find_vma(mm, ksm_scan_address); vma && nr_pages;
+		     vma = vma->vm_next) {
+			if (!(vma->vm_flags & VM_MERGEABLE) ||
+			    (vma->vm_flags & VM_LOCKED) || !vma->anon_vma)
+				continue;
+			if (ksm_scan_address < vma->vm_start)
+				ksm_scan_address = vma->vm_start;
+
+			while (ksm_scan_address < vma->vm_end && nr_pages) {
+				struct page *page;
+
+				page = follow_page(vma, ksm_scan_address,
+						   FOLL_GET);
+				if (page) {
+					cmp_and_merge_page(vma,
+							   ksm_scan_address,
+							   page);
+					put_page(page);
+				}
+				ksm_scan_address += PAGE_SIZE;
+				nr_pages -= 1;
+				cond_resched();
+			}
+			if (!nr_pages)
+				break;
+		}
+		up_read(&mm->mmap_sem);
+		mmput(mm);
+
+		if (nr_pages) {
+			/* Done with this mm, but never start two passes */
+			if (!ksm_next_slot(slot, 0))
+				return;
+		}
+	}
+}
+
+static int ksmd_should_run(void)
+{
+	return ksm_run && !list_empty(&ksm_mm_head);
+}
+
+static int ksm_scan_thread(void *nothing)
+{
+	set_freezable();
+	set_user_nice(current, 5);
+
+	while (!kthread_should_stop()) {
+		mutex_lock(&ksm_thread_mutex);
+		if (ksmd_should_run())
+			ksm_do_scan(ksm_thread_pages_to_scan);
+		mutex_unlock(&ksm_thread_mutex);
+
+		try_to_freeze();
+
+		if (ksmd_should_run())
+			schedule_timeout_interruptible(
+				msecs_to_jiffies(ksm_thread_sleep_millisecs));
+		else
+			wait_event_freezable(ksm_thread_wait,
+				ksmd_should_run() || kthread_should_stop());
+	}
+	return 0;
+}
+
+/**
+ * __ksm_enter - register a mm for merging.
+ * @mm: the mm
+ *
+ * Called with mmap_sem of @mm held for writing, or from fork() before the mm
+ * is visible to anybody.
+ */
+int __ksm_enter(struct mm_struct *mm)
+{
+	struct ksm_mm_slot *slot;
+
+	slot = kmalloc(sizeof(struct ksm_mm_slot), GFP_KERNEL);
+	if (!slot)
+		return -ENOMEM;
+
+	atomic_inc(&mm->mm_count);
+	slot->mm = mm;
+	spin_lock(&ksm_mmlist_lock);
+	list_add_tail(&slot->list, &ksm_mm_head);
+	spin_unlock(&ksm_mmlist_lock);
+
+	set_bit(MMF_VM_MERGEABLE, &mm->flags);
+	wake_up_interruptible(&ksm_thread_wait);
+	return 0;
+}
+
+/**
+ * __ksm_exit - unregister an exiting mm.
+ * @mm: the mm, whose last user is gone
+ *
+ * Called from mmput(), without waiting for ksmd, which may be allocating
+ * memory the exiting task is to free. The slot of @mm and its reference to
+ * @mm are released right away if ksmd has not scanned @mm in this pass, so
+ * that no unstable table entry refers to it. Otherwise the slot is left for
+ * ksmd to release at the start of its next pass.
+ */
+void __ksm_exit(struct mm_struct *mm)
+{
+	struct ksm_mm_slot *slot;
+	int ahead = 0;
+
+	spin_lock(&ksm_mmlist_lock);
+	list_for_each_entry(slot, &ksm_mm_head, list) {
+		if (slot == ksm_scan_slot)
+			ahead = 1;
+		if (slot->mm == mm)
+			goto found;
+	}
+	spin_unlock(&ksm_mmlist_lock);
+	return;
+
+found:
+	if (slot == ksm_scan_slot) {
+		/* ksmd is on it, and moves it to the dead slots itself */
+		spin_unlock(&ksm_mmlist_lock);
+		return;
+	}
+	if (!ahead) {
+		list_move(&slot->list, &ksm_dead_slots);
+		spin_unlock(&ksm_mmlist_lock);
+		return;
+	}
+	list_del(&slot->list);
+	spin_unlock(&ksm_mmlist_lock);
+
+	mmdrop(mm);
+	kfree(slot);
+}
+
+/*
+ * Gives the task its own copy of the KSM page at @addr, if there is one, by
+ * faking a write fault on it.
+ */
+static int break_ksm(struct vm_area_struct *vma, unsigned long addr)
+{
+	struct page *page;
+	int ret = 0;
+
+	do {
+		cond_resched();
+		page = follow_page(vma, addr, FOLL_GET);
+		if (!page)
+			break;
+		if (PageKsm(page))
+			ret = handle_mm_fault(vma->vm_mm, vma, addr, 1);
+		else
+			ret = VM_FAULT_WRITE;
+		put_page(page);
+	} while (!(ret & (VM_FAULT_WRITE | VM_FAULT_SIGBUS | VM_FAULT_OOM)));
+
+	return (ret & VM_FAULT_OOM) ? -ENOMEM : 0;
+}
+
+static int unmerge_ksm_pages(struct vm_area_struct *vma,
+			     unsigned long start, unsigned long end)
+{
+	unsigned long addr;
+	int err = 0;
+
+	for (addr = start; addr < end && !err; addr += PAGE_SIZE) {
+		if (signal_pending(current))
+			err = -ERESTARTSYS;
+		else
+			err = break_ksm(vma, addr);
+	}
+	return err;
+}
+
+/**
+ * ksm_madvise - handle MADV_MERGEABLE and MADV_UNMERGEABLE.
+ * @vma: the vma
+ * @start: start of the range in @vma
+ * @end: end of the range in @vma
+ * @advice: MADV_MERGEABLE or MADV_UNMERGEABLE
+ * @vm_flags: the new flags of the range, updated by this function
+ *
+ * Areas which cannot hold anonymous pages, or which are special in some
+ * other way, are silently left alone. Unmerging gives the range private
+ * copies of all KSM pages mapped in it. Called with mmap_sem held for
+ * writing.
+ */
+int ksm_madvise(struct vm_area_struct *vma, unsigned long start,
+		unsigned long end, int advice, unsigned long *vm_flags)
+{
+	struct mm_struct *mm = vma->vm_mm;
+	int err;
+
+	switch (advice) {
+	case MADV_MERGEABLE:
+		if (*vm_flags & (VM_MERGEABLE | VM_SHARED | VM_MAYSHARE |
+				 VM_PFNMAP | VM_IO | VM_DONTEXPAND |
+				 VM_RESERVED | VM_HUGETLB | VM_INSERTPAGE |
+				 VM_MIXEDMAP | VM_SAO))
+			return 0;
+
+		if (!test_bit(MMF_VM_MERGEABLE, &mm->flags)) {
+			err = __ksm_enter(mm);
+			if (err)
+				return err;
+		}
+		*vm_flags |= VM_MERGEABLE;
+		break;
+
+	case MADV_UNMERGEABLE:
+		if (!(*vm_flags & VM_MERGEABLE))
+			return 0;
+
+		if (vma->anon_vma) {
+			err = unmerge_ksm_pages(vma, start, end);
+			if (err)
+				return err;
+		}
+		*vm_flags &= ~VM_MERGEABLE;
+		break;
+	}
+	return 0;
+}
+
+#ifdef CONFIG_SYSFS
+#define KSM_ATTR_RO(_name) \
+	static struct kobj_attribute _name##_attr = __ATTR_RO(_name)
+#define KSM_ATTR(_name) \
+	static struct kobj_attribute _name##_attr = \
+		__ATTR(_name, 0644, _name##_show, _name##_store)
+
+static ssize_t sleep_millisecs_show(struct kobject *kobj,
+				    struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", ksm_thread_sleep_millisecs);
+}
+
+static ssize_t sleep_millisecs_store(struct kobject *kobj,
+				     struct kobj_attribute *attr,
+				     const char *buf, size_t count)
+{
+	unsigned long msecs;
+	int err;
+
+	err = strict_strtoul(buf, 10, &msecs);
+	if (err || msecs > UINT_MAX)
+		return -EINVAL;
+
+	ksm_thread_sleep_millisecs = msecs;
+	return count;
+}
+KSM_ATTR(sleep_millisecs);
+
+static ssize_t pages_to_scan_show(struct kobject *kobj,
+				  struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", ksm_thread_pages_to_scan);
+}
+
+static ssize_t pages_to_scan_store(struct kobject *kobj,
+				   struct kobj_attribute *attr,
+				   const char *buf, size_t count)
+{
+	unsigned long nr_pages;
+	int err;
+
+	err = strict_strtoul(buf, 10, &nr_pages);
+	if (err || nr_pages > UINT_MAX)
+		return -EINVAL;
+
+	ksm_thread_pages_to_scan = nr_pages;
+	return count;
+}
+KSM_ATTR(pages_to_scan);
+
+static ssize_t run_show(struct kobject *kobj, struct kobj_attribute *attr,
+			char *buf)
+{
+	return sprintf(buf, "%u\n", ksm_run);
+}
+
+static ssize_t run_store(struct kobject *kobj, struct kobj_attribute *attr,
+			 const char *buf, size_t count)
+{
+	unsigned long flags;
+	int err;
+
+	err = strict_strtoul(buf, 10, &flags);
+	if (err || flags > 1)
+		return -EINVAL;
+
+	mutex_lock(&ksm_thread_mutex);
+	ksm_run = flags;
+	mutex_unlock(&ksm_thread_mutex);
+	if (flags)
+		wake_up_interruptible(&ksm_thread_wait);
+	return count;
+}
+KSM_ATTR(run);
+
+static ssize_t pages_shared_show(struct kobject *kobj,
+				 struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%lu\n", ksm_pages_shared);
+}
+KSM_ATTR_RO(pages_shared);
+
+/* The number of page table entries mapping KSM pages, beyond the first */
+static ssize_t pages_sharing_show(struct kobject *kobj,
+				  struct kobj_attribute *attr, char *buf)
+{
+	struct ksm_stable_item *stable;
+	struct hlist_node *node;
+	unsigned long sharing = 0;
+	int i;
+
+	mutex_lock(&ksm_thread_mutex);
+	for (i = 0; i < KSM_HASH_SIZE; i++)
+		hlist_for_each_entry(stable, node, &ksm_stable_hash[i], hash)
+			if (page_mapcount(stable->kpage) > 1)
+				sharing += page_mapcount(stable->kpage) - 1;
+	mutex_unlock(&ksm_thread_mutex);
+	return sprintf(buf, "%lu\n", sharing);
+}
+KSM_ATTR_RO(pages_sharing);
+
+static ssize_t pages_unshared_show(struct kobject *kobj,
+				   struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%lu\n", ksm_pages_unshared);
+}
+KSM_ATTR_RO(pages_unshared);
+
+static ssize_t full_scans_show(struct kobject *kobj,
+			       struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%lu\n", ksm_full_scans);
+}
+KSM_ATTR_RO(full_scans);
+
+static struct attribute *ksm_attrs[] = {
+	&sleep_millisecs_attr.attr,
+	&pages_to_scan_attr.attr,
+	&run_attr.attr,
+	&pages_shared_attr.attr,
+	&pages_sharing_attr.attr,
+	&pages_unshared_attr.attr,
+	&full_scans_attr.attr,
+	NULL,
+};
+
+static struct attribute_group ksm_attr_group = {
+	.attrs = ksm_attrs,
+	.name = "ksm",
+};
+#endif /* CONFIG_SYSFS */
+
+static int __init ksm_init(void)
+{
+	struct task_struct *ksm_thread;
+	int err;
+
+	ksm_unstable_cache = KMEM_CACHE(ksm_unstable_item, 0);
+	if (!ksm_unstable_cache)
+		return -ENOMEM;
+
+	ksm_thread = kthread_run(ksm_scan_thread, NULL, "ksmd");
+	if (IS_ERR(ksm_thread)) {
+		printk(KERN_ERR "ksm: creating kthread failed\n");
+		err = PTR_ERR(ksm_thread);
+		goto out_free;
+	}
+
+#ifdef CONFIG_SYSFS
+	err = sysfs_create_group(mm_kobj, &ksm_attr_group);
+	if (err) {
+		printk(KERN_ERR "ksm: register sysfs failed\n");
+		kthread_stop(ksm_thread);
+		goto out_free;
+	}
+#endif
+	return 0;
+
+out_free:
+	kmem_cache_destroy(ksm_unstable_cache);
+	return err;
+}
+module_init(ksm_init)
@@ -0,0 +1,211 @@
+/*
+ * mm/mem_notify.c - memory pressure notification device.
+ *
+ * Page reclaim reports how hard it has to work through
+ * 'mem_notify_pressure()', which also checks the zone watermarks, and user
+ * space polls /dev/mem_notify to learn about it before the low memory
+ * killer or the OOM killer have to step in.
+ * A read returns the current level and the time it was entered, e.g.
+ *
+ *	medium 1234.567890123
+ *
+ * The time is CLOCK_MONOTONIC, so user space can tell how late it got the
+ * notification. See Documentation/vm/mem_notify.txt.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/fs.h>
+#include <linux/miscdevice.h>
+#include <linux/poll.h>
+#include <linux/wait.h>
+#include <linux/spinlock.h>
+#include <linux/jiffies.h>
+#include <linux/ktime.h>
+#include <linux/mmzone.h>
+#include <linux/workqueue.h>
+#include <linux/uaccess.h>
+#include <linux/mem_notify.h>
+
+static const char *mem_notify_names[] = {
+	[MEM_PRESSURE_NONE]	= "none",
+	[MEM_PRESSURE_LOW]	= "low",
+	[MEM_PRESSURE_MEDIUM]	= "medium",
+	[MEM_PRESSURE_CRITICAL]	= "critical",
+};
+
+/*
+ * Notifications are at least this many milliseconds apart, except for a rise
+ * to critical, so that pollers are not woken for every reclaim pass. A level
+ * which lasts is notified again after the same time.
+ */
+static unsigned int interval_ms = 1000;
+module_param(interval_ms, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(interval_ms, "Minimum time between two notifications");
+
+static DEFINE_SPINLOCK(mem_notify_lock);
+static DECLARE_WAIT_QUEUE_HEAD(mem_notify_wait);
+static enum mem_pressure mem_notify_level;
+static unsigned long mem_notify_event;	/* bumped on every notification */
+static unsigned long mem_notify_jiffies;
+static ktime_t mem_notify_time;
+
+static void mem_notify_recheck(struct work_struct *work);
+static DECLARE_DELAYED_WORK(mem_notify_work, mem_notify_recheck);
+
+/*
+ * Low once a zone is below pages_low, where kswapd is woken, and medium once
+ * it is below pages_min, where allocations have to reclaim directly.
+ */
+static enum mem_pressure mem_notify_watermarks(void)
+{
+	enum mem_pressure level = MEM_PRESSURE_NONE;
+	struct zone *zone;
+
+	for_each_zone(zone) {
+		if (!populated_zone(zone))
+			continue;
+		if (!zone_watermark_ok(zone, 0, zone->pages_min, 0, 0))
+			return MEM_PRESSURE_MEDIUM;
+		if (!zone_watermark_ok(zone, 0, zone->pages_low, 0, 0))
+			level = MEM_PRESSURE_LOW;
+	}
+	return level;
+}
+
+/*
+ * Must be called with @mem_notify_lock held. Returns the jiffies to wait
+ * before @level may be notified, 0 if it is to be notified now, or -1 if
+ * there is nothing to notify.
+ */
+static long mem_notify_delay(enum mem_pressure level)
+{
+	unsigned long next = mem_notify_jiffies +
+			     msecs_to_jiffies(interval_ms);
+
+	if (level == mem_notify_level && level == MEM_PRESSURE_NONE)
+		return -1;
+	if (level == MEM_PRESSURE_CRITICAL && level > mem_notify_level)
+		return 0;
+	if (time_after_eq(jiffies, next))
+		return 0;
+	/* A level which lasts is notified again by the next reclaim pass */
+	if (level == mem_notify_level)
+		return -1;
+	return next - jiffies;
+}
+
+/**
+ * mem_notify_pressure - report memory pressure.
+ * @reclaim: how hard page reclaim currently has to work
+ *
+ * The level notified is the higher of @reclaim and the level of the zone
+ * watermarks. A change of the level, or the same level again, is notified
+ * once the last notification is older than the notification interval. A
+ * change that comes earlier is checked again at the end of the interval.
+ * Called from page reclaim, in process context.
+ */
+void mem_notify_pressure(enum mem_pressure reclaim)
+{
+	enum mem_pressure level = max(reclaim, mem_notify_watermarks());
+	long delay;
+
+	/* The common case is nothing new, check it without the lock */
+	if (level == mem_notify_level &&
+	    (level == MEM_PRESSURE_NONE ||
+	     time_before(jiffies, mem_notify_jiffies +
+				  msecs_to_jiffies(interval_ms))))
+		return;
+
+	spin_lock(&mem_notify_lock);
+	delay = mem_notify_delay(level);
+	if (delay) {
+		spin_unlock(&mem_notify_lock);
+		if (delay > 0)
+			schedule_delayed_work(&mem_notify_work, delay);
+		return;
+	}
+	mem_notify_level = level;
+	mem_notify_event += 1;
+	mem_notify_jiffies = jiffies;
+	mem_notify_time = ktime_get();
+	spin_unlock(&mem_notify_lock);
+
+	wake_up_interruptible(&mem_notify_wait);
+}
+
+/* Notify a change which came too early, e.g. the end of the pressure */
+static void mem_notify_recheck(struct work_struct *work)
+{
+	mem_notify_pressure(MEM_PRESSURE_NONE);
+}
+
+static int mem_notify_open(struct inode *inode, struct file *file)
+{
+	/* The event counter the opener has seen */
+	spin_lock(&mem_notify_lock);
+	file->private_data = (void *)mem_notify_event;
+	spin_unlock(&mem_notify_lock);
+	return nonseekable_open(inode, file);
+}
+
+static unsigned int mem_notify_poll(struct file *file, poll_table *wait)
+{
+	poll_wait(file, &mem_notify_wait, wait);
+	if ((unsigned long)file->private_data != mem_notify_event)
+		return POLLIN | POLLRDNORM;
+	return 0;
+}
+
+/*
+ * Returns the current level right away, whether it changed or not, and marks
+ * it as seen, so that poll waits for the next notification.
+ */
+static ssize_t mem_notify_read(struct file *file, char __user *buf,
+			       size_t count, loff_t *ppos)
+{
+	char line[40];
+	struct timespec ts;
+	enum mem_pressure level;
+	int len;
+
+	spin_lock(&mem_notify_lock);
+	level = mem_notify_level;
+	ts = ktime_to_timespec(mem_notify_time);
+	file->private_data = (void *)mem_notify_event;
+	spin_unlock(&mem_notify_lock);
+
+	len = snprintf(line, sizeof(line), "%s %lu.%09lu\n",
+		       mem_notify_names[level], (unsigned long)ts.tv_sec,
+		       (unsigned long)ts.tv_nsec);
+	if (count < len)
+		return -EINVAL;
+	if (copy_to_user(buf, line, len))
+		return -EFAULT;
+	return len;
+}
+
+static const struct file_operations mem_notify_fops = {
+	.owner	= THIS_MODULE,
+	.open	= mem_notify_open,
+	.read	= mem_notify_read,
+	.poll	= mem_notify_poll,
+};
+
+static struct miscdevice mem_notify_misc = {
+	.minor	= MISC_DYNAMIC_MINOR,
+	.name	= "mem_notify",
+	.fops	= &mem_notify_fops,
+};
+
+static int __init mem_notify_init(void)
+{
+	int err;
+
+	err = misc_register(&mem_notify_misc);
+	if (err)
+		printk(KERN_ERR "mem_notify: cannot register misc device, "
+		       "error %d\n", err);
+	return err;
+}
+module_init(mem_notify_init);
@@ -52,6 +52,8 @@
 #include <linux/writeback.h>
 #include <linux/memcontrol.h>
 #include <linux/mmu_notifier.h>
+#include <linux/log2.h>
+#include <linux/sysctl.h>
 
 #include <asm/pgalloc.h>
 #include <asm/uaccess.h>
@@ -61,6 +63,7 @@
 
 #include <linux/swapops.h>
 #include <linux/elf.h>
+#include <linux/ksm.h>
 
 #include "internal.h"
 
@@ -1808,7 +1811,7 @@ static int do_wp_page(struct mm_struct *mm, struct vm_area_struct *vma,
 	 * Take out anonymous pages first, anonymous shared vmas are
 	 * not dirty accountable.
 	 */
-	if (PageAnon(old_page)) {
+	if (PageAnon(old_page) && !PageKsm(old_page)) {
 		if (trylock_page(old_page)) {
 			reuse = can_share_swap_page(old_page);
 			unlock_page(old_page);
@@ -2434,6 +2437,107 @@ oom:
 	return VM_FAULT_OOM;
 }
 
+/**
+ * do_set_pte - map a page cache page read-only at @address.
+ * @vma:	vma in which the page is mapped
+ * @address:	user virtual address of the page
+ * @page:	locked and uptodate page cache page, with a reference which
+ *		is handed over to the page table
+ * @pte:	empty page table entry for @address, mapped and locked
+ *
+ * Used by ->map_pages() implementations to map the pages around a fault.
+ */
+void do_set_pte(struct vm_area_struct *vma, unsigned long address,
+		struct page *page, pte_t *pte)
+{
+	pte_t entry;
+
+	flush_icache_page(vma, page);
+	entry = mk_pte(page, vma->vm_page_prot);
+	inc_mm_counter(vma->vm_mm, file_rss);
+	page_add_file_rmap(page);
+	set_pte_at(vma->vm_mm, address, pte, entry);
+
+	/* no need to invalidate: a not-present page won't be cached */
+	update_mmu_cache(vma, address, entry);
+	count_vm_event(FAULTAROUND_MAPPED);
+}
+
+/*
+ * Read faults on file mappings also map up to this many bytes around the
+ * faulting address, as far as the pages are in the page cache already, to
+ * avoid taking one minor fault per page of a mapping which is executed or
+ * read from sequentially. It is a power of two number of pages, no more than
+ * a page table covers; one page disables fault-around.
+ */
+int sysctl_fault_around_bytes = 65536;
+static unsigned long fault_around_pages = 65536 >> PAGE_SHIFT;
+
+int fault_around_bytes_handler(ctl_table *table, int write, struct file *file,
+			       void __user *buffer, size_t *length, loff_t *ppos)
+{
+	unsigned long pages;
+	int ret;
+
+	ret = proc_dointvec_minmax(table, write, file, buffer, length, ppos);
+	if (ret || !write)
+		return ret;
+
+	pages = min_t(unsigned long, sysctl_fault_around_bytes >> PAGE_SHIFT,
+		      PTRS_PER_PTE);
+	pages = pages ? rounddown_pow_of_two(pages) : 1;
+	fault_around_pages = pages;
+	sysctl_fault_around_bytes = pages << PAGE_SHIFT;
+	return 0;
+}
+
+/*
+ * do_fault_around() maps the pages of a fault_around_pages aligned window
+ * around @address which are already in the page cache, through
+ * ->map_pages(). The window is clamped to the vma and to the page table of
+ * @pte, and starts at the first empty pte: only ptes which are none are
+ * filled in.
+ *
+ * Called with the page table lock held and @pte mapped.
+ */
+static void do_fault_around(struct vm_area_struct *vma, unsigned long address,
+		pte_t *pte, pgoff_t pgoff, unsigned int flags)
+{
+	unsigned long start_addr, nr_pages = fault_around_pages;
+	pgoff_t max_pgoff;
+	struct vm_fault vmf;
+	int off;
+
+	start_addr = max(address & ~((nr_pages << PAGE_SHIFT) - 1),
+			 vma->vm_start);
+	off = ((address - start_addr) >> PAGE_SHIFT) & (PTRS_PER_PTE - 1);
+	pte -= off;
+	pgoff -= off;
+
+	/* Stay within this page table, the vma, and the window */
+	max_pgoff = pgoff - ((start_addr >> PAGE_SHIFT) & (PTRS_PER_PTE - 1)) +
+		PTRS_PER_PTE - 1;
+	max_pgoff = min(max_pgoff, vma_pages(vma) + vma->vm_pgoff - 1);
+	max_pgoff = min(max_pgoff, pgoff + nr_pages - 1);
+
+	/* Skip the ptes which are mapped already */
+	while (!pte_none(*pte)) {
+		if (++pgoff > max_pgoff)
+			return;
+		start_addr += PAGE_SIZE;
+		if (start_addr >= vma->vm_end)
+			return;
+		pte++;
+	}
+
+	vmf.virtual_address = (void __user *)start_addr;
+	vmf.pte = pte;
+	vmf.pgoff = pgoff;
+	vmf.max_pgoff = max_pgoff;
+	vmf.flags = flags;
+	vma->vm_ops->map_pages(vma, &vmf);
+}
+
 /*
  * __do_fault() tries to create a new page mapping. It aggressively
  * tries to share with existing pages, but makes a separate copy if
@@ -2462,6 +2566,22 @@ static int __do_fault(struct mm_struct *mm, struct vm_area_struct *vma,
 	int ret;
 	int page_mkwrite = 0;
 
+	/*
+	 * Let a read fault map the neighbouring pages as well, and skip
+	 * ->fault altogether if that mapped the faulting page too.
+	 */
+	if (!(flags & (FAULT_FLAG_WRITE | FAULT_FLAG_NONLINEAR)) &&
+	    vma->vm_ops->map_pages && fault_around_pages > 1) {
+		page_table = pte_offset_map_lock(mm, pmd, address, &ptl);
+		do_fault_around(vma, address, page_table, pgoff, flags);
+		if (!pte_same(*page_table, orig_pte)) {
+			pte_unmap_unlock(page_table, ptl);
+			count_vm_event(FAULTAROUND_HIT);
+			return 0;
+		}
+		pte_unmap_unlock(page_table, ptl);
+	}
+
 	vmf.virtual_address = (void __user *)(address & PAGE_MASK);
 	vmf.pgoff = pgoff;
 	vmf.flags = flags;
@@ -46,6 +46,7 @@
 #include <linux/page-isolation.h>
 #include <linux/page_cgroup.h>
 #include <linux/debugobjects.h>
+#include <linux/prezero.h>
 
 #include <asm/tlbflush.h>
 #include <asm/div64.h>
@@ -120,6 +121,13 @@ static char * const zone_names[MAX_NR_ZONES] = {
 
 int min_free_kbytes = 1024;
 
+/*
+ * Extra memory for the system to try freeing between the min and low
+ * watermarks, so that kswapd starts earlier and bursts of allocations
+ * do not run into direct reclaim.
+ */
+int extra_free_kbytes = 0;
+
 unsigned long __meminitdata nr_kernel_pages;
 unsigned long __meminitdata nr_all_pages;
 static unsigned long __meminitdata dma_reserve;
@@ -1472,6 +1480,12 @@ __alloc_pages_internal(gfp_t gfp_mask, unsigned int order,
 	if (should_fail_alloc_page(gfp_mask, order))
 		return NULL;
 
+	if (order == 0 && (gfp_mask & __GFP_ZERO)) {
+		page = prezero_alloc(gfp_mask);
+		if (page)
+			return page;
+	}
+
 restart:
 	z = zonelist->_zonerefs;  /* the list of zones suitable for gfp_mask */
 
@@ -4259,11 +4273,12 @@ static void setup_per_zone_lowmem_reserve(void)
  * setup_per_zone_pages_min - called when min_free_kbytes changes.
  *
  * Ensures that the pages_{min,low,high} values for each zone are set correctly
- * with respect to min_free_kbytes.
+ * with respect to min_free_kbytes and extra_free_kbytes.
  */
 void setup_per_zone_pages_min(void)
 {
 	unsigned long pages_min = min_free_kbytes >> (PAGE_SHIFT - 10);
+	unsigned long pages_extra = extra_free_kbytes >> (PAGE_SHIFT - 10);
 	unsigned long lowmem_pages = 0;
 	struct zone *zone;
 	unsigned long flags;
@@ -4275,11 +4290,13 @@ void setup_per_zone_pages_min(void)
 	}
 
 	for_each_zone(zone) {
-		u64 tmp;
+		u64 tmp, extra;
 
 		spin_lock_irqsave(&zone->lock, flags);
 		tmp = (u64)pages_min * zone->present_pages;
 		do_div(tmp, lowmem_pages);
+		extra = (u64)pages_extra * zone->present_pages;
+		do_div(extra, lowmem_pages);
 		if (is_highmem(zone)) {
 			/*
 			 * __GFP_HIGH and PF_MEMALLOC allocations usually don't
@@ -4306,8 +4323,12 @@ void setup_per_zone_pages_min(void)
 			zone->pages_min = tmp;
 		}
 
-		zone->pages_low   = zone->pages_min + (tmp >> 2);
-		zone->pages_high  = zone->pages_min + (tmp >> 1);
+		/*
+		 * The extra free memory only moves the kswapd watermarks up,
+		 * pages_min and thus the reserves stay the same.
+		 */
+		zone->pages_low   = zone->pages_min + (tmp >> 2) + extra;
+		zone->pages_high  = zone->pages_min + (tmp >> 1) + extra;
 		setup_zone_migrate_reserve(zone);
 		spin_unlock_irqrestore(&zone->lock, flags);
 	}
@@ -4401,7 +4422,7 @@ module_init(init_per_zone_pages_min)
 /*
  * min_free_kbytes_sysctl_handler - just a wrapper around proc_dointvec() so 
  *	that we can call two helper functions whenever min_free_kbytes
- *	changes.
+ *	or extra_free_kbytes changes.
  */
 int min_free_kbytes_sysctl_handler(ctl_table *table, int write, 
 	struct file *file, void __user *buffer, size_t *length, loff_t *ppos)
@@ -0,0 +1,433 @@
+/*
+ * mm/pagecache_pin.c - pin file ranges into the page cache.
+ *
+ * fadvise(fd, offset, len, POSIX_FADV_PIN) pins a range of a file into the
+ * page cache, for files whose refaults hurt, like the libraries and
+ * framework jars every application maps at start. The range is read in,
+ * and its pages are never evicted until POSIX_FADV_UNPIN.
+ *
+ * Pinning works like SHM_LOCK: page_evictable() says no for pages of pinned
+ * ranges, so vmscan moves them to the unevictable list when it comes across
+ * them, instead of reclaiming them. Pages need not be mapped, and are not
+ * touched when they are pinned; they are culled lazily. Unpinning rescues
+ * the pages of the file from the unevictable list again.
+ *
+ * The pinned file keeps a reference on its path, so that the inode and its
+ * pages are not pruned from the inode cache, and umount fails with EBUSY
+ * instead of freeing the inode under the pins. The pinned ranges of all
+ * files together may not exceed vm.pagecache_pin_kbytes. Pinning needs
+ * CAP_IPC_LOCK.
+ *
+ * /proc/pagecache_pins lists the pinned ranges.
+ * See Documentation/vm/pagecache-pin.txt.
+ */
+
+#include <linux/kernel.h>
+#include <linux/fs.h>
+#include <linux/path.h>
+#include <linux/mm.h>
+#include <linux/pagemap.h>
+#include <linux/pagevec.h>
+#include <linux/swap.h>
+#include <linux/slab.h>
+#include <linux/hash.h>
+#include <linux/spinlock.h>
+#include <linux/mutex.h>
+#include <linux/capability.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+
+#define PIN_HASH_BITS	6
+
+/* A pinned range, in page indexes, both inclusive */
+struct pin_range {
+	struct list_head list;
+	pgoff_t start;
+	pgoff_t end;
+};
+
+/* A file with pinned ranges, which are sorted and do not touch */
+struct pinned_file {
+	struct hlist_node hash;
+	struct list_head list;
+	struct path path;
+	struct inode *inode;
+	struct address_space *mapping;
+	struct list_head ranges;
+};
+
+int pagecache_pin_kbytes;
+
+/*
+ * The pins are looked up from page_evictable() under zone->lru_lock, so
+ * pin_lock is taken with interrupts disabled. Changes are serialized by
+ * pin_mutex, and made with both held, so that holders of pin_mutex can read
+ * the pins without pin_lock.
+ */
+static DEFINE_SPINLOCK(pin_lock);
+static DEFINE_MUTEX(pin_mutex);
+static struct hlist_head pin_hash[1 << PIN_HASH_BITS];
+static LIST_HEAD(pinned_files);
+static unsigned long pinned_pages;
+
+static struct hlist_head *pin_bucket(struct address_space *mapping)
+{
+	return &pin_hash[hash_ptr(mapping, PIN_HASH_BITS)];
+}
+
+static struct pinned_file *find_pinned_file(struct address_space *mapping)
+{
+	struct pinned_file *pf;
+	struct hlist_node *node;
+
+	hlist_for_each_entry(pf, node, pin_bucket(mapping), hash)
+		if (pf->mapping == mapping)
+			return pf;
+	return NULL;
+}
+
+/**
+ * __pagecache_pinned - test whether a page index of a mapping is pinned.
+ * @mapping: the mapping, which has AS_PINNED set
+ * @index: the page index
+ */
+int __pagecache_pinned(struct address_space *mapping, pgoff_t index)
+{
+	struct pinned_file *pf;
+	struct pin_range *r;
+	unsigned long flags;
+	int ret = 0;
+
+	spin_lock_irqsave(&pin_lock, flags);
+	pf = find_pinned_file(mapping);
+	if (pf) {
+		list_for_each_entry(r, &pf->ranges, list) {
+			if (index < r->start)
+				break;
+			if (index <= r->end) {
+				ret = 1;
+				break;
+			}
+		}
+	}
+	spin_unlock_irqrestore(&pin_lock, flags);
+	return ret;
+}
+
+/* Returns how many pages of [start, end] are not pinned yet */
+static unsigned long pin_count_new(struct pinned_file *pf, pgoff_t start,
+				   pgoff_t end)
+{
+	unsigned long nr = end - start + 1;
+	struct pin_range *r;
+
+	list_for_each_entry(r, &pf->ranges, list)
+		if (r->start <= end && r->end >= start)
+			nr -= min(r->end, end) - max(r->start, start) + 1;
+	return nr;
+}
+
+/* Bounds @end by the size of the file, returns 0 if nothing is left */
+static int pin_clamp(struct inode *inode, pgoff_t start, pgoff_t *end)
+{
+	loff_t size = i_size_read(inode);
+	pgoff_t last;
+
+	if (!size)
+		return 0;
+	last = (size - 1) >> PAGE_CACHE_SHIFT;
+	if (start > last)
+		return 0;
+	if (*end > last)
+		*end = last;
+	return 1;
+}
+
+/**
+ * pagecache_pin - pin a range of a file into the page cache.
+ * @file: the file
+ * @start: first page index of the range
+ * @end: last page index of the range, bounded by the size of the file
+ *
+ * Returns -EPERM without CAP_IPC_LOCK and -ENOMEM if the range does not fit
+ * into the budget. The range is read in after it has been pinned.
+ */
+int pagecache_pin(struct file *file, pgoff_t start, pgoff_t end)
+{
+	struct address_space *mapping = file->f_mapping;
+	struct inode *inode = mapping->host;
+	struct pinned_file *pf, *new_pf = NULL;
+	struct pin_range *r, *next, *new;
+	unsigned long nr, flags;
+	int err = 0;
+
+	if (!capable(CAP_IPC_LOCK))
+		return -EPERM;
+	if (!mapping->a_ops->readpage || !S_ISREG(inode->i_mode))
+		return -EINVAL;
+	if (!pin_clamp(inode, start, &end))
+		return 0;
+
+	new = kmalloc(sizeof(*new), GFP_KERNEL);
+	if (!new)
+		return -ENOMEM;
+	new->start = start;
+	new->end = end;
+
+	mutex_lock(&pin_mutex);
+	pf = find_pinned_file(mapping);
+	if (!pf) {
+		new_pf = kmalloc(sizeof(*new_pf), GFP_KERNEL);
+		if (!new_pf) {
+			err = -ENOMEM;
+			goto out;
+		}
+		new_pf->path = file->f_path;
+		path_get(&new_pf->path);
+		new_pf->inode = inode;
+		new_pf->mapping = mapping;
+		INIT_LIST_HEAD(&new_pf->ranges);
+		pf = new_pf;
+	}
+
+	nr = pin_count_new(pf, start, end);
+	if (pinned_pages + nr >
+	    ((unsigned long)pagecache_pin_kbytes >> (PAGE_SHIFT - 10))) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	spin_lock_irqsave(&pin_lock, flags);
+	if (new_pf) {
+		hlist_add_head(&pf->hash, pin_bucket(mapping));
+		list_add_tail(&pf->list, &pinned_files);
+		set_bit(AS_PINNED, &mapping->flags);
+		new_pf = NULL;
+	}
+	/* Swallow the ranges which overlap or touch the new one */
+	list_for_each_entry_safe(r, next, &pf->ranges, list) {
+		if (r->end + 1 < new->start)
+			continue;
+		if (r->start > new->end + 1) {
+			list_add_tail(&new->list, &r->list);
+			new = NULL;
+			break;
+		}
+		new->start = min(new->start, r->start);
+		new->end = max(new->end, r->end);
+		list_del(&r->list);
+		kfree(r);
+	}
+	if (new) {
+		list_add_tail(&new->list, &pf->ranges);
+		new = NULL;
+	}
+	pinned_pages += nr;
+	spin_unlock_irqrestore(&pin_lock, flags);
+
+out:
+	mutex_unlock(&pin_mutex);
+	if (new_pf) {
+		path_put(&new_pf->path);
+		kfree(new_pf);
+	}
+	kfree(new);
+	if (err)
+		return err;
+
+	force_page_cache_readahead(mapping, file, start, end - start + 1);
+	return 0;
+}
+
+/* Drops @pf, which has no ranges left. Called with pin_mutex held. */
+static void unpin_file(struct pinned_file *pf)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&pin_lock, flags);
+	hlist_del(&pf->hash);
+	list_del(&pf->list);
+	clear_bit(AS_PINNED, &pf->mapping->flags);
+	spin_unlock_irqrestore(&pin_lock, flags);
+
+	scan_mapping_unevictable_pages(pf->mapping);
+	path_put(&pf->path);
+	kfree(pf);
+}
+
+/**
+ * pagecache_unpin - unpin a range of a file.
+ * @file: the file
+ * @start: first page index of the range
+ * @end: last page index of the range
+ *
+ * The pages of the range which were culled to the unevictable list are put
+ * back on the normal LRU lists.
+ */
+int pagecache_unpin(struct file *file, pgoff_t start, pgoff_t end)
+{
+	struct address_space *mapping = file->f_mapping;
+	struct pinned_file *pf;
+	struct pin_range *r, *next, *split;
+	unsigned long flags;
+
+	if (!capable(CAP_IPC_LOCK))
+		return -EPERM;
+
+	/* For a range which has to be split in two */
+	split = kmalloc(sizeof(*split), GFP_KERNEL);
+	if (!split)
+		return -ENOMEM;
+
+	mutex_lock(&pin_mutex);
+	pf = find_pinned_file(mapping);
+	if (!pf)
+		goto out;
+
+	/* Ranges may reach beyond the end of a file which shrank */
+	r = list_entry(pf->ranges.prev, struct pin_range, list);
+	if (end > r->end)
+		end = r->end;
+	if (start > end)
+		goto out;
+
+	spin_lock_irqsave(&pin_lock, flags);
+	pinned_pages -= (end - start + 1) - pin_count_new(pf, start, end);
+	list_for_each_entry_safe(r, next, &pf->ranges, list) {
+		if (r->end < start)
+			continue;
+		if (r->start > end)
+			break;
+		if (r->start < start && r->end > end) {
+			split->start = end + 1;
+			split->end = r->end;
+			list_add(&split->list, &r->list);
+			split = NULL;
+			r->end = start - 1;
+		} else if (r->start < start)
+			r->end = start - 1;
+		else if (r->end > end)
+			r->start = end + 1;
+		else {
+			list_del(&r->list);
+			kfree(r);
+		}
+	}
+	spin_unlock_irqrestore(&pin_lock, flags);
+
+	if (list_empty(&pf->ranges))
+		unpin_file(pf);
+	else
+		scan_mapping_unevictable_pages(mapping);
+out:
+	mutex_unlock(&pin_mutex);
+	kfree(split);
+	return 0;
+}
+
+/* Returns how many pages of a range are in the page cache */
+static unsigned long pin_resident(struct address_space *mapping,
+				  struct pin_range *r)
+{
+	struct pagevec pvec;
+	pgoff_t next = r->start;
+	unsigned long nr = 0;
+	int i;
+
+	pagevec_init(&pvec, 0);
+	while (next <= r->end && pagevec_lookup(&pvec, mapping, next,
+						 PAGEVEC_SIZE)) {
+		for (i = 0; i < pagevec_count(&pvec); i++) {
+			struct page *page = pvec.pages[i];
+
+			if (page->index > r->end)
+				break;
+			nr++;
+			next = page->index + 1;
+		}
+		if (i < pagevec_count(&pvec))
+			next = r->end + 1;
+		pagevec_release(&pvec);
+		cond_resched();
+	}
+	return nr;
+}
+
+static int pin_show(struct seq_file *m, void *v)
+{
+	struct pinned_file *pf;
+	struct pin_range *r;
+
+	mutex_lock(&pin_mutex);
+	seq_printf(m, "# budget %d kB, pinned %lu kB\n",
+		   pagecache_pin_kbytes, pinned_pages << (PAGE_SHIFT - 10));
+	seq_printf(m, "# dev ino start nr resident\n");
+	list_for_each_entry(pf, &pinned_files, list) {
+		dev_t dev = pf->inode->i_sb->s_dev;
+
+		list_for_each_entry(r, &pf->ranges, list)
+			seq_printf(m, "%u:%u %lu %lu %lu %lu\n",
+				   MAJOR(dev), MINOR(dev), pf->inode->i_ino,
+				   r->start, r->end - r->start + 1,
+				   pin_resident(pf->mapping, r));
+	}
+	mutex_unlock(&pin_mutex);
+	return 0;
+}
+
+static int pin_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, pin_show, NULL);
+}
+
+/* Writing "clear" unpins everything */
+static ssize_t pin_write(struct file *file, const char __user *buf,
+			 size_t count, loff_t *ppos)
+{
+	struct pinned_file *pf, *next;
+	struct pin_range *r, *rnext;
+	char cmd[8];
+
+	if (!capable(CAP_IPC_LOCK))
+		return -EPERM;
+	if (count > sizeof(cmd) - 1)
+		return -EINVAL;
+	if (copy_from_user(cmd, buf, count))
+		return -EFAULT;
+	cmd[count] = '\0';
+	if (strcmp(strstrip(cmd), "clear"))
+		return -EINVAL;
+
+	mutex_lock(&pin_mutex);
+	list_for_each_entry_safe(pf, next, &pinned_files, list) {
+		unsigned long flags;
+
+		spin_lock_irqsave(&pin_lock, flags);
+		list_for_each_entry_safe(r, rnext, &pf->ranges, list) {
+			pinned_pages -= r->end - r->start + 1;
+			list_del(&r->list);
+			kfree(r);
+		}
+		spin_unlock_irqrestore(&pin_lock, flags);
+		unpin_file(pf);
+	}
+	mutex_unlock(&pin_mutex);
+	return count;
+}
+
+static const struct file_operations proc_pin_operations = {
+	.open		= pin_open,
+	.read		= seq_read,
+	.write		= pin_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init pagecache_pin_init(void)
+{
+	proc_create("pagecache_pins", S_IRUSR | S_IWUSR, NULL,
+		    &proc_pin_operations);
+	return 0;
+}
+module_init(pagecache_pin_init);
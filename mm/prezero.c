@@ -0,0 +1,174 @@
+/*
+ * Pool of pre-zeroed pages.
+ *
+ * Anonymous page faults and __GFP_ZERO allocations have to clear the page
+ * they get, which the faulting task pays for with a memset of a whole page.
+ * Instead, idle CPUs take free pages and zero them in advance, up to
+ * vm.prezero_pages of them. Movable order-0 allocations which want a zeroed
+ * page are served from this pool first, and fall back to the page allocator
+ * and the usual clearing when it is empty.
+ *
+ * The pool only takes pages while the system has plenty of free memory, and
+ * gives them back to the page allocator under memory pressure through a
+ * shrinker. Its size shows up as "PreZeroed" in /proc/meminfo, and the
+ * prezero_* counters in /proc/vmstat tell how well it works.
+ */
+
+#include <linux/mm.h>
+#include <linux/gfp.h>
+#include <linux/highmem.h>
+#include <linux/sched.h>
+#include <linux/spinlock.h>
+#include <linux/swap.h>
+#include <linux/sysctl.h>
+#include <linux/vmstat.h>
+#include <linux/prezero.h>
+#include <linux/init.h>
+
+#include <asm/cacheflush.h>
+
+/* Pages zeroed in one go by an idle CPU, before it checks again */
+#define PREZERO_BATCH	16
+
+int sysctl_prezero_pages = 256;
+
+static LIST_HEAD(prezero_list);
+static DEFINE_SPINLOCK(prezero_lock);
+static unsigned long prezero_count;
+
+/**
+ * prezero_alloc - take a zeroed page from the pool.
+ * @gfp_mask: flags of the allocation
+ *
+ * Returns an order-0 page, zeroed and with one reference, or NULL if the
+ * pool is empty or its pages do not suit @gfp_mask. Pool pages are movable
+ * lowmem pages: they only serve movable allocations, so that unmovable pages
+ * such as page tables are not scattered into movable pageblocks, and none
+ * restricted to DMA zones.
+ */
+struct page *prezero_alloc(gfp_t gfp_mask)
+{
+	struct page *page = NULL;
+	unsigned long flags;
+
+	if (!sysctl_prezero_pages || (gfp_mask & (__GFP_DMA | __GFP_DMA32)))
+		return NULL;
+	if (!page_group_by_mobility_disabled &&
+	    allocflags_to_migratetype(gfp_mask) != MIGRATE_MOVABLE)
+		return NULL;
+
+	if (prezero_count) {
+		spin_lock_irqsave(&prezero_lock, flags);
+		if (!list_empty(&prezero_list)) {
+			page = list_first_entry(&prezero_list, struct page,
+						lru);
+			list_del(&page->lru);
+			prezero_count--;
+		}
+		spin_unlock_irqrestore(&prezero_lock, flags);
+	}
+
+	count_vm_event(page ? PREZERO_HIT : PREZERO_MISS);
+	return page;
+}
+
+/* Gives up to @nr_pages pages of the pool back to the page allocator */
+static unsigned long prezero_drain(unsigned long nr_pages)
+{
+	unsigned long flags, drained = 0;
+	LIST_HEAD(list);
+	struct page *page, *next;
+
+	spin_lock_irqsave(&prezero_lock, flags);
+	while (drained < nr_pages && !list_empty(&prezero_list)) {
+		list_move(prezero_list.next, &list);
+		prezero_count--;
+		drained++;
+	}
+	spin_unlock_irqrestore(&prezero_lock, flags);
+
+	list_for_each_entry_safe(page, next, &list, lru) {
+		list_del(&page->lru);
+		__free_page(page);
+	}
+	count_vm_events(PREZERO_DRAIN, drained);
+	return drained;
+}
+
+/*
+ * The pool should take free pages only while they are plentiful, so that
+ * filling it never causes reclaim.
+ */
+static int prezero_can_fill(void)
+{
+	return prezero_count < sysctl_prezero_pages &&
+		global_page_state(NR_FREE_PAGES) >
+			totalreserve_pages + sysctl_prezero_pages;
+}
+
+/**
+ * prezero_idle - refill the pool from the idle loop.
+ *
+ * Zeroes up to PREZERO_BATCH pages, and returns as soon as the CPU has
+ * something else to do. Called with interrupts enabled.
+ */
+void prezero_idle(void)
+{
+	int batch = PREZERO_BATCH;
+	unsigned long flags;
+
+	while (batch-- && !need_resched() && prezero_can_fill()) {
+		struct page *page;
+
+		page = alloc_page(GFP_NOWAIT | __GFP_NOWARN | __GFP_MOVABLE);
+		if (!page)
+			break;
+		clear_highpage(page);
+		/* The page is mapped at user addresses later */
+		flush_dcache_page(page);
+
+		spin_lock_irqsave(&prezero_lock, flags);
+		list_add(&page->lru, &prezero_list);
+		prezero_count++;
+		spin_unlock_irqrestore(&prezero_lock, flags);
+		count_vm_event(PREZERO_FILL);
+	}
+}
+
+unsigned long prezero_total_pages(void)
+{
+	return prezero_count;
+}
+
+/* Shrinks the pool when the target is lowered */
+int prezero_sysctl_handler(ctl_table *table, int write, struct file *file,
+			   void __user *buffer, size_t *length, loff_t *ppos)
+{
+	int ret;
+
+	ret = proc_dointvec_minmax(table, write, file, buffer, length, ppos);
+	if (ret || !write)
+		return ret;
+	if (prezero_count > sysctl_prezero_pages)
+		prezero_drain(prezero_count - sysctl_prezero_pages);
+	return 0;
+}
+
+static int prezero_shrink(int nr_to_scan, gfp_t gfp_mask)
+{
+	if (nr_to_scan)
+		prezero_drain(nr_to_scan);
+	return prezero_count;
+}
+
+static struct shrinker prezero_shrinker = {
+	.shrink = prezero_shrink,
+	.seeks = 1,		/* nothing is lost by dropping them */
+};
+
+static int __init prezero_init(void)
+{
+	register_shrinker(&prezero_shrinker);
+	return 0;
+}
+module_init(prezero_init)
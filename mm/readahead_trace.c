@@ -0,0 +1,510 @@
+/*
+ * mm/readahead_trace.c - record and replay page cache readahead traces.
+ *
+ * While tracing is enabled, every page which has to be allocated and read
+ * into the page cache of a regular file is recorded, keyed by the device and
+ * inode number of the file. The pages of a file are kept as a sorted array of
+ * non-overlapping extents, so a trace of an application cold start stays
+ * small even though the start-up reads are scattered.
+ *
+ * The trace is read from and loaded back into /proc/readahead_trace, one
+ * extent per line, so it can be saved to persistent storage after the first
+ * start and installed again on the next boot. A program (or its launcher)
+ * then replays it with fadvise(fd, 0, 0, POSIX_FADV_WILLNEED_TRACE), which
+ * submits the recorded extents of the file as one batch of readahead in
+ * ascending offset order, instead of taking one major fault after another.
+ *
+ * See Documentation/vm/readahead-trace.txt.
+ */
+
+#include <linux/kernel.h>
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/pagemap.h>
+#include <linux/slab.h>
+#include <linux/hash.h>
+#include <linux/spinlock.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+
+/* Upper limit of extents recorded for all files together */
+#define RA_TRACE_MAX_EXTENTS	65536
+
+/* Initial size of the extent array of a file */
+#define RA_TRACE_MIN_EXTENTS	8
+
+/* Replay reads gaps of up to this many pages between extents as well */
+#define RA_TRACE_GAP		4
+
+#define RA_TRACE_HASH_BITS	8
+#define RA_TRACE_HASH_SIZE	(1 << RA_TRACE_HASH_BITS)
+
+/* Longest line accepted when a trace is loaded */
+#define RA_TRACE_LINE_MAX	80
+
+struct ra_trace_extent {
+	pgoff_t start;
+	unsigned long nr;
+};
+
+/**
+ * struct ra_trace_file - recorded pages of one file.
+ * @hash: link in the hash table of files
+ * @list: link in the list of all files, in the order they were first seen
+ * @dev: device the file lives on
+ * @ino: inode number of the file
+ * @nr_ext: number of extents in @ext
+ * @max_ext: number of extents @ext has room for
+ * @ext: extents sorted by offset, neither overlapping nor adjacent
+ */
+struct ra_trace_file {
+	struct hlist_node hash;
+	struct list_head list;
+	dev_t dev;
+	unsigned long ino;
+	unsigned int nr_ext;
+	unsigned int max_ext;
+	struct ra_trace_extent *ext;
+};
+
+int ra_trace_enabled __read_mostly;
+
+static DEFINE_SPINLOCK(ra_trace_lock);
+static struct hlist_head ra_trace_hash[RA_TRACE_HASH_SIZE];
+static LIST_HEAD(ra_trace_files);
+static unsigned int ra_trace_nr_files;
+static unsigned int ra_trace_nr_ext;
+static unsigned long ra_trace_dropped;
+
+static struct hlist_head *ra_trace_bucket(dev_t dev, unsigned long ino)
+{
+	return &ra_trace_hash[hash_long(ino ^ dev, RA_TRACE_HASH_BITS)];
+}
+
+/* Must be called with @ra_trace_lock held */
+static struct ra_trace_file *ra_trace_find(dev_t dev, unsigned long ino,
+					   int create)
+{
+	struct hlist_head *head = ra_trace_bucket(dev, ino);
+	struct hlist_node *node;
+	struct ra_trace_file *tf;
+
+	hlist_for_each_entry(tf, node, head, hash)
+		if (tf->ino == ino && tf->dev == dev)
+			return tf;
+
+	if (!create)
+		return NULL;
+
+	tf = kzalloc(sizeof(struct ra_trace_file), GFP_ATOMIC);
+	if (!tf)
+		return NULL;
+	tf->dev = dev;
+	tf->ino = ino;
+	hlist_add_head(&tf->hash, head);
+	list_add_tail(&tf->list, &ra_trace_files);
+	ra_trace_nr_files += 1;
+	return tf;
+}
+
+/* Returns the index of the first extent which ends at or after @offset */
+static unsigned int ext_first_ending(struct ra_trace_file *tf, pgoff_t offset)
+{
+	unsigned int lo = 0, hi = tf->nr_ext;
+
+	while (lo < hi) {
+		unsigned int mid = (lo + hi) / 2;
+
+		if (tf->ext[mid].start + tf->ext[mid].nr < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* Returns the index of the first extent which starts after @offset */
+static unsigned int ext_first_starting(struct ra_trace_file *tf,
+				       pgoff_t offset)
+{
+	unsigned int lo = 0, hi = tf->nr_ext;
+
+	while (lo < hi) {
+		unsigned int mid = (lo + hi) / 2;
+
+		if (tf->ext[mid].start <= offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/*
+ * Adds pages @offset..@offset+@nr-1 to the extents of @tf, merging them with
+ * all extents they overlap or touch. Must be called with @ra_trace_lock held.
+ */
+static void ra_trace_add(struct ra_trace_file *tf, pgoff_t offset,
+			 unsigned long nr)
+{
+	pgoff_t end = offset + nr;
+	unsigned int lo, hi;
+
+	lo = ext_first_ending(tf, offset);
+	hi = ext_first_starting(tf, end);
+
+	if (lo == hi) {
+		/* Nothing to merge with, a new extent is needed */
+		if (ra_trace_nr_ext >= RA_TRACE_MAX_EXTENTS) {
+			ra_trace_dropped += 1;
+			return;
+		}
+		if (tf->nr_ext == tf->max_ext) {
+			unsigned int max = tf->max_ext ? tf->max_ext * 2 :
+					   RA_TRACE_MIN_EXTENTS;
+			struct ra_trace_extent *ext;
+
+			ext = krealloc(tf->ext, max * sizeof(*ext), GFP_ATOMIC);
+			if (!ext) {
+				ra_trace_dropped += 1;
+				return;
+			}
+			tf->ext = ext;
+			tf->max_ext = max;
+		}
+		memmove(&tf->ext[lo + 1], &tf->ext[lo],
+			(tf->nr_ext - lo) * sizeof(struct ra_trace_extent));
+		tf->ext[lo].start = offset;
+		tf->ext[lo].nr = nr;
+		tf->nr_ext += 1;
+		ra_trace_nr_ext += 1;
+		return;
+	}
+
+	/* Extents @lo..@hi-1 overlap or touch the new range, fold them */
+	offset = min(offset, tf->ext[lo].start);
+	end = max(end, tf->ext[hi - 1].start + tf->ext[hi - 1].nr);
+	tf->ext[lo].start = offset;
+	tf->ext[lo].nr = end - offset;
+	if (hi - lo > 1) {
+		memmove(&tf->ext[lo + 1], &tf->ext[hi],
+			(tf->nr_ext - hi) * sizeof(struct ra_trace_extent));
+		tf->nr_ext -= hi - lo - 1;
+		ra_trace_nr_ext -= hi - lo - 1;
+	}
+}
+
+static void ra_trace_insert(dev_t dev, unsigned long ino, pgoff_t offset,
+			    unsigned long nr)
+{
+	struct ra_trace_file *tf;
+
+	spin_lock(&ra_trace_lock);
+	tf = ra_trace_find(dev, ino, 1);
+	if (tf)
+		ra_trace_add(tf, offset, nr);
+	else
+		ra_trace_dropped += 1;
+	spin_unlock(&ra_trace_lock);
+}
+
+/**
+ * __ra_trace_record - record pages read into the page cache.
+ * @mapping: address space of the file
+ * @offset: index of the first page
+ * @nr: number of pages
+ *
+ * This function is called for pages which were not cached and are about to
+ * be read in, either on demand or by readahead. Only regular files are
+ * recorded. Callers use the 'ra_trace_record()' wrapper, which does nothing
+ * unless tracing is enabled.
+ */
+void __ra_trace_record(struct address_space *mapping, pgoff_t offset,
+		       unsigned long nr)
+{
+	struct inode *inode = mapping->host;
+
+	if (!inode || !S_ISREG(inode->i_mode))
+		return;
+
+	ra_trace_insert(inode->i_sb->s_dev, inode->i_ino, offset, nr);
+}
+
+/**
+ * ra_trace_replay - read in the recorded pages of a file.
+ * @filp: file to read
+ * @start: index of the first page to consider
+ * @end: index of the last page to consider (inclusive)
+ *
+ * Submits readahead for all recorded extents of @filp within @start..@end,
+ * in ascending offset order. Extents which are only a few pages apart are
+ * read as one, which gives the I/O scheduler larger requests to work with.
+ * Returns the number of pages submitted for reading, zero if nothing was
+ * recorded for the file, or a negative error code.
+ */
+int ra_trace_replay(struct file *filp, pgoff_t start, pgoff_t end)
+{
+	struct address_space *mapping = filp->f_mapping;
+	struct inode *inode = mapping->host;
+	struct ra_trace_extent *ext = NULL;
+	struct ra_trace_file *tf;
+	unsigned int i, n = 0, cnt = 0;
+	unsigned long budget;
+	int ret = 0;
+
+	if (!mapping->a_ops->readpage)
+		return -EINVAL;
+
+	/*
+	 * Copy the extents out, so that readahead (which may record more pages
+	 * if tracing is enabled) does not run under the lock.
+	 */
+	spin_lock(&ra_trace_lock);
+	while (1) {
+		tf = ra_trace_find(inode->i_sb->s_dev, inode->i_ino, 0);
+		if (!tf || tf->nr_ext <= cnt)
+			break;
+		cnt = tf->nr_ext;
+		spin_unlock(&ra_trace_lock);
+
+		kfree(ext);
+		ext = kmalloc(cnt * sizeof(struct ra_trace_extent), GFP_KERNEL);
+		if (!ext)
+			return -ENOMEM;
+
+		spin_lock(&ra_trace_lock);
+	}
+	if (tf) {
+		i = ext_first_ending(tf, start);
+		for (; i < tf->nr_ext && tf->ext[i].start <= end; i++) {
+			pgoff_t s = max(tf->ext[i].start, start);
+			pgoff_t e = min(tf->ext[i].start + tf->ext[i].nr - 1,
+					end);
+
+			if (s > e)
+				continue;
+			if (n && ext[n - 1].start + ext[n - 1].nr +
+				 RA_TRACE_GAP >= s) {
+				ext[n - 1].nr = e - ext[n - 1].start + 1;
+				continue;
+			}
+			ext[n].start = s;
+			ext[n].nr = e - s + 1;
+			n += 1;
+		}
+	}
+	spin_unlock(&ra_trace_lock);
+
+	budget = max_sane_readahead(ULONG_MAX);
+	for (i = 0; i < n && budget; i++) {
+		unsigned long nr = min(ext[i].nr, budget);
+		int err;
+
+		err = force_page_cache_readahead(mapping, filp, ext[i].start,
+						 nr);
+		if (err < 0) {
+			if (!ret)
+				ret = err;
+			break;
+		}
+		ret += err;
+		budget -= nr;
+	}
+
+	kfree(ext);
+	return ret;
+}
+
+/* Must be called with @ra_trace_lock held */
+static void ra_trace_clear(void)
+{
+	struct ra_trace_file *tf, *tmp;
+
+	list_for_each_entry_safe(tf, tmp, &ra_trace_files, list) {
+		hlist_del(&tf->hash);
+		list_del(&tf->list);
+		kfree(tf->ext);
+		kfree(tf);
+	}
+	ra_trace_nr_files = 0;
+	ra_trace_nr_ext = 0;
+	ra_trace_dropped = 0;
+}
+
+/*
+ * The file shows one extent per line; the position in the sequence is the
+ * number of the extent counted across all files.
+ */
+struct ra_trace_pos {
+	struct ra_trace_file *tf;
+	unsigned int idx;
+};
+
+static void *ra_trace_seek(struct ra_trace_pos *p, loff_t n)
+{
+	struct ra_trace_file *tf;
+
+	list_for_each_entry(tf, &ra_trace_files, list) {
+		if (n < tf->nr_ext) {
+			p->tf = tf;
+			p->idx = n;
+			return p;
+		}
+		n -= tf->nr_ext;
+	}
+	return NULL;
+}
+
+static void *ra_trace_start(struct seq_file *m, loff_t *pos)
+{
+	spin_lock(&ra_trace_lock);
+	if (*pos == 0)
+		return SEQ_START_TOKEN;
+	return ra_trace_seek(m->private, *pos - 1);
+}
+
+static void *ra_trace_next(struct seq_file *m, void *v, loff_t *pos)
+{
+	struct ra_trace_pos *p = m->private;
+
+	++*pos;
+	if (v == SEQ_START_TOKEN)
+		return ra_trace_seek(p, 0);
+	if (++p->idx < p->tf->nr_ext)
+		return p;
+	while (p->tf->list.next != &ra_trace_files) {
+		p->tf = list_entry(p->tf->list.next, struct ra_trace_file,
+				   list);
+		p->idx = 0;
+		if (p->tf->nr_ext)
+			return p;
+	}
+	return NULL;
+}
+
+static void ra_trace_stop(struct seq_file *m, void *v)
+{
+	spin_unlock(&ra_trace_lock);
+}
+
+static int ra_trace_show(struct seq_file *m, void *v)
+{
+	struct ra_trace_pos *p = v;
+	struct ra_trace_extent *ext;
+
+	if (v == SEQ_START_TOKEN) {
+		seq_printf(m, "# enabled %d files %u extents %u dropped %lu\n",
+			   ra_trace_enabled, ra_trace_nr_files,
+			   ra_trace_nr_ext, ra_trace_dropped);
+		seq_puts(m, "# dev ino start nr\n");
+		return 0;
+	}
+
+	ext = &p->tf->ext[p->idx];
+	seq_printf(m, "%u:%u %lu %lu %lu\n", MAJOR(p->tf->dev),
+		   MINOR(p->tf->dev), p->tf->ino, (unsigned long)ext->start,
+		   ext->nr);
+	return 0;
+}
+
+static const struct seq_operations ra_trace_op = {
+	.start	= ra_trace_start,
+	.next	= ra_trace_next,
+	.stop	= ra_trace_stop,
+	.show	= ra_trace_show,
+};
+
+static int ra_trace_open(struct inode *inode, struct file *file)
+{
+	return seq_open_private(file, &ra_trace_op,
+				sizeof(struct ra_trace_pos));
+}
+
+/* Handles one line written to /proc/readahead_trace */
+static int ra_trace_command(char *line)
+{
+	unsigned int major, minor;
+	unsigned long ino, start, nr;
+
+	line = strstrip(line);
+	if (!*line || *line == '#')
+		return 0;
+
+	if (!strcmp(line, "start")) {
+		ra_trace_enabled = 1;
+		return 0;
+	}
+	if (!strcmp(line, "stop")) {
+		ra_trace_enabled = 0;
+		return 0;
+	}
+	if (!strcmp(line, "clear")) {
+		spin_lock(&ra_trace_lock);
+		ra_trace_clear();
+		spin_unlock(&ra_trace_lock);
+		return 0;
+	}
+
+	/* Anything else is an extent of a previously saved trace */
+	if (sscanf(line, "%u:%u %lu %lu %lu", &major, &minor, &ino, &start,
+		   &nr) != 5 || nr == 0 || start + nr < start)
+		return -EINVAL;
+
+	ra_trace_insert(MKDEV(major, minor), ino, start, nr);
+	return 0;
+}
+
+/*
+ * Only whole lines are consumed, so a trace can be loaded with 'cat', which
+ * writes the rest of a short write again.
+ */
+static ssize_t ra_trace_write(struct file *file, const char __user *buf,
+			      size_t count, loff_t *ppos)
+{
+	char line[RA_TRACE_LINE_MAX + 1];
+	size_t done = 0;
+	int err;
+
+	while (done < count) {
+		size_t len = min_t(size_t, count - done, RA_TRACE_LINE_MAX);
+		char *eol;
+
+		if (copy_from_user(line, buf + done, len))
+			return -EFAULT;
+		line[len] = '\0';
+
+		eol = strchr(line, '\n');
+		if (eol)
+			*eol = '\0';
+		else if (done + len < count || len == RA_TRACE_LINE_MAX) {
+			/* Incomplete line, wait for the rest of it */
+			if (done)
+				break;
+			return -EINVAL;
+		}
+
+		err = ra_trace_command(line);
+		if (err)
+			return done ? done : err;
+		done += eol ? eol - line + 1 : len;
+	}
+
+	return done;
+}
+
+static const struct file_operations proc_ra_trace_operations = {
+	.open		= ra_trace_open,
+	.read		= seq_read,
+	.write		= ra_trace_write,
+	.llseek		= seq_lseek,
+	.release	= seq_release_private,
+};
+
+static int __init ra_trace_init(void)
+{
+	proc_create("readahead_trace", S_IRUSR | S_IWUSR, NULL,
+		    &proc_ra_trace_operations);
+	return 0;
+}
+module_init(ra_trace_init);
@@ -50,6 +50,7 @@
 #include <linux/kallsyms.h>
 #include <linux/memcontrol.h>
 #include <linux/mmu_notifier.h>
+#include <linux/ksm.h>
 
 #include <asm/tlbflush.h>
 
@@ -202,6 +203,9 @@ struct anon_vma *page_lock_anon_vma(struct page *page)
 		goto out;
 	if (!page_mapped(page))
 		goto out;
+	/* KSM pages have no anon_vma */
+	if (PageKsm(page))
+		goto out;
 
 	anon_vma = (struct anon_vma *) (anon_mapping - PAGE_MAPPING_ANON);
 	spin_lock(&anon_vma->lock);
@@ -678,6 +682,23 @@ void page_add_file_rmap(struct page *page)
 		__inc_zone_page_state(page, NR_FILE_MAPPED);
 }
 
+#ifdef CONFIG_KSM
+/**
+ * page_add_ksm_rmap - add pte mapping to a KSM page
+ * @page: the page to add the mapping to
+ *
+ * A KSM page is accounted as anonymous, but has no anon_vma, so the
+ * mapping is never looked up through the rmap.
+ *
+ * The caller needs to hold the pte lock.
+ */
+void page_add_ksm_rmap(struct page *page)
+{
+	if (atomic_inc_and_test(&page->_mapcount))
+		__inc_zone_page_state(page, NR_ANON_PAGES);
+}
+#endif
+
 #ifdef CONFIG_DEBUG_VM
 /**
  * page_dup_rmap - duplicate pte mapping to a page
@@ -694,7 +715,7 @@ void page_add_file_rmap(struct page *page)
 void page_dup_rmap(struct page *page, struct vm_area_struct *vma, unsigned long address)
 {
 	BUG_ON(page_mapcount(page) == 0);
-	if (PageAnon(page))
+	if (PageAnon(page) && !PageKsm(page))
 		__page_check_anon_rmap(page, vma, address);
 	atomic_inc(&page->_mapcount);
 }
@@ -25,6 +25,9 @@
 #include <linux/kallsyms.h>
 #include <linux/memory.h>
 #include <linux/math64.h>
+#include <linux/hash.h>
+#include <linux/sort.h>
+#include <linux/vmalloc.h>
 
 /*
  * Lock order:
@@ -1576,6 +1579,172 @@ debug:
 	goto unlock_out;
 }
 
+#ifdef CONFIG_SLUB_PROFILE
+/*
+ * Sampling allocation profiler.
+ *
+ * Writing N to /sys/kernel/slab/<cache>/profile samples one in N allocations
+ * and one in N frees of the cache, and attributes them to their call sites.
+ * Sampled objects are remembered until they are freed, which gives the
+ * lifetime of the objects allocated at each site. All tables are fixed size
+ * and allocated when profiling is first enabled, so the profiler never
+ * allocates memory itself; samples which do not fit are counted as lost.
+ */
+#define PROFILE_SITES_SHIFT	8
+#define PROFILE_OBJECTS_SHIFT	10
+#define PROFILE_PROBES		8
+
+struct profile_site {
+	void *addr;			/* Call site */
+	unsigned long allocs;		/* Sampled allocations from here */
+	unsigned long frees;		/* Sampled frees from here */
+	unsigned long freed;		/* Sampled allocations freed again */
+	u64 lifetime;			/* Total lifetime of those, in ns */
+	u64 max_lifetime;
+};
+
+struct profile_object {
+	const void *object;
+	struct profile_site *site;	/* Where it was allocated */
+	u64 time;			/* When it was allocated */
+};
+
+struct kmem_profile {
+	spinlock_t lock;
+	int alloc_countdown;
+	int free_countdown;
+	unsigned long lost_sites;
+	unsigned long lost_objects;
+	struct profile_site sites[1 << PROFILE_SITES_SHIFT];
+	struct profile_object objects[1 << PROFILE_OBJECTS_SHIFT];
+};
+
+/* Returns the entry for @addr, or NULL if its probe sequence is full */
+static struct profile_site *profile_site(struct kmem_profile *p, void *addr)
+{
+	unsigned long h = hash_ptr(addr, PROFILE_SITES_SHIFT);
+	int i;
+
+	for (i = 0; i < PROFILE_PROBES; i++) {
+		struct profile_site *site;
+
+		site = &p->sites[(h + i) & ((1 << PROFILE_SITES_SHIFT) - 1)];
+		if (site->addr == addr)
+			return site;
+		if (!site->addr) {
+			site->addr = addr;
+			return site;
+		}
+	}
+	p->lost_sites++;
+	return NULL;
+}
+
+static noinline void profile_alloc(struct kmem_cache *s, const void *object,
+				   void *addr)
+{
+	struct kmem_profile *p = s->profile;
+	struct profile_site *site;
+	unsigned long h, flags;
+	int i;
+
+	if (--p->alloc_countdown > 0)
+		return;
+	p->alloc_countdown = s->profile_rate;
+
+	spin_lock_irqsave(&p->lock, flags);
+	site = profile_site(p, addr);
+	if (!site)
+		goto out;
+	site->allocs++;
+
+	h = hash_ptr((void *)object, PROFILE_OBJECTS_SHIFT);
+	for (i = 0; i < PROFILE_PROBES; i++) {
+		struct profile_object *o;
+
+		o = &p->objects[(h + i) & ((1 << PROFILE_OBJECTS_SHIFT) - 1)];
+		if (!o->object) {
+			o->object = object;
+			o->site = site;
+			o->time = sched_clock();
+			goto out;
+		}
+	}
+	p->lost_objects++;
+out:
+	spin_unlock_irqrestore(&p->lock, flags);
+}
+
+static noinline void profile_free(struct kmem_cache *s, const void *object,
+				  void *addr)
+{
+	struct kmem_profile *p = s->profile;
+	struct profile_site *site;
+	unsigned long h, flags;
+	int sample, i;
+
+	sample = --p->free_countdown <= 0;
+	if (sample)
+		p->free_countdown = s->profile_rate;
+
+	/*
+	 * Every free has to look for the object among the sampled ones, but
+	 * that is done without the lock first, which is enough for nearly
+	 * all frees which do not sample.
+	 */
+	h = hash_ptr((void *)object, PROFILE_OBJECTS_SHIFT);
+	for (i = 0; i < PROFILE_PROBES; i++)
+		if (p->objects[(h + i) &
+			       ((1 << PROFILE_OBJECTS_SHIFT) - 1)].object == object)
+			break;
+	if (i == PROFILE_PROBES && !sample)
+		return;
+
+	spin_lock_irqsave(&p->lock, flags);
+	if (sample) {
+		site = profile_site(p, addr);
+		if (site)
+			site->frees++;
+	}
+	for (i = 0; i < PROFILE_PROBES; i++) {
+		struct profile_object *o;
+		u64 lifetime;
+
+		o = &p->objects[(h + i) & ((1 << PROFILE_OBJECTS_SHIFT) - 1)];
+		if (o->object != object)
+			continue;
+
+		lifetime = sched_clock() - o->time;
+		o->site->freed++;
+		o->site->lifetime += lifetime;
+		if (lifetime > o->site->max_lifetime)
+			o->site->max_lifetime = lifetime;
+		o->object = NULL;
+		break;
+	}
+	spin_unlock_irqrestore(&p->lock, flags);
+}
+
+static inline void slab_profile_alloc(struct kmem_cache *s,
+				      const void *object, void *addr)
+{
+	if (unlikely(s->profile_rate) && object)
+		profile_alloc(s, object, addr);
+}
+
+static inline void slab_profile_free(struct kmem_cache *s,
+				     const void *object, void *addr)
+{
+	if (unlikely(s->profile_rate))
+		profile_free(s, object, addr);
+}
+#else
+static inline void slab_profile_alloc(struct kmem_cache *s,
+				      const void *object, void *addr) {}
+static inline void slab_profile_free(struct kmem_cache *s,
+				     const void *object, void *addr) {}
+#endif
+
 /*
  * Inlined fastpath so that allocation functions (kmalloc, kmem_cache_alloc)
  * have the fastpath folded into their functions. So no function call
@@ -1609,6 +1778,8 @@ static __always_inline void *slab_alloc(struct kmem_cache *s,
 	}
 	local_irq_restore(flags);
 
+	slab_profile_alloc(s, object, addr);
+
 	if (unlikely((gfpflags & __GFP_ZERO) && object))
 		memset(object, 0, objsize);
 
@@ -1714,6 +1885,8 @@ static __always_inline void slab_free(struct kmem_cache *s,
 	struct kmem_cache_cpu *c;
 	unsigned long flags;
 
+	slab_profile_free(s, x, addr);
+
 	local_irq_save(flags);
 	c = get_cpu_slab(s, smp_processor_id());
 	debug_check_no_locks_freed(object, c->objsize);
@@ -4068,6 +4241,126 @@ static ssize_t free_calls_show(struct kmem_cache *s, char *buf)
 }
 SLAB_ATTR_RO(free_calls);
 
+#ifdef CONFIG_SLUB_PROFILE
+static DEFINE_MUTEX(profile_mutex);
+
+static ssize_t profile_show(struct kmem_cache *s, char *buf)
+{
+	return sprintf(buf, "%u\n", s->profile_rate);
+}
+
+static ssize_t profile_store(struct kmem_cache *s,
+				const char *buf, size_t length)
+{
+	struct kmem_profile *p;
+	unsigned long rate, flags;
+	int err;
+
+	err = strict_strtoul(buf, 10, &rate);
+	if (err || rate > INT_MAX)
+		return -EINVAL;
+
+	mutex_lock(&profile_mutex);
+	s->profile_rate = 0;
+	if (!rate)
+		goto out;
+
+	p = s->profile;
+	if (!p) {
+		p = vmalloc(sizeof(struct kmem_profile));
+		if (!p) {
+			mutex_unlock(&profile_mutex);
+			return -ENOMEM;
+		}
+		spin_lock_init(&p->lock);
+	}
+
+	/* Start over with empty tables */
+	spin_lock_irqsave(&p->lock, flags);
+	memset(&p->lost_sites, 0, sizeof(struct kmem_profile) -
+			offsetof(struct kmem_profile, lost_sites));
+	p->alloc_countdown = rate;
+	p->free_countdown = rate;
+	spin_unlock_irqrestore(&p->lock, flags);
+
+	s->profile = p;
+	smp_wmb();
+	s->profile_rate = rate;
+out:
+	mutex_unlock(&profile_mutex);
+	return length;
+}
+SLAB_ATTR(profile);
+
+static int cmp_profile_site(const void *a, const void *b)
+{
+	const struct profile_site *x = a, *y = b;
+	unsigned long nx = x->allocs + x->frees;
+	unsigned long ny = y->allocs + y->frees;
+
+	if (nx == ny)
+		return 0;
+	return nx > ny ? -1 : 1;
+}
+
+static ssize_t profile_calls_show(struct kmem_cache *s, char *buf)
+{
+	struct kmem_profile *p;
+	struct profile_site *sites;
+	unsigned long flags, lost_sites, lost_objects;
+	int len = 0;
+	int i;
+
+	mutex_lock(&profile_mutex);
+	p = s->profile;
+	if (!p) {
+		mutex_unlock(&profile_mutex);
+		return -ENODATA;
+	}
+	sites = kmalloc(sizeof(p->sites), GFP_KERNEL);
+	if (!sites) {
+		mutex_unlock(&profile_mutex);
+		return sprintf(buf, "Out of memory\n");
+	}
+	spin_lock_irqsave(&p->lock, flags);
+	memcpy(sites, p->sites, sizeof(p->sites));
+	lost_sites = p->lost_sites;
+	lost_objects = p->lost_objects;
+	spin_unlock_irqrestore(&p->lock, flags);
+	mutex_unlock(&profile_mutex);
+
+	sort(sites, ARRAY_SIZE(p->sites), sizeof(struct profile_site),
+	     cmp_profile_site, NULL);
+
+	for (i = 0; i < ARRAY_SIZE(p->sites) && sites[i].addr; i++) {
+		struct profile_site *site = &sites[i];
+
+		if (len > PAGE_SIZE - KSYM_SYMBOL_LEN - 100)
+			break;
+		len += sprintf(buf + len, "%7lu %7lu ",
+				site->allocs, site->frees);
+		len += sprint_symbol(buf + len, (unsigned long)site->addr);
+		if (site->freed)
+			len += sprintf(buf + len, " life=%llu/%llu",
+				div64_u64(site->lifetime, (u64)site->freed * 1000),
+				div_u64(site->max_lifetime, 1000));
+		if (site->allocs > site->freed)
+			len += sprintf(buf + len, " live=%lu",
+				site->allocs - site->freed);
+		len += sprintf(buf + len, "\n");
+	}
+	if ((lost_sites || lost_objects) && len < PAGE_SIZE - 60)
+		len += sprintf(buf + len, "lost sites=%lu objects=%lu\n",
+				lost_sites, lost_objects);
+
+	kfree(sites);
+	if (!len)
+		len += sprintf(buf, "No data\n");
+	return len;
+}
+SLAB_ATTR_RO(profile_calls);
+#endif
+
 #ifdef CONFIG_NUMA
 static ssize_t remote_node_defrag_ratio_show(struct kmem_cache *s, char *buf)
 {
@@ -4181,6 +4474,10 @@ static struct attribute *slab_attrs[] = {
 #ifdef CONFIG_NUMA
 	&remote_node_defrag_ratio_attr.attr,
 #endif
+#ifdef CONFIG_SLUB_PROFILE
+	&profile_attr.attr,
+	&profile_calls_attr.attr,
+#endif
 #ifdef CONFIG_SLUB_STATS
 	&alloc_fastpath_attr.attr,
 	&alloc_slowpath_attr.attr,
@@ -4250,6 +4547,9 @@ static void kmem_cache_release(struct kobject *kobj)
 {
 	struct kmem_cache *s = to_slab(kobj);
 
+#ifdef CONFIG_SLUB_PROFILE
+	vfree(s->profile);
+#endif
 	kfree(s);
 }
 
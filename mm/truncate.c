@@ -302,6 +302,8 @@ unsigned long __invalidate_mapping_pages(struct address_space *mapping,
 				goto unlock;
 			if (page_mapped(page))
 				goto unlock;
+			if (pagecache_pinned(page))
+				goto unlock;
 			ret += invalidate_complete_page(mapping, page);
 unlock:
 			unlock_page(page);
@@ -40,6 +40,7 @@
 #include <linux/memcontrol.h>
 #include <linux/delayacct.h>
 #include <linux/sysctl.h>
+#include <linux/mem_notify.h>
 
 #include <asm/tlbflush.h>
 #include <asm/div64.h>
@@ -116,6 +117,11 @@ struct scan_control {
  * From 0 .. 100.  Higher means more swappy.
  */
 int vm_swappiness = 60;
+/*
+ * How far kswapd reclaims above pages_high after a direct reclaim, in
+ * fractions of 10,000 of pages_high. 0 disables the boost.
+ */
+int watermark_boost_factor = 15000;
 long vm_total_pages;	/* The total number of pages which the VM controls */
 
 static LIST_HEAD(shrinker_list);
@@ -133,6 +139,9 @@ static DECLARE_RWSEM(shrinker_rwsem);
 void register_shrinker(struct shrinker *shrinker)
 {
 	shrinker->nr = 0;
+	shrinker->nr_calls = 0;
+	shrinker->nr_freed = 0;
+	shrinker->time_ns = 0;
 	down_write(&shrinker_rwsem);
 	list_add_tail(&shrinker->list, &shrinker_list);
 	up_write(&shrinker_rwsem);
@@ -185,7 +194,12 @@ unsigned long shrink_slab(unsigned long scanned, gfp_t gfp_mask,
 	list_for_each_entry(shrinker, &shrinker_list, list) {
 		unsigned long long delta;
 		unsigned long total_scan;
-		unsigned long max_pass = (*shrinker->shrink)(0, gfp_mask);
+		unsigned long max_pass;
+		long batch_size = shrinker->batch ? shrinker->batch :
+						    SHRINK_BATCH;
+		ktime_t start = ktime_get();
+
+		max_pass = (*shrinker->shrink)(0, gfp_mask);
 
 		delta = (4 * scanned) / shrinker->seeks;
 		delta *= max_pass;
@@ -208,8 +222,8 @@ unsigned long shrink_slab(unsigned long scanned, gfp_t gfp_mask,
 		total_scan = shrinker->nr;
 		shrinker->nr = 0;
 
-		while (total_scan >= SHRINK_BATCH) {
-			long this_scan = SHRINK_BATCH;
+		while (total_scan >= batch_size) {
+			long this_scan = batch_size;
 			int shrink_ret;
 			int nr_before;
 
@@ -217,8 +231,11 @@ unsigned long shrink_slab(unsigned long scanned, gfp_t gfp_mask,
 			shrink_ret = (*shrinker->shrink)(this_scan, gfp_mask);
 			if (shrink_ret == -1)
 				break;
-			if (shrink_ret < nr_before)
+			shrinker->nr_calls += 1;
+			if (shrink_ret < nr_before) {
 				ret += nr_before - shrink_ret;
+				shrinker->nr_freed += nr_before - shrink_ret;
+			}
 			count_vm_events(SLABS_SCANNED, this_scan);
 			total_scan -= this_scan;
 
@@ -226,11 +243,81 @@ unsigned long shrink_slab(unsigned long scanned, gfp_t gfp_mask,
 		}
 
 		shrinker->nr += total_scan;
+		/*
+		 * Not synchronized with concurrent shrink_slab() callers, so
+		 * the statistics may lose an update now and then.
+		 */
+		shrinker->time_ns += ktime_to_ns(ktime_sub(ktime_get(), start));
 	}
 	up_read(&shrinker_rwsem);
 	return ret;
 }
 
+#ifdef CONFIG_DEBUG_FS
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+
+/*
+ * debugfs "shrinkers" shows for every registered shrinker how often it was
+ * called to scan objects, how many objects it freed and how much time was
+ * spent in it, including the calls which only query the cache size. Writing
+ * anything to the file resets the statistics.
+ */
+static int shrinker_debug_show(struct seq_file *m, void *v)
+{
+	struct shrinker *shrinker;
+
+	seq_printf(m, "%10s %10s %12s %6s %5s shrinker\n",
+		   "calls", "freed", "time_us", "batch", "seeks");
+	down_read(&shrinker_rwsem);
+	list_for_each_entry(shrinker, &shrinker_list, list)
+		seq_printf(m, "%10lu %10lu %12llu %6d %5d %pF\n",
+			   shrinker->nr_calls, shrinker->nr_freed,
+			   (unsigned long long)div_u64(shrinker->time_ns,
+						       NSEC_PER_USEC),
+			   shrinker->batch ? shrinker->batch : SHRINK_BATCH,
+			   shrinker->seeks, shrinker->shrink);
+	up_read(&shrinker_rwsem);
+	return 0;
+}
+
+static int shrinker_debug_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, shrinker_debug_show, NULL);
+}
+
+static ssize_t shrinker_debug_write(struct file *file, const char __user *buf,
+				    size_t count, loff_t *ppos)
+{
+	struct shrinker *shrinker;
+
+	down_read(&shrinker_rwsem);
+	list_for_each_entry(shrinker, &shrinker_list, list) {
+		shrinker->nr_calls = 0;
+		shrinker->nr_freed = 0;
+		shrinker->time_ns = 0;
+	}
+	up_read(&shrinker_rwsem);
+	return count;
+}
+
+static const struct file_operations shrinker_debug_fops = {
+	.open		= shrinker_debug_open,
+	.read		= seq_read,
+	.write		= shrinker_debug_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init shrinker_debug_init(void)
+{
+	debugfs_create_file("shrinkers", 0644, NULL, NULL,
+			    &shrinker_debug_fops);
+	return 0;
+}
+late_initcall(shrinker_debug_init);
+#endif
+
 /* Called without lock on whether page is mapped, so answer is unstable */
 static inline int page_mapping_inuse(struct page *page)
 {
@@ -1530,6 +1617,18 @@ static unsigned long shrink_zones(int priority, struct zonelist *zonelist,
 	return nr_reclaimed;
 }
 
+/* Charges the direct reclaim which started at @start to the current task */
+static void account_reclaim_stall(ktime_t start)
+{
+	struct reclaim_stall *stall = &current->reclaim_stall;
+	u64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	stall->count += 1;
+	stall->total_ns += ns;
+	if (ns > stall->max_ns)
+		stall->max_ns = ns;
+}
+
 /*
  * This is the main entry point to direct page reclaim.
  *
@@ -1558,6 +1657,7 @@ static unsigned long do_try_to_free_pages(struct zonelist *zonelist,
 	struct zoneref *z;
 	struct zone *zone;
 	enum zone_type high_zoneidx = gfp_zone(sc->gfp_mask);
+	ktime_t start = ktime_get();
 
 	delayacct_freepages_start();
 
@@ -1580,6 +1680,10 @@ static unsigned long do_try_to_free_pages(struct zonelist *zonelist,
 		sc->nr_scanned = 0;
 		if (!priority)
 			disable_swap_token();
+		if (scan_global_lru(sc))
+			mem_notify_pressure(priority >= DEF_PRIORITY - 2 ?
+					    MEM_PRESSURE_MEDIUM :
+					    MEM_PRESSURE_CRITICAL);
 		nr_reclaimed += shrink_zones(priority, zonelist, sc);
 		/*
 		 * Don't shrink slabs when reclaiming memory from
@@ -1641,10 +1745,42 @@ out:
 		mem_cgroup_record_reclaim_priority(sc->mem_cgroup, priority);
 
 	delayacct_freepages_end();
+	account_reclaim_stall(start);
 
 	return ret;
 }
 
+/*
+ * A direct reclaim means kswapd did not keep up with the allocations. Make it
+ * reclaim further above the watermarks of the zones which were reclaimed, so
+ * that the next burst of allocations is served from free memory.
+ */
+static void boost_watermarks(struct zonelist *zonelist, gfp_t gfp_mask,
+			     int order)
+{
+	enum zone_type high_zoneidx = gfp_zone(gfp_mask);
+	struct zoneref *z;
+	struct zone *zone;
+
+	if (!watermark_boost_factor)
+		return;
+
+	for_each_zone_zonelist(zone, z, zonelist, high_zoneidx) {
+		unsigned long boost;
+
+		if (!cpuset_zone_allowed_hardwall(zone, GFP_KERNEL))
+			continue;
+
+		boost = div_u64((u64)zone->pages_high * watermark_boost_factor,
+				10000);
+		if (boost <= zone->watermark_boost)
+			continue;
+		zone->watermark_boost = boost;
+		count_vm_event(KSWAPD_BOOST);
+		wakeup_kswapd(zone, order);
+	}
+}
+
 unsigned long try_to_free_pages(struct zonelist *zonelist, int order,
 								gfp_t gfp_mask)
 {
@@ -1658,8 +1794,11 @@ unsigned long try_to_free_pages(struct zonelist *zonelist, int order,
 		.mem_cgroup = NULL,
 		.isolate_pages = isolate_pages_global,
 	};
+	unsigned long nr_reclaimed;
 
-	return do_try_to_free_pages(zonelist, &sc);
+	nr_reclaimed = do_try_to_free_pages(zonelist, &sc);
+	boost_watermarks(zonelist, gfp_mask, order);
+	return nr_reclaimed;
 }
 
 #ifdef CONFIG_CGROUP_MEM_RES_CTLR
@@ -1687,7 +1826,7 @@ unsigned long try_to_free_mem_cgroup_pages(struct mem_cgroup *mem_cont,
 
 /*
  * For kswapd, balance_pgdat() will work across all this node's zones until
- * they are all at pages_high.
+ * they are all at pages_high, plus the watermark boost after direct reclaim.
  *
  * Returns the number of pages which were actually freed.
  *
@@ -1770,8 +1909,9 @@ loop_again:
 				shrink_active_list(SWAP_CLUSTER_MAX, zone,
 							&sc, priority, 0);
 
-			if (!zone_watermark_ok(zone, order, zone->pages_high,
-					       0, 0)) {
+			if (!zone_watermark_ok(zone, order,
+					zone->pages_high + zone->watermark_boost,
+					0, 0)) {
 				end_zone = i;
 				break;
 			}
@@ -1779,6 +1919,9 @@ loop_again:
 		if (i < 0)
 			goto out;
 
+		mem_notify_pressure(priority >= DEF_PRIORITY - 2 ?
+				    MEM_PRESSURE_NONE : MEM_PRESSURE_MEDIUM);
+
 		for (i = 0; i <= end_zone; i++) {
 			struct zone *zone = pgdat->node_zones + i;
 
@@ -1805,8 +1948,9 @@ loop_again:
 					priority != DEF_PRIORITY)
 				continue;
 
-			if (!zone_watermark_ok(zone, order, zone->pages_high,
-					       end_zone, 0))
+			if (!zone_watermark_ok(zone, order,
+					zone->pages_high + zone->watermark_boost,
+					end_zone, 0))
 				all_zones_ok = 0;
 			temp_priority[i] = priority;
 			sc.nr_scanned = 0;
@@ -1866,6 +2010,21 @@ out:
 		struct zone *zone = pgdat->node_zones + i;
 
 		zone->prev_priority = temp_priority[i];
+		/*
+		 * The boost is one-shot: once kswapd brought the zone up to
+		 * it, or cannot reclaim from the zone at all, drop it. A
+		 * boost not met is halved after each pass, so that kswapd
+		 * does not keep reclaiming for a target it can't reach.
+		 */
+		if (!zone->watermark_boost)
+			continue;
+		if (zone_is_all_unreclaimable(zone) ||
+		    zone_watermark_ok(zone, order,
+				zone->pages_high + zone->watermark_boost,
+				0, 0))
+			zone->watermark_boost = 0;
+		else
+			zone->watermark_boost >>= 1;
 	}
 	if (!all_zones_ok) {
 		cond_resched();
@@ -1874,6 +2033,7 @@ out:
 
 		goto loop_again;
 	}
+	mem_notify_pressure(MEM_PRESSURE_NONE);
 
 	return nr_reclaimed;
 }
@@ -1963,7 +2123,8 @@ void wakeup_kswapd(struct zone *zone, int order)
 		return;
 
 	pgdat = zone->zone_pgdat;
-	if (zone_watermark_ok(zone, order, zone->pages_low, 0, 0))
+	if (zone_watermark_ok(zone, order,
+			      zone->pages_low + zone->watermark_boost, 0, 0))
 		return;
 	if (pgdat->kswapd_max_order < order)
 		pgdat->kswapd_max_order = order;
@@ -2357,6 +2518,7 @@ int zone_reclaim(struct zone *zone, gfp_t gfp_mask, unsigned int order)
  * Reasons page might not be evictable:
  * (1) page's mapping marked unevictable
  * (2) page is part of an mlocked VMA
+ * (3) page is in a file range pinned with POSIX_FADV_PIN
  *
  */
 int page_evictable(struct page *page, struct vm_area_struct *vma)
@@ -2365,6 +2527,9 @@ int page_evictable(struct page *page, struct vm_area_struct *vma)
 	if (mapping_unevictable(page_mapping(page)))
 		return 0;
 
+	if (pagecache_pinned(page))
+		return 0;
+
 	if (PageMlocked(page) || (vma && is_mlocked_vma(vma, page)))
 		return 0;
 
@@ -687,6 +687,8 @@ static const char * const vmstat_text[] = {
 
 	"pgfault",
 	"pgmajfault",
+	"faultaround_mapped",
+	"faultaround_hit",
 
 	TEXTS_FOR_ZONES("pgrefill")
 	TEXTS_FOR_ZONES("pgsteal")
@@ -699,6 +701,7 @@ static const char * const vmstat_text[] = {
 	"kswapd_inodesteal",
 	"pageoutrun",
 	"allocstall",
+	"kswapd_boost",
 
 	"pgrotated",
 #ifdef CONFIG_HUGETLB_PAGE
@@ -715,6 +718,12 @@ static const char * const vmstat_text[] = {
 	"unevictable_pgs_stranded",
 	"unevictable_pgs_mlockfreed",
 #endif
+#ifdef CONFIG_PREZERO_PAGES
+	"prezero_fill",
+	"prezero_hit",
+	"prezero_miss",
+	"prezero_drain",
+#endif
 #endif
 };
 
@@ -728,6 +737,7 @@ static void zoneinfo_show_print(struct seq_file *m, pg_data_t *pgdat,
 		   "\n        min      %lu"
 		   "\n        low      %lu"
 		   "\n        high     %lu"
+		   "\n        boost    %lu"
 		   "\n        scanned  %lu (aa: %lu ia: %lu af: %lu if: %lu)"
 		   "\n        spanned  %lu"
 		   "\n        present  %lu",
@@ -735,6 +745,7 @@ static void zoneinfo_show_print(struct seq_file *m, pg_data_t *pgdat,
 		   zone->pages_min,
 		   zone->pages_low,
 		   zone->pages_high,
+		   zone->watermark_boost,
 		   zone->pages_scanned,
 		   zone->lru[LRU_ACTIVE_ANON].nr_scan,
 		   zone->lru[LRU_INACTIVE_ANON].nr_scan,